@@ -10,51 +10,104 @@
 #include <limits>
 #include <random>
 #include <unordered_set>
+#include <unordered_map>
 #include <cassert>
 #include <sstream>
+#include <algorithm>
+#include <climits>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <cstdint>
+#include <type_traits>
+#include <set>
+#include <tuple>
+#include <iomanip>
+#include <deque>
+#include <cstring>
+#include <cerrno>
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <intrin.h>
+#ifndef ENABLE_VIRTUAL_TERMINAL_PROCESSING
+#define ENABLE_VIRTUAL_TERMINAL_PROCESSING 0x0004
+#endif
+#else
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#endif
 
 using namespace std;
-mutex mtx;
 struct ClearAndIgnore {}; // Custom struct to help clear any error inputs.
 
 
 
-// Base cell class
-template <typename T>
+// Base cell class. Uses CRTP so every call is resolved at compile time and the grid can store each cell's state by value.
+// A new cell type derives from CellBase<NewCell, StateType> and hides whichever functions it wants to change.
+template <typename Derived, typename T>
 class CellBase
 {
 
 	public:
-		virtual ~CellBase() = default; // Virtual Destructor for cleanup.
+		using State = T;
+
+		// Returns whether a cell in this state is alive.
+		static bool isAlive(State status) { return status != State(); }
+
+		// Returns the state of a newly set live or dead cell.
+		static State makeState(bool alive) { return alive ? State(1) : State(); }
+
+		// Returns the next state once the rule has decided whether the cell lives. Lets cells carry extra data such as age.
+		static State nextState(State /*status*/, bool alive) { return Derived::makeState(alive); }
 
-		virtual bool isAlive() const = 0;
-		virtual void setAlive(T status) = 0;
-		virtual char getIcon() const = 0;
+		// Returns a 'O' if the cell is alive, ' ' if the cell is dead.
+		static char getIcon(State status) { return Derived::isAlive(status) ? 'O' : ' '; }
 };
 
 // Class for a normal cell
 template <typename T>
-class NormalCell : public CellBase<T>
+class NormalCell : public CellBase<NormalCell<T>, T>
 {
+};
 
-	private:
-		T status;
-	public:
-
-		NormalCell(T status) : status(status) {}
-
-		bool isAlive() const override { return status; }
-
-		void setAlive(T status) override { this->status = status; }
+// Class for a cell that counts how many generations it has been alive. Shows 'o' when newly born and 'O' once it has survived.
+template <typename T>
+class AgingCell : public CellBase<AgingCell<T>, T>
+{
 
-		// Returns a 'O' if the cell is alive, ' ' if the cell is dead.
-		char getIcon() const override
+	public:
+		static T nextState(T status, bool alive)
 		{
-			return status ? 'O' : ' ';
+			if (!alive)
+			{
+				return T();
+			}
+			return status < numeric_limits<T>::max() ? T(status + 1) : status;
 		}
 
+		static char getIcon(T status)
+		{
+			if (status == T())
+			{
+				return ' ';
+			}
+			return status == T(1) ? 'o' : 'O';
+		}
 };
 
+const int LEGACY_SCATTER = 1; // random places drawn until enough dead ones are found. Used for .csv files saved without a sampler version
+const int SCATTER_VERSION = 2; // shuffle of every cell keyed by the seed. Written with new .csv files
+
 // Class to store csv data in after being read for a .csv file
 class CSVData
 {
@@ -65,9 +118,10 @@ class CSVData
 		unsigned int seed;
 		int totalCells;
 		int totalCycles;
+		int scatterVersion;
 	public:
-		CSVData(int xSpaces, int ySpaces, unsigned int seed,  int totalCycles, int totalCells)
-			: xSpaces(xSpaces), ySpaces(ySpaces), seed(seed), totalCycles(totalCycles), totalCells(totalCells) {}
+		CSVData(int xSpaces, int ySpaces, unsigned int seed,  int totalCycles, int totalCells, int scatterVersion = LEGACY_SCATTER)
+			: xSpaces(xSpaces), ySpaces(ySpaces), seed(seed), totalCycles(totalCycles), totalCells(totalCells), scatterVersion(scatterVersion) {}
 
 		// Get functions
 		int getXSpaces() const { return xSpaces; }
@@ -75,1361 +129,8875 @@ class CSVData
 		unsigned int getSeed() const { return seed; }
 		int getTotalCycles() const { return totalCycles; }
 		int getTotalCells() const { return totalCells; }
+		int getScatterVersion() const { return scatterVersion; }
 
 		
 };
 
-// Creates a Template for to enhance code conciseness.
-template <typename T>
-using Grid = vector<vector<CellBase<T>*>>;
+template <typename T, typename Cell>
+class GridView;
+
+// Grid of cells. Each cell's state is stored by value in one contiguous block, row by row, and its behaviour comes from the Cell policy.
+// A grid is the only owner of its cells, so it can be moved but not copied. clone makes a deep copy where one is really wanted,
+// and code that only reads the cells takes a GridView.
+template <typename T, typename Cell = NormalCell<T>>
+class Grid
+{
+
+	public:
+		using State = typename Cell::State;
+		// bool states are kept as bytes so threads can write neighbouring cells at the same time.
+		using Storage = typename conditional<is_same<State, bool>::value, unsigned char, State>::type;
+
+	private:
+		int rows;
+		int cols;
+		vector<Storage> cells;
+	public:
+		Grid() : rows(0), cols(0) {}
+
+		Grid(int rows, int cols)
+			: rows(rows), cols(cols), cells(static_cast<size_t>(rows) * cols, Storage(Cell::makeState(false))) {}
+
+		Grid(const Grid&) = delete;
+		Grid& operator=(const Grid&) = delete;
+
+		Grid(Grid&& other) noexcept : rows(other.rows), cols(other.cols), cells(move(other.cells))
+		{
+			other.rows = 0;
+			other.cols = 0;
+		}
+
+		Grid& operator=(Grid&& other) noexcept
+		{
+			Grid moved(move(other));
+			swap(moved);
+			return *this;
+		}
+
+		// Returns a deep copy of the grid.
+		Grid clone() const
+		{
+			Grid copy;
+			copy.rows = rows;
+			copy.cols = cols;
+			copy.cells = cells;
+			return copy;
+		}
+
+		// Returns a read-only view of the cells. It is only valid while the grid is alive and not resized.
+		GridView<T, Cell> view() const { return GridView<T, Cell>(rows, cols, cells.data()); }
+
+		// Get functions
+		int getRows() const { return rows; }
+		int getCols() const { return cols; }
+		bool empty() const { return cells.empty(); }
+
+		bool isAlive(int x, int y) const { return Cell::isAlive(State(cells[static_cast<size_t>(x) * cols + y])); }
+		State getState(int x, int y) const { return State(cells[static_cast<size_t>(x) * cols + y]); }
+		char getIcon(int x, int y) const { return Cell::getIcon(getState(x, y)); }
+
+		// Returns a pointer to the first cell of row x.
+		Storage* getRow(int x) { return cells.data() + static_cast<size_t>(x) * cols; }
+		const Storage* getRow(int x) const { return cells.data() + static_cast<size_t>(x) * cols; }
+
+		// Set functions
+		void setAlive(int x, int y, bool alive) { cells[static_cast<size_t>(x) * cols + y] = Storage(Cell::makeState(alive)); }
+		void setState(int x, int y, State status) { cells[static_cast<size_t>(x) * cols + y] = Storage(status); }
+
+		// Sets every cell to dead without reallocating.
+		void clear() { fill(cells.begin(), cells.end(), Storage(Cell::makeState(false))); }
+
+		// Changes the size of the grid and sets every cell to dead. Memory is only allocated if the grid grows past what it has held before.
+		void reset(int newRows, int newCols)
+		{
+			rows = newRows;
+			cols = newCols;
+			cells.assign(static_cast<size_t>(rows) * cols, Storage(Cell::makeState(false)));
+		}
+
+		void swap(Grid& other)
+		{
+			std::swap(rows, other.rows);
+			std::swap(cols, other.cols);
+			cells.swap(other.cells);
+		}
+};
+
+// Read-only view of the cells of a grid. It does not own them, so it is cheap to pass by value and can never free or change them.
+template <typename T, typename Cell = NormalCell<T>>
+class GridView
+{
+
+	public:
+		using State = typename Grid<T, Cell>::State;
+		using Storage = typename Grid<T, Cell>::Storage;
+
+	private:
+		int rows;
+		int cols;
+		const Storage* cells;
+	public:
+		GridView() : rows(0), cols(0), cells(nullptr) {}
+
+		GridView(int rows, int cols, const Storage* cells) : rows(rows), cols(cols), cells(cells) {}
+
+		// Get functions
+		int getRows() const { return rows; }
+		int getCols() const { return cols; }
+		bool empty() const { return rows == 0 || cols == 0; }
+
+		bool isAlive(int x, int y) const { return Cell::isAlive(State(cells[static_cast<size_t>(x) * cols + y])); }
+		State getState(int x, int y) const { return State(cells[static_cast<size_t>(x) * cols + y]); }
+		char getIcon(int x, int y) const { return Cell::getIcon(getState(x, y)); }
+
+		// Returns a pointer to the first cell of row x.
+		const Storage* getRow(int x) const { return cells + static_cast<size_t>(x) * cols; }
+};
+
+// Large grids must never be copied by accident.
+static_assert(!is_copy_constructible<Grid<bool>>::value && !is_copy_assignable<Grid<bool>>::value, "grids are move-only, use clone to copy one");
+static_assert(is_nothrow_move_constructible<Grid<bool>>::value, "moving a grid must not copy its cells");
 
 // Operator overide of << to print the grid of cells.
-template <typename T>
-ostream& operator << (ostream& os, const Grid<T>& grid)
+template <typename T, typename Cell>
+ostream& operator << (ostream& os, GridView<T, Cell> grid)
 {
 	os << "-------------------------------------------------------------------------------" << endl;
-	for (const auto& row : grid)
+	for (int x = 0; x < grid.getRows(); ++x)
 	{
-		for (const auto& cell : row)
+		for (int y = 0; y < grid.getCols(); ++y)
 		{
-			if (cell)
-			{
-				os << "." << cell->getIcon();
-			}
-			else
-			{
-				os << "X"; // print empty for null pointers.
-			}
+			os << "." << grid.getIcon(x, y);
 		}
 		os << "." << endl;
 	}
 	return os;
 }
 
-// Operator override of >> to clean the input stream.
-istream& operator >> (istream& in, ClearAndIgnore)
+// Prints a grid through a view of its cells.
+template <typename T, typename Cell>
+ostream& operator << (ostream& os, const Grid<T, Cell>& grid)
 {
-	in.clear();
-	in.ignore(numeric_limits<streamsize>::max(), '\n');
-	return in;
+	return os << grid.view();
 }
 
-// Function to check whether the input is valid or not.
-bool isValidInput(int input)
+// Returns the rows and columns of the terminal, or 24 x 80 if the output is not a terminal.
+void terminalSize(int& rows, int& cols)
 {
-	if (cin.fail() || input <= 0)
+	rows = 24;
+	cols = 80;
+#ifdef _WIN32
+	CONSOLE_SCREEN_BUFFER_INFO info;
+	if (GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &info))
 	{
-		cout << endl << "Error: Invalid Input. Please enter a positive number.";
-		cin >> ClearAndIgnore();
-		return false;
+		rows = info.srWindow.Bottom - info.srWindow.Top + 1;
+		cols = info.srWindow.Right - info.srWindow.Left + 1;
 	}
-	return true;
+#else
+	winsize size;
+	if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_row > 0 && size.ws_col > 0)
+	{
+		rows = size.ws_row;
+		cols = size.ws_col;
+	}
+#endif
 }
 
-// Creates an empty 2D vector to use as a grid. Can be generated with user inputs or by int pointers.
-template <typename T>
-Grid<T> generateGrid(int* xSizePointer, int* ySizePointer)
+// Draws generations of a grid in place on an ANSI terminal. The cells on screen are remembered, so after the first frame only the cells
+// that changed are written, each run of them after one cursor move. Only a viewport of the grid the size of the terminal is shown,
+// and it can be scrolled anywhere in grids far larger than the screen. The layout matches the full frames, ".O. ." with a dot between cells.
+class TerminalRenderer
 {
-	int xSpaces;
-	int ySpaces;
 
-	if (xSizePointer == nullptr || ySizePointer == nullptr)
-	{
-		bool allowedInput = false;
-		while (!allowedInput) {
+	private:
+		ostream& os;
+		int viewTop;
+		int viewLeft;
+		int viewRows;
+		int viewCols;
+		int shownRows; // size of the area on screen, 0 before the first frame
+		int shownCols;
+		vector<char> shown; // icons on screen
+		string buffer;
+		size_t bytesWritten;
+
+		// Adds a cursor move to the 1-based row and column.
+		void moveTo(int row, int col)
+		{
+			buffer += "\x1b[" + to_string(row) + ";" + to_string(col) + "H";
+		}
 
-			cout << endl << "Enter number of spaces on the X Axis: ";
-			cin >> xSpaces;
+	public:
+		// A viewport of 0 rows or columns is sized to fit the terminal.
+		TerminalRenderer(ostream& os, int top = 0, int left = 0, int rows = 0, int cols = 0)
+			: os(os), viewTop(top), viewLeft(left), viewRows(rows), viewCols(cols), shownRows(0), shownCols(0), bytesWritten(0)
+		{
+			int terminalRows;
+			int terminalCols;
+			terminalSize(terminalRows, terminalCols);
+			if (viewRows <= 0)
+			{
+				viewRows = max(1, terminalRows - 2);
+			}
+			if (viewCols <= 0)
+			{
+				viewCols = max(1, (terminalCols - 1) / 2);
+			}
+#ifdef _WIN32
+			// Windows consoles only follow escape sequences once asked to
+			HANDLE output = GetStdHandle(STD_OUTPUT_HANDLE);
+			DWORD mode;
+			if (GetConsoleMode(output, &mode))
+			{
+				SetConsoleMode(output, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+			}
+#endif
+		}
 
-			if (isValidInput(xSpaces)) {
+		// Get functions
+		int getViewTop() const { return viewTop; }
+		int getViewLeft() const { return viewLeft; }
+		int getViewRows() const { return viewRows; }
+		int getViewCols() const { return viewCols; }
+		size_t getBytesWritten() const { return bytesWritten; }
+
+		// Set functions
+		void scrollTo(int top, int left)
+		{
+			viewTop = max(0, top);
+			viewLeft = max(0, left);
+		}
 
-				cout << endl << "Enter number of spaces on the Y Axis: ";
-				cin >> ySpaces;
-				
-				if (isValidInput(ySpaces))
+		// Draws rows x cols icons, iconAt(x, y) giving each one, with a status line under them. Only the icons that differ from the screen are
+		// written unless the size changed.
+		template <typename IconAt>
+		void drawIcons(int rows, int cols, IconAt iconAt, const string& status)
+		{
+			buffer.clear();
+			if (rows != shownRows || cols != shownCols)
+			{
+				// The first frame, or one of another size, clears the screen and draws every cell
+				buffer += "\x1b[2J";
+				shown.assign(static_cast<size_t>(rows) * cols, ' ');
+				for (int x = 0; x < rows; ++x)
 				{
-					allowedInput = true;
+					moveTo(x + 1, 1);
+					for (int y = 0; y < cols; ++y)
+					{
+						char icon = iconAt(x, y);
+						shown[static_cast<size_t>(x) * cols + y] = icon;
+						buffer += '.';
+						buffer += icon;
+					}
+					buffer += '.';
+				}
+				shownRows = rows;
+				shownCols = cols;
+			}
+			else
+			{
+				for (int x = 0; x < rows; ++x)
+				{
+					char* shownRow = &shown[static_cast<size_t>(x) * cols];
+					int y = 0;
+					while (y < cols)
+					{
+						if (iconAt(x, y) == shownRow[y])
+						{
+							++y;
+							continue;
+						}
+
+						// A cursor move costs more than rewriting a few unchanged cells, so changes up to three cells apart are written as one run
+						int end = y;
+						for (int next = y + 1; next < cols && next - end <= 3; ++next)
+						{
+							if (iconAt(x, next) != shownRow[next])
+							{
+								end = next;
+							}
+						}
+						moveTo(x + 1, 2 * y + 2);
+						for (int col = y; col <= end; ++col)
+						{
+							shownRow[col] = iconAt(x, col);
+							if (col > y)
+							{
+								buffer += '.';
+							}
+							buffer += shownRow[col];
+						}
+						y = end + 1;
+					}
 				}
 			}
-		}
-	}
-	else
-	{
-		xSpaces = *xSizePointer;
-		ySpaces = *ySizePointer;
-	}
 
-	Grid<T> grid(xSpaces, vector<CellBase<T>*>(ySpaces));
-	
+			moveTo(rows + 1, 1);
+			buffer += "\x1b[K" + status;
+			os.write(buffer.data(), buffer.size());
+			os.flush();
+			bytesWritten += buffer.size();
+		}
 
-	return grid;
-}
+		// Draws a generation. The viewport is kept inside the grid, and the line under it shows the generation and where the view is.
+		template <typename T, typename Cell>
+		void draw(GridView<T, Cell> grid, int generation)
+		{
+			int rows = min(viewRows, grid.getRows());
+			int cols = min(viewCols, grid.getCols());
+			viewTop = max(0, min(viewTop, grid.getRows() - rows));
+			viewLeft = max(0, min(viewLeft, grid.getCols() - cols));
+			drawIcons(rows, cols, [&](int x, int y) { return grid.getIcon(viewTop + x, viewLeft + y); },
+				"Generation " + to_string(generation) + ", rows " + to_string(viewTop) + "-" + to_string(viewTop + rows - 1) + " and columns "
+				+ to_string(viewLeft) + "-" + to_string(viewLeft + cols - 1) + " of " + to_string(grid.getRows()) + " x " + to_string(grid.getCols()));
+		}
 
-// Function to clean up the grid and deallocate any memory
-template <typename T>
-void cleanupGrid(Grid<T>& grid)
-{
-	for (auto& row : grid)
-	{
-		for (auto& cell : row)
+		// Moves the cursor under the drawing so text written next does not land on it, and forgets the screen.
+		void finish()
 		{
-			if (cell)
+			if (shownRows > 0)
 			{
-				delete cell; // Deallocate memory used by each cell object.
-				cell = nullptr; // Set pointer to nullptr to avoid dangling pointers.
+				buffer.clear();
+				moveTo(shownRows + 2, 1);
+				os.write(buffer.data(), buffer.size());
+				os.flush();
 			}
+			shownRows = 0;
+			shownCols = 0;
 		}
-	}
-}
+};
 
-// Fills the grid with dead cells.
-template <typename T>
-void createCells(Grid<T> &grid) 
+// RULES
+
+// A birth/survival rule fixed at compile time. Bit n of a mask is set when n live neighbours cause a birth or let a cell survive.
+template <unsigned int Birth, unsigned int Survival>
+struct Rule
 {
-	for (size_t x = 0; x < grid.size(); x++)
+	static constexpr unsigned int birth = Birth;
+	static constexpr unsigned int survival = Survival;
+
+	// Returns whether the cell is alive next generation.
+	bool nextState(bool alive, int neighbours) const
 	{
-		for (size_t y = 0; y < grid[x].size(); y++)
-		{
-			grid[x][y] = new NormalCell<T>(false);
-		}
+		return (((alive ? Survival : Birth) >> neighbours) & 1u) != 0;
 	}
-}
+};
 
-// Randomly distribute cells across the grid.
-template <typename T>
-void scatterCells(Grid<T> &grid, int numCells, unsigned int& seed)
+// A rule only known at runtime. Used for any rule that has no compiled specialisation.
+struct DynamicRule
 {
-	mt19937 gen(seed);
-	uniform_int_distribution<> xDist(0, grid.size() - 1);
-	uniform_int_distribution<> yDist(0, grid[0].size() - 1);
-	int totalCells = 0;
-	
-	// Ensure the number of live cells is not greater than the total grid spaces.
-	int maxCells = grid.size() * grid[0].size();
-	if (numCells > maxCells)
+	unsigned int birth;
+	unsigned int survival;
+
+	bool nextState(bool alive, int neighbours) const
 	{
-		numCells = maxCells;
+		return (((alive ? survival : birth) >> neighbours) & 1u) != 0;
 	}
+};
 
-	while (totalCells < numCells)
-	{	
-		// Generate an X and Y position within grid boundaries.
-		int xPos = xDist(gen);
-		int yPos = yDist(gen);
-
-		// If the cell is not already alive
-		if (!grid[xPos][yPos]->isAlive())
-		{
-			grid[xPos][yPos]->setAlive(true);
-			totalCells++;
-		}
-	}
-}
+// Common rules compiled up front.
+using ConwayRule = Rule<(1 << 3), (1 << 2) | (1 << 3)>; // B3/S23
+using HighLifeRule = Rule<(1 << 3) | (1 << 6), (1 << 2) | (1 << 3)>; // B36/S23
+using DayAndNightRule = Rule<(1 << 3) | (1 << 6) | (1 << 7) | (1 << 8), (1 << 3) | (1 << 4) | (1 << 6) | (1 << 7) | (1 << 8)>; // B3678/S34678
+using SeedsRule = Rule<(1 << 2), 0>; // B2/S
+using LifeWithoutDeathRule = Rule<(1 << 3), 0x1FF>; // B3/S012345678
+using MazeRule = Rule<(1 << 3), (1 << 1) | (1 << 2) | (1 << 3) | (1 << 4) | (1 << 5)>; // B3/S12345
 
-// Count the total of live cells around cell at grid (x, y)
-template <typename T>
-int countLiveNeighbours(Grid<T>& grid, int x, int y)
+// Class to store the rule chosen by the user.
+class RuleSpec
 {
-	int liveNeighbours = 0;
-	int rows = grid.size();
-	int cols = grid[0].size(); 
 
-	for (int i = -1; i <= 1; ++i)
-	{
-		for (int j = -1; j <= 1; ++j)
-		{
-			if (i == 0 && j == 0) 
-			{ 
-				continue; 
-			} // Ignore self.
-			int newX = x + i;
-			int newY = y + j;
+	private:
+		unsigned int birth;
+		unsigned int survival;
+	public:
+		RuleSpec(unsigned int birth = ConwayRule::birth, unsigned int survival = ConwayRule::survival)
+			: birth(birth), survival(survival) {}
 
-			// Ensure the indices are within bounds
-			if ( (newX >= 0 && newX < rows) && (newY >= 0 && newY < cols) )
+		// Get functions
+		unsigned int getBirth() const { return birth; }
+		unsigned int getSurvival() const { return survival; }
+
+		// Returns the rule in B/S notation e.g. "B3/S23".
+		string toString() const
+		{
+			string text = "B";
+			for (int n = 0; n <= 8; ++n)
 			{
-				// Add 1 or 0 based on cell's status.
-				liveNeighbours += grid[newX][newY]->isAlive() ? 1 : 0;
+				if ((birth >> n) & 1u)
+				{
+					text += char('0' + n);
+				}
+			}
+			text += "/S";
+			for (int n = 0; n <= 8; ++n)
+			{
+				if ((survival >> n) & 1u)
+				{
+					text += char('0' + n);
+				}
 			}
+			return text;
 		}
-	}
-	return liveNeighbours;
-}
+};
 
-// Function to check whether an orientation of the pattern fits the grid
-template <typename T>
-bool patternFits(Grid<T>& grid, const vector<vector<bool>>& pattern, int startX, int startY)
+// Reads a rule in B/S notation such as "B36/S23". Returns false if the text is not a valid rule.
+bool parseRule(const string& text, RuleSpec& rule)
 {
-	int patternRows = pattern.size();
-	int patternCols = pattern[0].size();
-	int gridRows = grid.size();
-	int gridCols = grid[0].size();
-
-	// Check if pattern fits within grid boundaries
-	if (startX + patternRows > gridRows || startY + patternCols > gridCols)
-	{
-		return false;
-	}
+	unsigned int birth = 0;
+	unsigned int survival = 0;
+	unsigned int* current = nullptr;
+	bool seenBirth = false;
+	bool seenSurvival = false;
 
-	for (int i = 0; i < patternRows; ++i)
+	for (char c : text)
 	{
-		for (int j = 0; j < patternCols; ++j)
+		if (c == 'B' || c == 'b')
+		{
+			if (seenBirth)
+			{
+				return false;
+			}
+			current = &birth;
+			seenBirth = true;
+		}
+		else if (c == 'S' || c == 's')
 		{
-			if (grid[startX + i][startY + j]->isAlive() != pattern[i][j])
+			if (seenSurvival)
 			{
 				return false;
 			}
+			current = &survival;
+			seenSurvival = true;
+		}
+		else if (c >= '0' && c <= '8' && current != nullptr)
+		{
+			*current |= 1u << (c - '0');
+		}
+		else if (c != '/')
+		{
+			return false;
 		}
 	}
-	return true;
-}
-
-// Function that rotates the pattern by 90 degrees.
-template <typename T>
-vector<vector<T>> rotatePattern(const vector<vector<T>>& pattern)
-{
-	int rows = pattern.size();
-	int cols = pattern[0].size();
-	vector<vector<T>> rotated(cols, vector<T>(rows));
 
-	for (int i = 0; i < rows; ++i)
+	if (!seenBirth || !seenSurvival)
 	{
-		for (int j = 0; j < cols; ++j)
-		{
-			rotated[j][rows - 1 - i] = pattern[i][j];
-		}
+		return false;
 	}
-	return rotated;
+	rule = RuleSpec(birth, survival);
+	return true;
 }
 
-// Function that flips a pattern horizontally
-template <typename T>
-vector<vector<T>> flipHorizontal(const vector<vector<T>>& pattern)
+// Checks whether a runtime rule matches a compiled rule.
+template <typename RuleT>
+bool isRule(const RuleSpec& rule)
 {
-	int rows = pattern.size();
-	vector<vector<T>> hFlipped = pattern;
+	return rule.getBirth() == RuleT::birth && rule.getSurvival() == RuleT::survival;
+}
 
-	for (int i = 0; i < rows; ++i)
-	{
-		reverse(hFlipped[i].begin(), hFlipped[i].end()); // reverses the elements in a row.
-	}
-	return hFlipped;
+// Calls func with the compiled rule matching the spec so the kernels are specialised for it. Falls back to a DynamicRule.
+template <typename Func>
+void dispatchRule(const RuleSpec& rule, Func&& func)
+{
+	if (isRule<ConwayRule>(rule)) { func(ConwayRule()); }
+	else if (isRule<HighLifeRule>(rule)) { func(HighLifeRule()); }
+	else if (isRule<DayAndNightRule>(rule)) { func(DayAndNightRule()); }
+	else if (isRule<SeedsRule>(rule)) { func(SeedsRule()); }
+	else if (isRule<LifeWithoutDeathRule>(rule)) { func(LifeWithoutDeathRule()); }
+	else if (isRule<MazeRule>(rule)) { func(MazeRule()); }
+	else { func(DynamicRule{ rule.getBirth(), rule.getSurvival() }); }
 }
 
-// Function that flips a pattern vertically
-template <typename T>
-vector<vector<T>> flipVertical(const vector<vector<T>>& pattern)
+// Which storage and stepping method a simulation uses.
+enum class EngineType
 {
-	vector<vector<T>> vFlipped = pattern;
-	reverse(vFlipped.begin(), vFlipped.end()); // reverses the elements in a 2d array column
+	Standard,
+	MortonTiled,
+	Distributed,
+	OutOfCore,
+	SparseTiles
+};
 
-	return vFlipped;
-}
+// How runs drawn from the menus are shown.
+enum class DisplayType
+{
+	FullFrames,
+	ChangedCells,
+	DensityOverview
+};
 
-// Hashing function for 2D vector to prevent duplicate patterns
-template <typename T>
-size_t hashPattern(const vector<vector<T>>& pattern)
+// File type frames of a run are exported as.
+enum class ImageFormat
 {
-	size_t seed = 0;
-		for (const auto& row : pattern) 
-		{
-			for (const auto& elem : row) 
-			{
-				seed ^= hash<T>{}(elem)+0x9e3779b9 + (seed << 6) + (seed >> 2); // Boost hash combine algorithm 
-			}
-		}
-	return seed;
-}
+	PBM,
+	PGM,
+	PNG
+};
 
+// Which frames of a run are exported and how. An empty prefix turns exporting off. A crop of 0 rows or columns runs to the edge of the grid.
+struct ExportSettings
+{
+	string prefix;
+	ImageFormat format = ImageFormat::PNG;
+	int scale = 1; // pixels on each side of a cell
+	int stride = 1; // generations between exported frames
+	int cropTop = 0;
+	int cropLeft = 0;
+	int cropRows = 0;
+	int cropCols = 0;
+};
 
-// Generate all pattern variants for multiple uses
-template <typename T>
-vector<vector<vector<T>>> generateAllPatternVariants(const vector<vector<T>>& pattern)
+// How worker processes of the distributed engine pass boundary rows to each other.
+enum class TransportType
 {
-	vector<vector<vector<T>>> variants;
-	unordered_set<size_t> uniquePatterns; // Ensures only unique patterns aere added to the vector.
+	SharedMemory,
+	UnixSocket
+};
 
-	auto addUniqueVariant = [&](const vector<vector<T>>& p) // function to only add unique pattern varients to the set.
-		{
-			size_t hash = hashPattern(p);
-			if (uniquePatterns.insert(hash).second)
-			{
-				variants.push_back(p);
-			}
-		};
+// File the out-of-core engine keeps its cells in unless another is chosen.
+const string DEFAULT_BACKING_FILE = "gameoflife_backing.snap";
 
-	// add original pattern
-	addUniqueVariant(pattern);
+// Memory the rewind history of a run may use unless another budget is chosen, in MiB.
+const int DEFAULT_HISTORY_BUDGET = 64;
 
+// Folder finished runs are cached in unless another is chosen. An empty folder name turns the cache off.
+const string DEFAULT_CACHE_DIRECTORY = "gameoflife_cache";
 
-	// Generate all 90, 180, and 270 degree rotations
-	auto rotated = pattern;
-	for (int i = 0; i < 3; ++i)
-	{
-		rotated = rotatePattern(rotated);
-		addUniqueVariant(rotated);
-	}
+// Class to store the settings shared by every simulation run from the menus.
+class SimulationSettings
+{
 
-	vector<vector<vector<T>>> patternsToFlip = variants;
+	private:
+		RuleSpec rule;
+		int blockDepth; // generations advanced per pass over the grid, 1 turns temporal blocking off
+		EngineType engine;
+		int workers; // slabs the distributed engine splits the grid into
+		TransportType transport;
+		string backingFile; // snapshot file the out-of-core engine keeps its cells in
+		string cacheDirectory; // folder of the result cache, empty when it is off
+		int historyBudget; // MiB the rewind history of a run may use
+		DisplayType display;
+		int viewTop; // first row and column shown when only changed cells are drawn
+		int viewLeft;
+		ExportSettings exportSettings;
+	public:
+		SimulationSettings()
+			: blockDepth(1), engine(EngineType::Standard), workers(4), transport(TransportType::SharedMemory), backingFile(DEFAULT_BACKING_FILE),
+			cacheDirectory(DEFAULT_CACHE_DIRECTORY), historyBudget(DEFAULT_HISTORY_BUDGET), display(DisplayType::FullFrames), viewTop(0), viewLeft(0) {}
 
-	// Add horizontal and vertical flips
-	for (const auto& p : patternsToFlip)
-	{
-		addUniqueVariant(flipHorizontal(p));
-		addUniqueVariant(flipVertical(p));
-	}
+		// Get functions
+		const RuleSpec& getRule() const { return rule; }
+		int getBlockDepth() const { return blockDepth; }
+		EngineType getEngine() const { return engine; }
+		int getWorkers() const { return workers; }
+		TransportType getTransport() const { return transport; }
+		const string& getBackingFile() const { return backingFile; }
+		const string& getCacheDirectory() const { return cacheDirectory; }
+		int getHistoryBudget() const { return historyBudget; }
+		DisplayType getDisplay() const { return display; }
+		int getViewTop() const { return viewTop; }
+		int getViewLeft() const { return viewLeft; }
+		const ExportSettings& getExport() const { return exportSettings; }
+
+		// Set functions
+		void setRule(const RuleSpec& newRule) { rule = newRule; }
+		void setBlockDepth(int depth) { blockDepth = depth; }
+		void setEngine(EngineType newEngine) { engine = newEngine; }
+		void setWorkers(int newWorkers) { workers = newWorkers; }
+		void setTransport(TransportType newTransport) { transport = newTransport; }
+		void setBackingFile(const string& filename) { backingFile = filename; }
+		void setCacheDirectory(const string& directory) { cacheDirectory = directory; }
+		void setHistoryBudget(int budget) { historyBudget = budget; }
+		void setDisplay(DisplayType newDisplay) { display = newDisplay; }
+		void setView(int top, int left) { viewTop = top; viewLeft = left; }
+		void setExport(const ExportSettings& newExport) { exportSettings = newExport; }
+};
 
-	return variants;
-}
+// SCHEDULER
 
-// Function to check whether a pattern is in a grid by comparing all posible variants (rotations and flips) of a pattern.
-template <typename T>
-bool matchesPattern(Grid<T>& grid, const vector<vector<bool>>& pattern, int startX, int startY)
+// Size of the tiles the grid is split into when stepping and scanning in parallel.
+const int TILE_ROWS = 16;
+const int TILE_COLS = 512;
+
+// Pool of worker threads that share out tiles of work. Each worker has its own queue and steals from the others once it runs dry,
+// so a band of slow tiles never leaves the other cores idle.
+class WorkStealingScheduler
 {
-	auto patternVariants = generateAllPatternVariants(pattern);
 
-	bool found = false;
-	vector<thread> threads;
+	private:
+		// A batch of tiles handed to parallelFor. The body is called through a plain function pointer so a batch needs no heap allocation.
+		struct Job
+		{
+			void (*run)(void* context, int tile);
+			void* context;
+			atomic<int> remaining;
+		};
 
-	auto checkPattern = [&](const vector<vector<bool>>& p)
-	{
-		if (!found && patternFits(grid, p, startX, startY))
-		{	
-			lock_guard<mutex> lock(mtx); // lock when modifying shared data
-			if (!found)
+		struct Task
+		{
+			Job* job;
+			int tile;
+		};
+
+		// Tasks queued for one worker, kept in a ring buffer that only grows. The owner takes from the back and thieves from the front.
+		struct WorkerQueue
+		{
+			mutex lock;
+			vector<Task> ring;
+			size_t head = 0;
+			size_t count = 0;
+
+			void push(const Task& task)
 			{
-				found = true;
+				if (count == ring.size())
+				{
+					vector<Task> bigger(max<size_t>(64, ring.size() * 2));
+					for (size_t i = 0; i < count; ++i)
+					{
+						bigger[i] = ring[(head + i) % ring.size()];
+					}
+					ring.swap(bigger);
+					head = 0;
+				}
+				ring[(head + count) % ring.size()] = task;
+				count++;
 			}
 
-		}
-	};
-
-	// Limit number of threads
-	int numThreads = min(thread::hardware_concurrency(), static_cast<unsigned int>(patternVariants.size()));
+			bool popBack(Task& task)
+			{
+				if (count == 0)
+				{
+					return false;
+				}
+				count--;
+				task = ring[(head + count) % ring.size()];
+				return true;
+			}
 
-	// Start threads for each rotation and flip combination
-	for (int i = 0; i < numThreads; ++i)
-	{
-		threads.push_back(thread([&, i]() {
-			for (int j = i; j < patternVariants.size(); j += numThreads)
+			bool popFront(Task& task)
 			{
-				if (found)
+				if (count == 0)
 				{
-					return;
+					return false;
 				}
-				checkPattern(patternVariants[j]);
+				task = ring[head];
+				head = (head + 1) % ring.size();
+				count--;
+				return true;
 			}
-		}));
-	}
+		};
 
-	for (auto& th : threads)
-	{
-		if (th.joinable())
+		vector<unique_ptr<WorkerQueue>> queues;
+		vector<thread> workers;
+		atomic<int> queuedTasks;
+		atomic<bool> stopping;
+		mutex sleepLock;
+		condition_variable wake;
+
+		// Index of the worker running on this thread, -1 for threads outside the pool.
+		static int& currentWorker()
 		{
-			th.join();
+			static thread_local int index = -1;
+			return index;
 		}
-	}
 
-	return found;
-}
+		// Takes a task from this worker's own queue, otherwise steals the oldest task from another queue.
+		bool takeTask(int self, Task& task)
+		{
+			int numQueues = queues.size();
+			if (self >= 0)
+			{
+				lock_guard<mutex> lock(queues[self]->lock);
+				if (queues[self]->popBack(task))
+				{
+					queuedTasks--;
+					return true;
+				}
+			}
+			int start = self >= 0 ? self + 1 : 0;
+			for (int i = 0; i < numQueues; ++i)
+			{
+				WorkerQueue& victim = *queues[(start + i) % numQueues];
+				lock_guard<mutex> lock(victim.lock);
+				if (victim.popFront(task))
+				{
+					queuedTasks--;
+					return true;
+				}
+			}
+			return false;
+		}
 
-// Function to define a block and beehive and then checks to see if the found pattern is either or.
-template <typename T>
-bool isBlockOrBeehive(Grid<T>& grid)
-{
-	int rows = grid.size();
-	int cols = grid[0].size();
+		static void runTask(const Task& task)
+		{
+			task.job->run(task.job->context, task.tile);
+			task.job->remaining.fetch_sub(1, memory_order_acq_rel);
+		}
 
-	// Define Patterns
+		void workerLoop(int self)
+		{
+			currentWorker() = self;
+			while (true)
+			{
+				Task task;
+				if (takeTask(self, task))
+				{
+					runTask(task);
+					continue;
+				}
+				unique_lock<mutex> lock(sleepLock);
+				wake.wait(lock, [&]() { return stopping.load() || queuedTasks.load() > 0; });
+				if (stopping.load() && queuedTasks.load() == 0)
+				{
+					return;
+				}
+			}
+		}
 
-	// Block
+	public:
+		// The calling thread always helps, so one fewer worker than cores is started.
+		WorkStealingScheduler(int numThreads) : queuedTasks(0), stopping(false)
+		{
+			int numWorkers = max(1, numThreads - 1);
+			for (int i = 0; i < numWorkers; ++i)
+			{
+				queues.push_back(unique_ptr<WorkerQueue>(new WorkerQueue()));
+			}
+			for (int i = 0; i < numWorkers; ++i)
+			{
+				workers.push_back(thread(&WorkStealingScheduler::workerLoop, this, i));
+			}
+		}
 
-	vector<vector<bool>> blockPattern = {
-		{true, true},
-		{true, true},
-	};
+		~WorkStealingScheduler()
+		{
+			{
+				lock_guard<mutex> lock(sleepLock);
+				stopping = true;
+			}
+			wake.notify_all();
+			for (auto& th : workers)
+			{
+				th.join();
+			}
+		}
 
-	// Behive
+		WorkStealingScheduler(const WorkStealingScheduler&) = delete;
+		WorkStealingScheduler& operator=(const WorkStealingScheduler&) = delete;
 
-	vector<vector<bool>> beehivePattern = {
-		{false, true, true, false},
-		{true, false, false, true},
-		{false, true, true, false}
-	};
+		int getThreadCount() const { return static_cast<int>(workers.size()) + 1; }
 
-	// Check every position in the grid for both patterns
-	for (int x = 0; x < rows; ++x)
-	{
-		for (int y = 0; y < cols; ++y)
+		// Calls body(tile) for every tile in [0, numTiles) across the pool and returns once all have finished.
+		// Neighbouring tiles are dealt to the same queue so they tend to share a cache. Safe to call from inside a tile.
+		template <typename Func>
+		void parallelFor(int numTiles, Func&& body)
 		{
-			// Count neighbours if cell is dead and has no neighbours skip this cell
+			using Body = typename remove_reference<Func>::type;
+			if (numTiles <= 0)
+			{
+				return;
+			}
+			if (numTiles == 1)
+			{
+				body(0);
+				return;
+			}
+
+			Job job;
+			job.run = [](void* context, int tile) { (*static_cast<Body*>(context))(tile); };
+			job.context = const_cast<void*>(static_cast<const void*>(&body));
+			job.remaining = numTiles;
 
-			int neighbours = countLiveNeighbours(grid, x, y);
-			if (grid[x][y] != nullptr && !grid[x][y]->isAlive() && neighbours == 0)
+			int numQueues = queues.size();
+			for (int q = 0; q < numQueues; ++q)
 			{
-				continue;
+				int first = static_cast<int>(static_cast<long long>(numTiles) * q / numQueues);
+				int last = static_cast<int>(static_cast<long long>(numTiles) * (q + 1) / numQueues);
+				lock_guard<mutex> lock(queues[q]->lock);
+				for (int tile = last - 1; tile >= first; --tile)
+				{
+					queues[q]->push(Task{ &job, tile });
+				}
+				queuedTasks += last - first;
+			}
+			{
+				lock_guard<mutex> lock(sleepLock);
 			}
+			wake.notify_all();
 
-			// Check for pattern at this position
-			if (matchesPattern(grid, blockPattern, x, y) || matchesPattern(grid, beehivePattern, x, y))
+			// Help out until every tile of this batch is done.
+			int self = currentWorker();
+			while (job.remaining.load(memory_order_acquire) > 0)
 			{
-				return true;
+				Task task;
+				if (takeTask(self, task))
+				{
+					runTask(task);
+				}
+				else
+				{
+					this_thread::yield();
+				}
 			}
 		}
-	}
-	return false;
+};
+
+// Returns the scheduler shared by the whole program.
+WorkStealingScheduler& getScheduler()
+{
+	static WorkStealingScheduler scheduler(max(1u, thread::hardware_concurrency()));
+	return scheduler;
 }
 
-// Function to define a blinker and toad and then checks to see if the found pattern is either or.
-template <typename T>
-bool isBlinkerOrToad(Grid<T>& grid)
+// Records which tiles of a grid had a cell change since the map was last cleared. Steps mark it, detectors read and clear it.
+class ChangeMap
 {
-	// Define patterns
-	
-	// Blinker Phase 1
-	
-	vector<vector<bool>> blinkerPhase1 =
-	{
-		{true, true, true}
-	};
 
-	vector<vector<bool>> blinkerPhase2 =
-	{
-		{true},
-		{true},
-		{true}
-	};
+	private:
+		int tilesDown;
+		int tilesAcross;
+		vector<atomic<bool>> changed; // atomic because neighbouring tasks can mark the same tile
+	public:
+		ChangeMap() : tilesDown(0), tilesAcross(0) {}
 
-	// Toad Phase 1
-	vector<vector<bool>> toadPhase1 =
-	{
-		{false, true, true, true},
-		{true, true, true, false}
-	};
+		ChangeMap(int rows, int cols)
+			: tilesDown((rows + TILE_ROWS - 1) / TILE_ROWS), tilesAcross((cols + TILE_COLS - 1) / TILE_COLS), changed(static_cast<size_t>(tilesDown) * tilesAcross)
+		{
+			markAll();
+		}
 
-	vector<vector<bool>> toadPhase2 =
-	{
-		{false, false, true, false},
-		{true, false, false, true},
-		{true, false, false, true},
-		{false, true, false, false}
-	};
-	
-	int rows = grid.size();
-	int cols = grid[0].size();
+		// Get functions
+		int getTilesDown() const { return tilesDown; }
+		int getTilesAcross() const { return tilesAcross; }
 
-	// Check every position in the grid for both patterns
-	for (int x = 0; x < rows; ++x)
-	{
-		for (int y = 0; y < cols; ++y)
+		bool isChanged(int tileRow, int tileCol) const
 		{
-			// Count neighbours if cell is dead and has no neighbours skip this cell
+			if (tileRow < 0 || tileRow >= tilesDown || tileCol < 0 || tileCol >= tilesAcross)
+			{
+				return false;
+			}
+			return changed[static_cast<size_t>(tileRow) * tilesAcross + tileCol].load(memory_order_relaxed);
+		}
 
-			int neighbours = countLiveNeighbours(grid, x, y);
-			if (grid[x][y] != nullptr && !grid[x][y]->isAlive() && neighbours == 0)
+		// Marks every tile overlapping the cells [startRow, endRow) x [startCol, endCol).
+		void markCells(int startRow, int endRow, int startCol, int endCol)
+		{
+			for (int tileRow = startRow / TILE_ROWS; tileRow <= (endRow - 1) / TILE_ROWS && tileRow < tilesDown; ++tileRow)
 			{
-				continue;
+				for (int tileCol = startCol / TILE_COLS; tileCol <= (endCol - 1) / TILE_COLS && tileCol < tilesAcross; ++tileCol)
+				{
+					changed[static_cast<size_t>(tileRow) * tilesAcross + tileCol].store(true, memory_order_relaxed);
+				}
 			}
-			// Check for pattern at this position
-			if (matchesPattern(grid, blinkerPhase1, x, y) || matchesPattern(grid, blinkerPhase2, x, y) || matchesPattern(grid, toadPhase1, x, y) || matchesPattern(grid, toadPhase2, x, y))
+		}
+
+		void markAll()
+		{
+			for (auto& flag : changed)
 			{
-				return true;
+				flag.store(true, memory_order_relaxed);
 			}
 		}
-	}
-	return false;
 
-}
+		void clear()
+		{
+			for (auto& flag : changed)
+			{
+				flag.store(false, memory_order_relaxed);
+			}
+		}
+};
 
-// Function to define a glider and LWSS and then checks to see if the found pattern is either or.
-template <typename T>
-bool isGliderOrLWSS(Grid<T>& grid)
+// Packed bitmap of the cells that are alive or next to a live cell. Steps write the live cells of the generation they produce as a by-product,
+// and detectors read the packed rows and skip words with nothing near a live cell instead of counting neighbours again.
+// A step over the whole grid writes every row. A sparse step writes only its tiles of 64 rows by one word, and the map clears the tiles
+// the last sparse step wrote and rebuilds active around them alone, so its work follows the occupied area rather than the size of the grid.
+class ActivityMap
 {
-	// Define patterns
 
-	// Glider Phase 1
-	
-	vector<vector<bool>> gliderPhase1 =
-	{
-		{false, true, false},
-		{false, false, true},
-		{true, true, true}
-	};
+	private:
+		int rows;
+		int cols;
+		int wordsPerRow;
+		vector<uint64_t> live;
+		vector<uint64_t> active;
+		bool written; // a step has written live for the grid as it is now
+		bool dilated; // active has been built from live
+		bool wholeLive; // live was last written in full, so a sparse step must clear all of it
+		bool wholeActive; // live may have changed anywhere since active was built
+		vector<uint64_t> writtenTiles; // tiles the last sparse step wrote, (tile row << 32 | word)
+		vector<uint64_t> changedTiles; // tiles written or cleared since active was built
+
+		static uint64_t tileKey(int tileRow, int word) { return (uint64_t(uint32_t(tileRow)) << 32) | uint32_t(word); }
+
+		// Sizes the map for a grid. Returns true if it was resized, leaving every cell dead.
+		bool resize(int gridRows, int gridCols)
+		{
+			if (gridRows == rows && gridCols == cols)
+			{
+				return false;
+			}
+			rows = gridRows;
+			cols = gridCols;
+			wordsPerRow = (cols + 63) / 64;
+			live.assign(static_cast<size_t>(rows) * wordsPerRow, 0);
+			active.assign(live.size(), 0);
+			writtenTiles.clear();
+			changedTiles.clear();
+			wholeActive = true;
+			return true;
+		}
 
-	// Glider Phase 2
+		// Notes a tile whose live cells have changed. Once more tiles have changed than fit in a small part of the grid all of active is rebuilt.
+		void noteChanged(uint64_t key)
+		{
+			if (wholeActive)
+			{
+				return;
+			}
+			changedTiles.push_back(key);
+			if (changedTiles.size() * 4 > static_cast<size_t>((rows + 63) / 64) * wordsPerRow)
+			{
+				wholeActive = true;
+				changedTiles.clear();
+			}
+		}
 
-	vector<vector<bool>> gliderPhase2 =
-	{
-		{true, false, true},
-		{false, true, true},
-		{false, true, false}
-	};
+		// Builds the active words of a row from live.
+		void dilateWords(int x, int firstWord, int endWord)
+		{
+			uint64_t* activeRow = active.data() + static_cast<size_t>(x) * wordsPerRow;
+			for (int word = firstWord; word < endWord; ++word)
+			{
+				activeRow[word] = spreadWord(x - 1, word) | spreadWord(x, word) | spreadWord(x + 1, word);
+			}
+		}
 
-	// LWSS Phase 1
-
-	vector<vector<bool>> lwssPhase1 =
-	{
-		{false, true, false, false, true},
-		{true, false, false, false, false},
-		{true, false, false, false, true},
-		{true, true, true, true, false}
-	};
-
-	// LWSS Phase 2
-
-	vector<vector<bool>> lwssPhase2 =
-	{
-		{false, true, true, false, false},
-		{true, true, false, true, true},
-		{false, true, true, true, true},
-		{false, false, true, true, false}
-	};
-	// Don't need other phases as they are just rotations of phase 1 and 2
-
-	int rows = grid.size();
-	int cols = grid[0].size();
-
-	// Check every position in the grid for both patterns
-	for (int x = 0; x < rows; ++x)
-	{
-		for (int y = 0; y < cols; ++y)
+		// Live cells of a row spread one cell left and right.
+		uint64_t spreadWord(int x, int word) const
 		{
-			// Count neighbours if cell is dead and has no neighbours skip this cell
-
-			int neighbours = countLiveNeighbours(grid, x, y);
-			if (grid[x][y] != nullptr && !grid[x][y]->isAlive() && neighbours == 0)
+			if (x < 0 || x >= rows)
 			{
-				continue;
+				return 0;
 			}
+			const uint64_t* row = live.data() + static_cast<size_t>(x) * wordsPerRow;
+			uint64_t left = word > 0 ? row[word - 1] : 0;
+			uint64_t right = word + 1 < wordsPerRow ? row[word + 1] : 0;
+			return row[word] | (row[word] << 1) | (left >> 63) | (row[word] >> 1) | (right << 63);
+		}
+
+	public:
+		ActivityMap() : rows(0), cols(0), wordsPerRow(0), written(false), dilated(false), wholeLive(false), wholeActive(true) {}
+
+		// Get functions
+		int getRows() const { return rows; }
+		int getCols() const { return cols; }
+		bool isReady() const { return written; }
+		uint64_t* getLiveRow(int x) { return live.data() + static_cast<size_t>(x) * wordsPerRow; }
+		const uint64_t* getLiveRow(int x) const { return live.data() + static_cast<size_t>(x) * wordsPerRow; }
+		const uint64_t* getActiveRow(int x) const { return active.data() + static_cast<size_t>(x) * wordsPerRow; }
+
+		// Sizes the map for a grid before a step writes every live row.
+		void beginStep(int gridRows, int gridCols)
+		{
+			resize(gridRows, gridCols);
+			writtenTiles.clear();
+			changedTiles.clear();
+			wholeLive = true;
+			wholeActive = true;
+			written = true;
+			dilated = false;
+		}
 
-			// Check for pattern at this position
-			if (matchesPattern(grid, gliderPhase1, x, y) || matchesPattern(grid, gliderPhase2, x, y) || matchesPattern(grid, lwssPhase1, x, y) || matchesPattern(grid, lwssPhase2, x, y))
+		// Sizes the map for a grid before a sparse step, and clears the tiles the last sparse step wrote. Every tile the step writes must be marked with markTile.
+		void beginTileStep(int gridRows, int gridCols)
+		{
+			if (!resize(gridRows, gridCols))
 			{
-				return true;
+				if (wholeLive)
+				{
+					fill(live.begin(), live.end(), 0);
+					wholeActive = true;
+				}
+				else
+				{
+					for (uint64_t key : writtenTiles)
+					{
+						int firstRow = static_cast<int>(key >> 32) * 64;
+						int word = static_cast<int>(uint32_t(key));
+						for (int x = firstRow; x < min(rows, firstRow + 64); ++x)
+						{
+							live[static_cast<size_t>(x) * wordsPerRow + word] = 0;
+						}
+						noteChanged(key);
+					}
+				}
 			}
+			writtenTiles.clear();
+			wholeLive = false;
+			written = true;
+			dilated = false;
 		}
-	}
-	return false;
-}
 
-// Function to update cells via threading
-template <typename T>
-void updateCellsSegment(Grid<T>& grid, Grid<T>& newGrid, int startRow, int endRow)
-{
-	for (size_t x = startRow; x < endRow; x++)
-	{
-		for (size_t y = 0; y < grid[x].size(); y++)
-		{ 	
-			// calculate neighbours
-			int totalNeighbours = countLiveNeighbours(grid, x, y);
+		// Marks a tile of 64 rows by one word that a sparse step writes. Must be called before the step writes it, and not from more than one thread at once.
+		void markTile(int tileRow, int word)
+		{
+			writtenTiles.push_back(tileKey(tileRow, word));
+			noteChanged(writtenTiles.back());
+		}
 
-			// skip if dead and has no neighbours
-			if (!grid[x][y]->isAlive() && totalNeighbours == 0)
-			{
-				newGrid[x][y] = new NormalCell<T>(false);
-				continue;
-			}
+		// Called when the grid is changed outside a step, so detectors go back to counting neighbours.
+		void invalidate()
+		{
+			written = false;
+		}
 
-			// if lonely or overpopulated: die
-			if (totalNeighbours < 2 || totalNeighbours > 3) 
+		// Builds the bitmap from the live rows a step wrote, one band of rows per task. Does nothing if it is already built.
+		void refresh()
+		{
+			if (!written || dilated)
 			{
-				newGrid[x][y] = new NormalCell<T>(false);
+				return;
 			}
-
-			// if exactly 3 neighbours the dead cell is born
-			else if (totalNeighbours == 3) 
+			if (wholeActive)
 			{
-				newGrid[x][y] = new NormalCell<T>(true);
+				int bands = (rows + TILE_ROWS - 1) / TILE_ROWS;
+				getScheduler().parallelFor(bands, [&](int band)
+				{
+					int endRow = min(rows, (band + 1) * TILE_ROWS);
+					for (int x = band * TILE_ROWS; x < endRow; ++x)
+					{
+						dilateWords(x, 0, wordsPerRow);
+					}
+				});
 			}
-			// if 2 neighbours stay the same
-			else 
+			else
 			{
-				newGrid[x][y] = new NormalCell<T>(grid[x][y]->isAlive());
+				// A changed tile can only change active one row above and below it and one word either side
+				sort(changedTiles.begin(), changedTiles.end());
+				changedTiles.erase(unique(changedTiles.begin(), changedTiles.end()), changedTiles.end());
+				for (uint64_t key : changedTiles)
+				{
+					int firstRow = static_cast<int>(key >> 32) * 64;
+					int word = static_cast<int>(uint32_t(key));
+					for (int x = max(0, firstRow - 1); x < min(rows, firstRow + 65); ++x)
+					{
+						dilateWords(x, max(0, word - 1), min(wordsPerRow, word + 2));
+					}
+				}
 			}
+			changedTiles.clear();
+			wholeActive = false;
+			dilated = true;
 		}
-	}
-}
-
-// Updates Cells in parallel.
-template <typename T>
-void UpdateCells(Grid<T> &grid)
-{
-	Grid<T> newGrid (grid.size(), vector<CellBase<T>*>(grid[0].size()));
-	vector<thread> threads;
-
-	// Gain the number of threads and how many rows a thread can process.
-	int numThreads = thread::hardware_concurrency();
-	int rowsPerThread = grid.size() / numThreads;
+};
 
-	for (int i = 0; i < numThreads; ++i)
-	{
-		int startRow = i * rowsPerThread;
-		int endRow = (i == numThreads - 1) ? grid.size() : startRow + rowsPerThread;
-		threads.push_back(thread(updateCellsSegment<T>, ref(grid), ref(newGrid), startRow, endRow));
-	}
+// Steps write whole words of the live bitmap, so their tiles must start on a word.
+static_assert(TILE_COLS % 64 == 0, "tiles must cover whole words of the activity map");
 
-	for (auto& th : threads)
+// Writes the live cells of part of a grid row into the activity map. startCol must start a word.
+template <typename T, typename Cell>
+void packLiveRow(ActivityMap& activity, int x, int startCol, int endCol, const typename Grid<T, Cell>::Storage* cells)
+{
+	using State = typename Grid<T, Cell>::State;
+	uint64_t* liveRow = activity.getLiveRow(x);
+	for (int y = startCol; y < endCol; y += 64)
 	{
-		th.join(); // Wait for all threads to finish
+		uint64_t bits = 0;
+		for (int bit = 0; bit < 64 && y + bit < endCol; ++bit)
+		{
+			bits |= uint64_t(Cell::isAlive(State(cells[y - startCol + bit]))) << bit;
+		}
+		liveRow[y / 64] = bits;
 	}
+}
 
-
-	// clean grid
-	cleanupGrid(grid);
-
-	// copy newgrid to grid
-	grid = newGrid;
+// Operator override of >> to clean the input stream.
+istream& operator >> (istream& in, ClearAndIgnore)
+{
+	in.clear();
+	in.ignore(numeric_limits<streamsize>::max(), '\n');
+	return in;
 }
 
-// Updates the grid for X cycles.
-template <typename T>
-void runSimulation(Grid<T> &grid, int totalCycles) 
+// Function to check whether the input is valid or not.
+bool isValidInput(int input)
 {
-	// Runs the simulation for x cycles
-	int currentCycle = 0;
-	
-	while (currentCycle < totalCycles)
+	if (cin.fail() || input <= 0)
 	{
-		cout << grid;
-		UpdateCells(grid);
-		currentCycle++;
-
-		// checks to see if all cells are dead. if so stops function prematurely
-		if (checkForDeadCells(grid))
-		{
-			cout << endl << "All cells have died. Stopping simulation.";
-			break;
-		}
+		cout << endl << "Error: Invalid Input. Please enter a positive number.";
+		cin >> ClearAndIgnore();
+		return false;
 	}
+	return true;
 }
 
-// returns based if still life has remained for required generations
+// Creates an empty 2D vector to use as a grid. Can be generated with user inputs or by int pointers.
 template <typename T>
-bool checkForStableStillLife(Grid<T>& grid, int &stableGenerations, int currentCycle){
-	if (currentCycle > 0 && isBlockOrBeehive(grid))
+Grid<T> generateGrid(int* xSizePointer, int* ySizePointer)
+{
+	int xSpaces;
+	int ySpaces;
+
+	if (xSizePointer == nullptr || ySizePointer == nullptr)
 	{
-		stableGenerations++;
+		bool allowedInput = false;
+		while (!allowedInput) {
+
+			cout << endl << "Enter number of spaces on the X Axis: ";
+			cin >> xSpaces;
+
+			if (isValidInput(xSpaces)) {
+
+				cout << endl << "Enter number of spaces on the Y Axis: ";
+				cin >> ySpaces;
+				
+				if (isValidInput(ySpaces))
+				{
+					allowedInput = true;
+				}
+			}
+		}
 	}
 	else
 	{
-		stableGenerations = 0;
-	}
-	if (stableGenerations >= 2)
-	{
-		return true;
+		xSpaces = *xSizePointer;
+		ySpaces = *ySizePointer;
 	}
-	return false;
 
+	Grid<T> grid(xSpaces, ySpaces);
+	
+
+	return grid;
 }
 
-// returns based if oscillator has remained for required generations
-template <typename T>
-bool checkForStableOscillator(Grid<T>& grid, int& stableGenerations, int currentCycle)
+// Fills the grid with dead cells.
+template <typename T, typename Cell>
+void createCells(Grid<T, Cell> &grid)
 {
-	if (currentCycle > 0 && isBlinkerOrToad(grid))
-	{
-		stableGenerations++;
-	}
-	else
-	{
-		stableGenerations = 0;
-	}
-	if (stableGenerations >= 3)
-	{
-		return true;
-	}
-	return false;
+	grid.clear();
 }
 
-// returns based if spaceship has remained for required generations
-template <typename T>
-bool checkForStableSpaceship(Grid<T>& grid, int& stableGenerations, int currentCycle)
+// Mixes the bits of a word so nearby inputs give unrelated outputs.
+inline uint64_t mixBits(uint64_t value)
 {
-	if (currentCycle > 0 && isGliderOrLWSS(grid))
-	{
-		stableGenerations++;
-	}
-	else
-	{
-		stableGenerations = 0;
-	}
-	if (stableGenerations >= 5)
-	{
-		return true;
-	}
-	return false;
+	value ^= value >> 30;
+	value *= 0xbf58476d1ce4e5b9ULL;
+	value ^= value >> 27;
+	value *= 0x94d049bb133111ebULL;
+	value ^= value >> 31;
+	return value;
 }
 
-// Function to check if all cells are dead
-template <typename T>
-bool checkForDeadCells(Grid<T>& grid)
+// Shuffles the numbers [0, count) with a keyed four round Feistel network. Each number is worked out on its own,
+// so any part of the range can be shuffled by any thread. Results outside the range are fed back in until they land inside it.
+class IndexPermutation
 {
-	int rows = grid.size();
-	int cols = grid[0].size();
 
-	for (int x = 0; x < rows; ++x)
-	{
-		for (int y = 0; y < cols; ++y)
+	private:
+		uint64_t count;
+		uint64_t key;
+		int halfBits;
+		uint64_t mask;
+	public:
+		IndexPermutation(uint64_t count, uint64_t key) : count(count), key(key), halfBits(0)
 		{
-			if (grid[x][y]->isAlive())
+			while ((uint64_t(1) << (2 * halfBits)) < count)
 			{
-				return false;
+				halfBits++;
 			}
+			mask = (uint64_t(1) << halfBits) - 1;
 		}
-	}
-	return true;
-}
-
-// Displays pattern menu
-int menu_displayPatternMenu()
-{
-	int patternChoice;
-
-
-	// Poorly implemented due to implementation with runExperiement will change if have time
-	while (true) {
-		cout << endl << "|| 1. Block and Beehive";
-		cout << endl << "|| 2. Blinker or toad";
-		cout << endl << "|| 3. Glider or LWSS";
-		cout << endl << "|| Choose a pattern to search for: ";
 
-		if (cin >> patternChoice)
+		uint64_t permute(uint64_t index) const
 		{
-			if (patternChoice >= 1 && patternChoice <= 3)
-			{
-				break;
-			}
-			else
+			do
 			{
-				cout << "Error: Invalid choice. Please try again.";
-			}
-		}
-		else {
-			cout << endl << "Error: Invalid Option. Please try again.";
-			cin >> ClearAndIgnore();
+				uint64_t left = index >> halfBits;
+				uint64_t right = index & mask;
+				for (uint64_t round = 0; round < 4; ++round)
+				{
+					uint64_t next = left ^ (mixBits(right ^ (key + round * 0x9e3779b97f4a7c15ULL)) & mask);
+					left = right;
+					right = next;
+				}
+				index = (left << halfBits) | right;
+			} while (index >= count);
+			return index;
 		}
-	}
-;
-
-	return patternChoice;
-}
+};
 
-// runs infinite simulation until chosen patterns are found
-template <typename T>
-void runExperiment(Grid<T>& grid)
+// Scatters exactly numCells live cells. Cell i is alive when its place in a shuffle of every cell keyed by the seed is below numCells,
+// so the cost is the same at any density. Bands of rows are filled in parallel and the result only depends on the seed.
+// LEGACY_SCATTER draws places the way older builds did, so the seeds in their .csv files give the same grids.
+template <typename T, typename Cell>
+void scatterCells(Grid<T, Cell> &grid, int numCells, unsigned int& seed, int scatterVersion = SCATTER_VERSION)
 {
-	int MAX_EXPERIMENT = 300;
-	int patternChoice = menu_displayPatternMenu();
-	int experimentCount = 0;
-	int stableGenerations = 0; // Track how many 'frames' the pattern appears for.
-	bool patternFound = false;
-	int cycles = 1;
-	int totalCycles;
-	int totalCells;
-	bool allowedInput = false;
-	
-	// Check input
-	while (!allowedInput)
+	mt19937 gen(seed);
+	int rows = grid.getRows();
+	int cols = grid.getCols();
+	if (scatterVersion == LEGACY_SCATTER)
 	{
-		cout << endl << "Enter the number of phases to run per experiement: ";
-		cin >> totalCycles;
+		uniform_int_distribution<> xDist(0, rows - 1);
+		uniform_int_distribution<> yDist(0, cols - 1);
+		int maxCells = rows * cols;
+		int totalCells = 0;
 
-		if (isValidInput(totalCycles))
+		// Ensure the number of live cells is not greater than the total grid spaces.
+		if (numCells > maxCells)
 		{
-			cout << endl << "Enter the number of living cells per experiment: ";
-			cin >> totalCells;
-			
-			if (isValidInput(totalCells))
+			numCells = maxCells;
+		}
+		while (totalCells < numCells)
+		{
+			int xPos = xDist(gen);
+			int yPos = yDist(gen);
+			if (!grid.isAlive(xPos, yPos))
 			{
-				allowedInput = true;
+				grid.setAlive(xPos, yPos, true);
+				totalCells++;
 			}
 		}
+		return;
 	}
 
-	while (!patternFound && experimentCount < MAX_EXPERIMENT)
+	uint64_t key = (uint64_t(gen()) << 32) | gen();
+	
+	// Ensure the number of live cells is not greater than the total grid spaces.
+	uint64_t maxCells = uint64_t(rows) * cols;
+	uint64_t liveCells = min(maxCells, uint64_t(max(0, numCells)));
+	if (liveCells == 0)
 	{
-		random_device rd; // Generate new seed.
-		unsigned int seed = rd();
-		experimentCount++;
-		createCells(grid);
-		scatterCells(grid, totalCells, seed);
-
-		cout << endl << "Running experiment #" << experimentCount << endl;
+		return;
+	}
 
-		int currentCycle = 0;
-		// need to add max cycle limit
-		while (currentCycle < totalCycles && !patternFound)
+	IndexPermutation shuffle(maxCells, key);
+	int bands = (rows + TILE_ROWS - 1) / TILE_ROWS;
+	getScheduler().parallelFor(bands, [&](int band)
+	{
+		int endRow = min(rows, (band + 1) * TILE_ROWS);
+		for (int x = band * TILE_ROWS; x < endRow; ++x)
 		{
-			runSimulation(grid, cycles);
-			switch (patternChoice)
+			for (int y = 0; y < cols; ++y)
 			{
-				case 1:
-					// Check for block or beehive after each generation of cells.
-					if (checkForStableStillLife(grid, stableGenerations, currentCycle))
-					{
-						patternFound = true;
-						cout << endl << "Block or Beehive detected in experiment #" << experimentCount << " after " << currentCycle << " generations!";
-						calculateERN(grid, totalCells, &patternChoice);
+				if (shuffle.permute(uint64_t(x) * cols + y) < liveCells)
+				{
+					grid.setAlive(x, y, true);
+				}
+			}
+		}
+	});
+}
+
+// Count the total of live cells around cell at grid (x, y)
+template <typename T, typename Cell>
+int countLiveNeighbours(const Grid<T, Cell>& grid, int x, int y)
+{
+	int liveNeighbours = 0;
+	int rows = grid.getRows();
+	int cols = grid.getCols();
+
+	for (int i = -1; i <= 1; ++i)
+	{
+		for (int j = -1; j <= 1; ++j)
+		{
+			if (i == 0 && j == 0) 
+			{ 
+				continue; 
+			} // Ignore self.
+			int newX = x + i;
+			int newY = y + j;
+
+			// Ensure the indices are within bounds
+			if ( (newX >= 0 && newX < rows) && (newY >= 0 && newY < cols) )
+			{
+				// Add 1 or 0 based on cell's status.
+				liveNeighbours += grid.isAlive(newX, newY) ? 1 : 0;
+			}
+		}
+	}
+	return liveNeighbours;
+}
+
+// Function to check whether an orientation of the pattern fits the grid
+template <typename T, typename Cell>
+bool patternFits(const Grid<T, Cell>& grid, const vector<vector<bool>>& pattern, int startX, int startY)
+{
+	int patternRows = pattern.size();
+	int patternCols = pattern[0].size();
+	int gridRows = grid.getRows();
+	int gridCols = grid.getCols();
+
+	// Check if pattern fits within grid boundaries
+	if (startX + patternRows > gridRows || startY + patternCols > gridCols)
+	{
+		return false;
+	}
+
+	for (int i = 0; i < patternRows; ++i)
+	{
+		for (int j = 0; j < patternCols; ++j)
+		{
+			if (grid.isAlive(startX + i, startY + j) != pattern[i][j])
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+// Function that rotates the pattern by 90 degrees.
+template <typename T>
+vector<vector<T>> rotatePattern(const vector<vector<T>>& pattern)
+{
+	int rows = pattern.size();
+	int cols = pattern[0].size();
+	vector<vector<T>> rotated(cols, vector<T>(rows));
+
+	for (int i = 0; i < rows; ++i)
+	{
+		for (int j = 0; j < cols; ++j)
+		{
+			rotated[j][rows - 1 - i] = pattern[i][j];
+		}
+	}
+	return rotated;
+}
+
+// Function that flips a pattern horizontally
+template <typename T>
+vector<vector<T>> flipHorizontal(const vector<vector<T>>& pattern)
+{
+	int rows = pattern.size();
+	vector<vector<T>> hFlipped = pattern;
+
+	for (int i = 0; i < rows; ++i)
+	{
+		reverse(hFlipped[i].begin(), hFlipped[i].end()); // reverses the elements in a row.
+	}
+	return hFlipped;
+}
+
+// Function that flips a pattern vertically
+template <typename T>
+vector<vector<T>> flipVertical(const vector<vector<T>>& pattern)
+{
+	vector<vector<T>> vFlipped = pattern;
+	reverse(vFlipped.begin(), vFlipped.end()); // reverses the elements in a 2d array column
+
+	return vFlipped;
+}
+
+// Hashing function for 2D vector to prevent duplicate patterns
+template <typename T>
+size_t hashPattern(const vector<vector<T>>& pattern)
+{
+	size_t seed = 0;
+		for (const auto& row : pattern) 
+		{
+			for (const auto& elem : row) 
+			{
+				seed ^= hash<T>{}(elem)+0x9e3779b9 + (seed << 6) + (seed >> 2); // Boost hash combine algorithm 
+			}
+		}
+	return seed;
+}
+
+
+// Generate all pattern variants for multiple uses
+template <typename T>
+vector<vector<vector<T>>> generateAllPatternVariants(const vector<vector<T>>& pattern)
+{
+	vector<vector<vector<T>>> variants;
+	unordered_set<size_t> uniquePatterns; // Ensures only unique patterns aere added to the vector.
+
+	auto addUniqueVariant = [&](const vector<vector<T>>& p) // function to only add unique pattern varients to the set.
+		{
+			size_t hash = hashPattern(p);
+			if (uniquePatterns.insert(hash).second)
+			{
+				variants.push_back(p);
+			}
+		};
+
+	// add original pattern
+	addUniqueVariant(pattern);
+
+
+	// Generate all 90, 180, and 270 degree rotations
+	auto rotated = pattern;
+	for (int i = 0; i < 3; ++i)
+	{
+		rotated = rotatePattern(rotated);
+		addUniqueVariant(rotated);
+	}
+
+	vector<vector<vector<T>>> patternsToFlip = variants;
+
+	// Add horizontal and vertical flips
+	for (const auto& p : patternsToFlip)
+	{
+		addUniqueVariant(flipHorizontal(p));
+		addUniqueVariant(flipVertical(p));
+	}
+
+	return variants;
+}
+
+// Class to store a set of patterns with every rotation and flip generated once, ready to be searched for.
+// A pattern variant as one bitmask per row, with bit j set where column j is alive.
+struct PatternMask
+{
+	int rows;
+	int cols;
+	vector<uint64_t> alive;
+};
+
+class PatternSet
+{
+
+	private:
+		vector<vector<vector<bool>>> variants;
+		vector<PatternMask> masks;
+		int maxRows;
+		int maxCols;
+	public:
+		PatternSet(const vector<vector<vector<bool>>>& patterns) : maxRows(0), maxCols(0)
+		{
+			for (const auto& pattern : patterns)
+			{
+				for (const auto& variant : generateAllPatternVariants(pattern))
+				{
+					variants.push_back(variant);
+					maxRows = max(maxRows, static_cast<int>(variant.size()));
+					maxCols = max(maxCols, static_cast<int>(variant[0].size()));
+
+					PatternMask mask = { static_cast<int>(variant.size()), static_cast<int>(variant[0].size()), vector<uint64_t>(variant.size(), 0) };
+					assert(mask.cols <= 64);
+					for (int i = 0; i < mask.rows; ++i)
+					{
+						for (int j = 0; j < mask.cols; ++j)
+						{
+							mask.alive[i] |= uint64_t(variant[i][j]) << j;
+						}
 					}
-					break;
-				case 2:
-					// Check for blinker or toad after each geneation of cells
-					if (checkForStableOscillator(grid, stableGenerations, currentCycle))
+					masks.push_back(mask);
+				}
+			}
+		}
+
+		// Get functions
+		const vector<vector<vector<bool>>>& getVariants() const { return variants; }
+		const vector<PatternMask>& getMasks() const { return masks; }
+		int getMaxRows() const { return maxRows; }
+		int getMaxCols() const { return maxCols; }
+};
+
+// Function to check whether any variant (rotation or flip) of a set of patterns is at a grid position.
+template <typename T, typename Cell>
+bool matchesPattern(const Grid<T, Cell>& grid, const PatternSet& patterns, int startX, int startY)
+{
+	for (const auto& variant : patterns.getVariants())
+	{
+		if (patternFits(grid, variant, startX, startY))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+// Tests 64 neighbouring positions for one pattern variant at once. band holds packed rows bandWords words wide, and row points at the band row the variant's top row would sit on.
+// Bit b of the result is set when the variant matches exactly with its top left corner at bit b of the given word. Only bits set in candidates are tested.
+inline uint64_t matchMaskWord(const PatternMask& mask, const uint64_t* row, int bandWords, int word, uint64_t candidates)
+{
+	uint64_t match = candidates;
+	for (int i = 0; i < mask.rows && match; ++i, row += bandWords)
+	{
+		uint64_t here = row[word];
+		uint64_t next = word + 1 < bandWords ? row[word + 1] : 0;
+		for (int j = 0; j < mask.cols && match; ++j)
+		{
+			// Bit b of shifted is the cell j columns right of position b
+			uint64_t shifted = j == 0 ? here : (here >> j) | (next << (64 - j));
+			match &= ((mask.alive[i] >> j) & 1u) ? shifted : ~shifted;
+		}
+	}
+	return match;
+}
+
+// Returns a word with the bits for columns [startCol, endCol) of the word starting at column base set.
+inline uint64_t columnRangeMask(int base, int startCol, int endCol)
+{
+	int first = max(0, startCol - base);
+	int last = min(64, endCol - base);
+	if (first >= last)
+	{
+		return 0;
+	}
+	uint64_t upTo = last == 64 ? ~uint64_t(0) : (uint64_t(1) << last) - 1;
+	return upTo & ~((uint64_t(1) << first) - 1);
+}
+
+// Checks every position in one tile for any pattern in the set. Stops early if cancel is set by another tile.
+// The tile and the rows and columns its patterns reach are packed into a band of bits, so each variant is tested against 64 positions per word.
+// With a built activity map its live rows are copied instead of packing the grid, and words with no live cell nearby are skipped.
+template <typename T, typename Cell>
+bool scanTileForPattern(const Grid<T, Cell>& grid, const PatternSet& patterns, int tile, const atomic<bool>* cancel, const ActivityMap* activity = nullptr)
+{
+	int rows = grid.getRows();
+	int cols = grid.getCols();
+	int tilesAcross = (cols + TILE_COLS - 1) / TILE_COLS;
+	int startRow = (tile / tilesAcross) * TILE_ROWS;
+	int startCol = (tile % tilesAcross) * TILE_COLS;
+	int endRow = min(rows, startRow + TILE_ROWS);
+	int endCol = min(cols, startCol + TILE_COLS);
+
+	int bandEndRow = min(rows, endRow + patterns.getMaxRows() - 1);
+	int firstWord = startCol / 64;
+	int bandWords = (min(cols, endCol + patterns.getMaxCols() - 1) + 63) / 64 - firstWord;
+
+	// Buffer is kept per thread so a warm scan allocates nothing.
+	static thread_local vector<uint64_t> band;
+	band.assign(static_cast<size_t>(bandEndRow - startRow) * bandWords, 0);
+	for (int x = startRow; x < bandEndRow; ++x)
+	{
+		uint64_t* bandRow = band.data() + static_cast<size_t>(x - startRow) * bandWords;
+		if (activity)
+		{
+			copy(activity->getLiveRow(x) + firstWord, activity->getLiveRow(x) + firstWord + bandWords, bandRow);
+			continue;
+		}
+		for (int y = firstWord * 64; y < min(cols, (firstWord + bandWords) * 64); ++y)
+		{
+			bandRow[(y / 64) - firstWord] |= uint64_t(grid.isAlive(x, y)) << (y % 64);
+		}
+	}
+
+	for (int x = startRow; x < endRow; ++x)
+	{
+		if (cancel && cancel->load(memory_order_relaxed))
+		{
+			return false;
+		}
+		const uint64_t* bandRow = band.data() + static_cast<size_t>(x - startRow) * bandWords;
+
+		for (int word = 0; (firstWord + word) * 64 < endCol; ++word)
+		{
+			int base = (firstWord + word) * 64;
+			uint64_t positions = columnRangeMask(base, startCol, endCol);
+			if (activity)
+			{
+				positions &= activity->getActiveRow(x)[firstWord + word];
+			}
+			if (!positions)
+			{
+				continue;
+			}
+
+			for (const PatternMask& mask : patterns.getMasks())
+			{
+				// The variant must fit inside the grid
+				if (x + mask.rows > rows)
+				{
+					continue;
+				}
+				uint64_t candidates = positions & columnRangeMask(base, 0, cols - mask.cols + 1);
+				if (candidates && matchMaskWord(mask, bandRow, bandWords, word, candidates))
+				{
+					return true;
+				}
+			}
+		}
+	}
+	return false;
+}
+
+// Returns the activity map built and ready to use if it was written by a step for a grid of this size, otherwise nullptr.
+template <typename T, typename Cell>
+const ActivityMap* usableActivity(const Grid<T, Cell>& grid, ActivityMap* activity)
+{
+	if (!activity || !activity->isReady() || activity->getRows() != grid.getRows() || activity->getCols() != grid.getCols())
+	{
+		return nullptr;
+	}
+	activity->refresh();
+	return activity;
+}
+
+// Searches the grid for any pattern in the set. The grid is split into tiles that are scanned in parallel, each for every variant.
+// The first tile to find a match sets a shared flag that every other tile checks before each position, so all of them stop straight away.
+// A step's activity map is used to skip empty areas when one matching the grid is given.
+template <typename T, typename Cell>
+bool findPattern(const Grid<T, Cell>& grid, const PatternSet& patterns, ActivityMap* activity = nullptr)
+{
+	int tilesDown = (grid.getRows() + TILE_ROWS - 1) / TILE_ROWS;
+	int tilesAcross = (grid.getCols() + TILE_COLS - 1) / TILE_COLS;
+	atomic<bool> found(false);
+	const ActivityMap* skipMap = usableActivity(grid, activity);
+
+	getScheduler().parallelFor(tilesDown * tilesAcross, [&](int tile)
+	{
+		if (scanTileForPattern(grid, patterns, tile, &found, skipMap))
+		{
+			found.store(true, memory_order_relaxed);
+		}
+	});
+	return found.load();
+}
+
+// Keeps every tile's match result between generations and only scans a tile again when cells changed close enough to reach a pattern starting in it.
+class IncrementalDetector
+{
+
+	private:
+		const PatternSet& patterns;
+		int tilesDown;
+		int tilesAcross;
+		vector<unsigned char> tileMatches;
+		vector<int> dirtyTiles;
+	public:
+		IncrementalDetector(const PatternSet& patterns) : patterns(patterns), tilesDown(0), tilesAcross(0) {}
+
+		// Rescans the tiles affected by the changes, clears them and returns whether any pattern is in the grid.
+		template <typename T, typename Cell>
+		bool update(const Grid<T, Cell>& grid, ChangeMap& changes, ActivityMap* activity = nullptr)
+		{
+			if (changes.getTilesDown() != tilesDown || changes.getTilesAcross() != tilesAcross)
+			{
+				tilesDown = changes.getTilesDown();
+				tilesAcross = changes.getTilesAcross();
+				tileMatches.assign(static_cast<size_t>(tilesDown) * tilesAcross, 0);
+				changes.markAll();
+			}
+
+			// A pattern starting in a tile covers cells up to its size below and to the right of it.
+			int reachDown = (patterns.getMaxRows() - 1 + TILE_ROWS - 1) / TILE_ROWS;
+			int reachAcross = (patterns.getMaxCols() - 1 + TILE_COLS - 1) / TILE_COLS;
+
+			dirtyTiles.clear();
+			for (int tileRow = 0; tileRow < tilesDown; ++tileRow)
+			{
+				for (int tileCol = 0; tileCol < tilesAcross; ++tileCol)
+				{
+					bool dirty = false;
+					for (int down = 0; down <= reachDown && !dirty; ++down)
 					{
-						patternFound = true;
-						cout << endl << "Blinker or Toad detected in experiment #" << experimentCount << " after " << currentCycle << " generations!";
-						calculateERN(grid, totalCells, &patternChoice);
+						for (int across = 0; across <= reachAcross && !dirty; ++across)
+						{
+							dirty = changes.isChanged(tileRow + down, tileCol + across);
+						}
 					}
-					break;
-				case 3:
-					// Check for glider or Lwss after each generation of cells
-					if (checkForStableSpaceship(grid, stableGenerations, currentCycle))
+					if (dirty)
 					{
-						patternFound = true;
-						cout << endl << "Glider or LWSS detected in experiment #" << experimentCount << " after " << currentCycle << " generations!";
-						calculateERN(grid, totalCells, &patternChoice);
+						dirtyTiles.push_back(tileRow * tilesAcross + tileCol);
 					}
-					break;
+				}
+			}
+
+			const ActivityMap* skipMap = dirtyTiles.empty() ? nullptr : usableActivity(grid, activity);
+			getScheduler().parallelFor(static_cast<int>(dirtyTiles.size()), [&](int i)
+			{
+				tileMatches[dirtyTiles[i]] = scanTileForPattern(grid, patterns, dirtyTiles[i], nullptr, skipMap) ? 1 : 0;
+			});
+			changes.clear();
+
+			return find(tileMatches.begin(), tileMatches.end(), 1) != tileMatches.end();
+		}
+};
+
+// Function to define a block and beehive. Variants are only generated the first time.
+const PatternSet& getStillLifePatterns()
+{
+	// Define Patterns
+
+	// Block
+
+	vector<vector<bool>> blockPattern = {
+		{true, true},
+		{true, true},
+	};
+
+	// Behive
+
+	vector<vector<bool>> beehivePattern = {
+		{false, true, true, false},
+		{true, false, false, true},
+		{false, true, true, false}
+	};
+
+	static const PatternSet patterns({ blockPattern, beehivePattern });
+	return patterns;
+}
+
+// Function to check to see if the grid contains a block and beehive.
+template <typename T, typename Cell>
+bool isBlockOrBeehive(const Grid<T, Cell>& grid)
+{
+	// Check every position in the grid for the patterns
+	return findPattern(grid, getStillLifePatterns());
+}
+
+// Function to define a blinker and toad. Variants are only generated the first time.
+const PatternSet& getOscillatorPatterns()
+{
+	// Define patterns
+	
+	// Blinker Phase 1
+	
+	vector<vector<bool>> blinkerPhase1 =
+	{
+		{true, true, true}
+	};
+
+	vector<vector<bool>> blinkerPhase2 =
+	{
+		{true},
+		{true},
+		{true}
+	};
+
+	// Toad Phase 1
+	vector<vector<bool>> toadPhase1 =
+	{
+		{false, true, true, true},
+		{true, true, true, false}
+	};
+
+	vector<vector<bool>> toadPhase2 =
+	{
+		{false, false, true, false},
+		{true, false, false, true},
+		{true, false, false, true},
+		{false, true, false, false}
+	};
+
+	static const PatternSet patterns({ blinkerPhase1, blinkerPhase2, toadPhase1, toadPhase2 });
+	return patterns;
+}
+
+// Function to check to see if the grid contains a blinker and toad.
+template <typename T, typename Cell>
+bool isBlinkerOrToad(const Grid<T, Cell>& grid)
+{
+	// Check every position in the grid for the patterns
+	return findPattern(grid, getOscillatorPatterns());
+}
+
+// Function to define a glider and LWSS. Variants are only generated the first time.
+const PatternSet& getSpaceshipPatterns()
+{
+	// Define patterns
+
+	// Glider Phase 1
+	
+	vector<vector<bool>> gliderPhase1 =
+	{
+		{false, true, false},
+		{false, false, true},
+		{true, true, true}
+	};
+
+	// Glider Phase 2
+
+	vector<vector<bool>> gliderPhase2 =
+	{
+		{true, false, true},
+		{false, true, true},
+		{false, true, false}
+	};
+
+	// LWSS Phase 1
+
+	vector<vector<bool>> lwssPhase1 =
+	{
+		{false, true, false, false, true},
+		{true, false, false, false, false},
+		{true, false, false, false, true},
+		{true, true, true, true, false}
+	};
+
+	// LWSS Phase 2
+
+	vector<vector<bool>> lwssPhase2 =
+	{
+		{false, true, true, false, false},
+		{true, true, false, true, true},
+		{false, true, true, true, true},
+		{false, false, true, true, false}
+	};
+	// Don't need other phases as they are just rotations of phase 1 and 2
+
+	static const PatternSet patterns({ gliderPhase1, gliderPhase2, lwssPhase1, lwssPhase2 });
+	return patterns;
+}
+
+// Function to check to see if the grid contains a glider and LWSS.
+template <typename T, typename Cell>
+bool isGliderOrLWSS(const Grid<T, Cell>& grid)
+{
+	// Check every position in the grid for the patterns
+	return findPattern(grid, getSpaceshipPatterns());
+}
+
+// Function to update one tile of cells. The rule is a template parameter so each rule gets its own kernel.
+// Each row's alive flags are read once into a padded byte row, so the inner loop has no branches or calls and can be vectorised.
+// Returns whether any cell in the tile changed.
+template <typename T, typename Cell, typename RuleT>
+bool updateCellsSegment(const Grid<T, Cell>& grid, Grid<T, Cell>& newGrid, int startRow, int endRow, int startCol, int endCol, RuleT rule, ActivityMap* activity = nullptr)
+{
+	using State = typename Grid<T, Cell>::State;
+	using Storage = typename Grid<T, Cell>::Storage;
+	int rows = grid.getRows();
+	int cols = grid.getCols();
+	int width = endCol - startCol;
+
+	// One cell of padding either side of the tile, cells outside the grid stay dead. Kept per thread so a warm pass allocates nothing.
+	static thread_local vector<unsigned char> above;
+	static thread_local vector<unsigned char> current;
+	static thread_local vector<unsigned char> below;
+	above.assign(width + 2, 0);
+	current.assign(width + 2, 0);
+	below.assign(width + 2, 0);
+
+	auto loadRow = [&](int x, vector<unsigned char>& aliveRow)
+	{
+		if (x < 0 || x >= rows)
+		{
+			fill(aliveRow.begin(), aliveRow.end(), 0);
+			return;
+		}
+		const Storage* row = grid.getRow(x);
+		for (int y = startCol - 1; y <= endCol; ++y)
+		{
+			aliveRow[y - startCol + 1] = (y >= 0 && y < cols && Cell::isAlive(State(row[y]))) ? 1 : 0;
+		}
+	};
+
+	loadRow(startRow - 1, above);
+	loadRow(startRow, current);
+	bool changed = false;
+
+	for (int x = startRow; x < endRow; x++)
+	{
+		loadRow(x + 1, below);
+		const Storage* oldRow = grid.getRow(x) + startCol;
+		Storage* newRow = newGrid.getRow(x) + startCol;
+
+		for (int y = 0; y < width; y++)
+		{
+			// calculate neighbours
+			int totalNeighbours = above[y] + above[y + 1] + above[y + 2]
+				+ current[y] + current[y + 2]
+				+ below[y] + below[y + 1] + below[y + 2];
+
+			// birth or survival is decided by the rule's masks
+			bool alive = rule.nextState(current[y + 1] != 0, totalNeighbours);
+			newRow[y] = Storage(Cell::nextState(State(oldRow[y]), alive));
+		}
+		if (!changed && !equal(oldRow, oldRow + width, newRow))
+		{
+			changed = true;
+		}
+		if (activity)
+		{
+			packLiveRow<T, Cell>(*activity, x, startCol, endCol, newRow);
+		}
+
+		// move the window down a row
+		swap(above, current);
+		swap(current, below);
+	}
+	return changed;
+}
+
+// Returns the calling thread's back buffer for stepping a grid of this size. Steps write every cell of it and then swap it with the grid,
+// so the two buffers trade places each generation and stepping the same size of grid again allocates nothing.
+template <typename T, typename Cell>
+Grid<T, Cell>& stepBuffer(int rows, int cols)
+{
+	static thread_local Grid<T, Cell> buffer;
+	if (buffer.getRows() != rows || buffer.getCols() != cols)
+	{
+		buffer.reset(rows, cols);
+	}
+	return buffer;
+}
+
+// Updates Cells in parallel with a compiled rule. The grid is split into tiles that the scheduler hands out to whichever core is free.
+// Tiles with a changed cell are marked in changes if one is given, and the new live cells are written to activity if one is given.
+template <typename T, typename Cell, typename RuleT>
+void UpdateCellsWithRule(Grid<T, Cell> &grid, RuleT rule, ChangeMap* changes = nullptr, ActivityMap* activity = nullptr)
+{
+	int rows = grid.getRows();
+	int cols = grid.getCols();
+	Grid<T, Cell>& newGrid = stepBuffer<T, Cell>(rows, cols);
+	if (activity)
+	{
+		activity->beginStep(rows, cols);
+	}
+
+	int tilesDown = (rows + TILE_ROWS - 1) / TILE_ROWS;
+	int tilesAcross = (cols + TILE_COLS - 1) / TILE_COLS;
+
+	getScheduler().parallelFor(tilesDown * tilesAcross, [&](int tile)
+	{
+		int startRow = (tile / tilesAcross) * TILE_ROWS;
+		int startCol = (tile % tilesAcross) * TILE_COLS;
+		int endRow = min(rows, startRow + TILE_ROWS);
+		int endCol = min(cols, startCol + TILE_COLS);
+		if (updateCellsSegment(grid, newGrid, startRow, endRow, startCol, endCol, rule, activity) && changes)
+		{
+			changes->markCells(startRow, endRow, startCol, endCol);
+		}
+	});
+
+	// swap in the new generation
+	grid.swap(newGrid);
+}
+
+// Updates Cells in parallel using the given rule. Defaults to Conway's B3/S23.
+template <typename T, typename Cell>
+void UpdateCells(Grid<T, Cell>& grid, const RuleSpec& rule = RuleSpec(), ChangeMap* changes = nullptr, ActivityMap* activity = nullptr)
+{
+	dispatchRule(rule, [&](auto compiledRule) { UpdateCellsWithRule(grid, compiledRule, changes, activity); });
+}
+
+// Size of the tiles used by temporal blocking, before the halo is added.
+const int BLOCK_TILE_ROWS = 64;
+const int BLOCK_TILE_COLS = 256;
+const int MAX_BLOCK_DEPTH = 32;
+static_assert(BLOCK_TILE_COLS % 64 == 0, "tiles must cover whole words of the activity map");
+
+// Advances one tile by blockDepth generations. The tile is copied with a blockDepth-cell halo into a local buffer that stays in cache,
+// stepped there, and only its centre is written back. Each generation the valid area shrinks by one cell, so the centre is exact.
+// Returns whether any cell in the tile changed.
+template <typename T, typename Cell, typename RuleT>
+bool updateCellsBlockedTile(const Grid<T, Cell>& grid, Grid<T, Cell>& newGrid, int startRow, int endRow, int startCol, int endCol, int blockDepth, RuleT rule, ActivityMap* activity = nullptr)
+{
+	using State = typename Grid<T, Cell>::State;
+	using Storage = typename Grid<T, Cell>::Storage;
+	int rows = grid.getRows();
+	int cols = grid.getCols();
+	int height = endRow - startRow + 2 * blockDepth;
+	int width = endCol - startCol + 2 * blockDepth;
+	int originRow = startRow - blockDepth;
+	int originCol = startCol - blockDepth;
+	Storage dead = Storage(Cell::makeState(false));
+
+	// Buffers are kept per thread so a warm pass allocates nothing.
+	static thread_local vector<Storage> current;
+	static thread_local vector<Storage> next;
+	current.assign(static_cast<size_t>(height) * width, dead);
+	next.assign(static_cast<size_t>(height) * width, dead);
+
+	// Only the part of the buffer inside the grid can ever hold live cells.
+	int firstRow = max(0, -originRow);
+	int lastRow = min(height, rows - originRow);
+	int firstCol = max(0, -originCol);
+	int lastCol = min(width, cols - originCol);
+
+	for (int x = firstRow; x < lastRow; ++x)
+	{
+		const Storage* row = grid.getRow(originRow + x);
+		copy(row + originCol + firstCol, row + originCol + lastCol, current.begin() + static_cast<size_t>(x) * width + firstCol);
+	}
+
+	for (int step = 1; step <= blockDepth; ++step)
+	{
+		for (int x = max(step, firstRow); x < min(height - step, lastRow); ++x)
+		{
+			const Storage* above = current.data() + static_cast<size_t>(x - 1) * width;
+			const Storage* middle = current.data() + static_cast<size_t>(x) * width;
+			const Storage* below = current.data() + static_cast<size_t>(x + 1) * width;
+			Storage* out = next.data() + static_cast<size_t>(x) * width;
+
+			for (int y = max(step, firstCol); y < min(width - step, lastCol); ++y)
+			{
+				int totalNeighbours = Cell::isAlive(State(above[y - 1])) + Cell::isAlive(State(above[y])) + Cell::isAlive(State(above[y + 1]))
+					+ Cell::isAlive(State(middle[y - 1])) + Cell::isAlive(State(middle[y + 1]))
+					+ Cell::isAlive(State(below[y - 1])) + Cell::isAlive(State(below[y])) + Cell::isAlive(State(below[y + 1]));
+
+				bool alive = rule.nextState(Cell::isAlive(State(middle[y])), totalNeighbours);
+				out[y] = Storage(Cell::nextState(State(middle[y]), alive));
+			}
+		}
+		current.swap(next);
+	}
+
+	bool changed = false;
+	for (int x = startRow; x < endRow; ++x)
+	{
+		const Storage* tileRow = current.data() + static_cast<size_t>(x - originRow) * width;
+		if (!changed && !equal(tileRow + blockDepth, tileRow + blockDepth + (endCol - startCol), grid.getRow(x) + startCol))
+		{
+			changed = true;
+		}
+		copy(tileRow + blockDepth, tileRow + blockDepth + (endCol - startCol), newGrid.getRow(x) + startCol);
+		if (activity)
+		{
+			packLiveRow<T, Cell>(*activity, x, startCol, endCol, tileRow + blockDepth);
+		}
+	}
+	return changed;
+}
+
+// Advances the grid by blockDepth generations in one pass over memory using a compiled rule.
+template <typename T, typename Cell, typename RuleT>
+void UpdateCellsBlockedWithRule(Grid<T, Cell>& grid, int blockDepth, RuleT rule, ChangeMap* changes = nullptr, ActivityMap* activity = nullptr)
+{
+	int rows = grid.getRows();
+	int cols = grid.getCols();
+	Grid<T, Cell>& newGrid = stepBuffer<T, Cell>(rows, cols);
+	if (activity)
+	{
+		activity->beginStep(rows, cols);
+	}
+
+	int tilesDown = (rows + BLOCK_TILE_ROWS - 1) / BLOCK_TILE_ROWS;
+	int tilesAcross = (cols + BLOCK_TILE_COLS - 1) / BLOCK_TILE_COLS;
+
+	getScheduler().parallelFor(tilesDown * tilesAcross, [&](int tile)
+	{
+		int startRow = (tile / tilesAcross) * BLOCK_TILE_ROWS;
+		int startCol = (tile % tilesAcross) * BLOCK_TILE_COLS;
+		int endRow = min(rows, startRow + BLOCK_TILE_ROWS);
+		int endCol = min(cols, startCol + BLOCK_TILE_COLS);
+		if (updateCellsBlockedTile(grid, newGrid, startRow, endRow, startCol, endCol, blockDepth, rule, activity) && changes)
+		{
+			changes->markCells(startRow, endRow, startCol, endCol);
+		}
+	});
+
+	grid.swap(newGrid);
+}
+
+// Advances the grid by a number of generations. Temporal blocking is used when blockDepth is above 1, which gives the same grid as stepping one generation at a time.
+// Only the last pass writes the activity map, as it is the only one detectors see.
+template <typename T, typename Cell>
+void advanceGenerations(Grid<T, Cell>& grid, int generations, const RuleSpec& rule, int blockDepth, ChangeMap* changes = nullptr, ActivityMap* activity = nullptr)
+{
+	blockDepth = max(1, min(blockDepth, MAX_BLOCK_DEPTH));
+	while (generations > 0)
+	{
+		int depth = min(generations, blockDepth);
+		ActivityMap* passActivity = depth == generations ? activity : nullptr;
+		if (depth == 1)
+		{
+			UpdateCells(grid, rule, changes, passActivity);
+		}
+		else
+		{
+			dispatchRule(rule, [&](auto compiledRule) { UpdateCellsBlockedWithRule(grid, depth, compiledRule, changes, passActivity); });
+		}
+		generations -= depth;
+	}
+}
+
+// BIT KERNELS
+
+// Returns the number of set bits in a word, one instruction on any CPU from the last decade.
+inline int countBits(uint64_t word)
+{
+#ifdef _MSC_VER
+	return static_cast<int>(__popcnt64(word));
+#else
+	return __builtin_popcountll(word);
+#endif
+}
+
+// Shades of the density overview from empty to at least half alive.
+const string DENSITY_SHADES = " .:-=+*#%@";
+
+// Counts the live cells of each block of packed rows, rowStride words apart. The rows and columns are split as evenly as they go into
+// outRows x outCols blocks and counts gets one entry per block. Every word is read once and counted with a popcount, the blocks it
+// straddles taking their bits through masks, so an overview of a grid costs a small part of one step of it.
+void densityCounts(const uint64_t* cells, size_t rowStride, int64_t rows, int cols, int outRows, int outCols, vector<uint32_t>& counts)
+{
+	counts.assign(static_cast<size_t>(outRows) * outCols, 0);
+	getScheduler().parallelFor(outRows, [&](int blockRow)
+	{
+		int64_t firstRow = blockRow * rows / outRows;
+		int64_t endRow = (blockRow + 1) * rows / outRows;
+		uint32_t* rowCounts = &counts[static_cast<size_t>(blockRow) * outCols];
+		for (int64_t x = firstRow; x < endRow; ++x)
+		{
+			const uint64_t* row = cells + static_cast<size_t>(x) * rowStride;
+			for (int blockCol = 0; blockCol < outCols; ++blockCol)
+			{
+				int startCol = static_cast<int>(int64_t(blockCol) * cols / outCols);
+				int endCol = static_cast<int>(int64_t(blockCol + 1) * cols / outCols);
+				for (int word = startCol / 64; word * 64 < endCol; ++word)
+				{
+					rowCounts[blockCol] += countBits(row[word] & columnRangeMask(word * 64, startCol, endCol));
+				}
+			}
+		}
+	});
+}
+
+// Returns the shade for a block with count live cells out of area.
+inline char densityShade(uint32_t count, uint64_t area)
+{
+	if (count == 0 || area == 0)
+	{
+		return DENSITY_SHADES[0];
+	}
+	size_t shade = 1 + static_cast<size_t>(16.0 * count / area);
+	return DENSITY_SHADES[min(shade, DENSITY_SHADES.size() - 1)];
+}
+
+// Draws a zoomed out view of packed rows in the renderer's viewport, each cell on screen shaded by the live cells of its block.
+void drawDensityOverview(TerminalRenderer& renderer, const uint64_t* cells, size_t rowStride, int64_t rows, int cols, int64_t generation)
+{
+	static thread_local vector<uint32_t> counts;
+	int outRows = static_cast<int>(min<int64_t>(renderer.getViewRows(), rows));
+	int outCols = min(renderer.getViewCols(), cols);
+	densityCounts(cells, rowStride, rows, cols, outRows, outCols, counts);
+	renderer.drawIcons(outRows, outCols, [&](int x, int y)
+	{
+		uint64_t area = uint64_t((x + 1) * rows / outRows - x * rows / outRows) * uint64_t(int64_t(y + 1) * cols / outCols - int64_t(y) * cols / outCols);
+		return densityShade(counts[static_cast<size_t>(x) * outCols + y], area);
+	}, "Generation " + to_string(generation) + ", overview of " + to_string(rows) + " x " + to_string(cols) + " in blocks of about "
+		+ to_string((rows + outRows - 1) / outRows) + " x " + to_string((cols + outCols - 1) / outCols));
+}
+
+// Adds three one-bit planes, giving a sum bit and a carry bit for each of the 64 cells.
+inline void fullAdd(uint64_t a, uint64_t b, uint64_t c, uint64_t& sum, uint64_t& carry)
+{
+	uint64_t partial = a ^ b;
+	sum = partial ^ c;
+	carry = (a & b) | (partial & c);
+}
+
+// Steps 64 cells at once. Each word holds one row of cells, bit j being column j, and the eight neighbour words are already shifted into line.
+// The neighbour counts are added bit-sliced into four count planes and the rule's masks pick which counts give a live cell.
+template <typename RuleT>
+inline uint64_t stepWord(uint64_t upLeft, uint64_t up, uint64_t upRight, uint64_t left, uint64_t alive, uint64_t right,
+	uint64_t downLeft, uint64_t down, uint64_t downRight, RuleT rule)
+{
+	uint64_t sumA, carryA, sumB, carryB;
+	fullAdd(upLeft, up, upRight, sumA, carryA);
+	fullAdd(left, right, downLeft, sumB, carryB);
+	uint64_t sumC = down ^ downRight;
+	uint64_t carryC = down & downRight;
+
+	// ones, then the four carries worth two each, then the fours
+	uint64_t count0, carryOnes, twos, foursA;
+	fullAdd(sumA, sumB, sumC, count0, carryOnes);
+	fullAdd(carryA, carryB, carryC, twos, foursA);
+	uint64_t count1 = twos ^ carryOnes;
+	uint64_t foursB = twos & carryOnes;
+	uint64_t count2 = foursA ^ foursB;
+	uint64_t count3 = foursA & foursB;
+
+	uint64_t next = 0;
+	for (int n = 0; n <= 8; ++n)
+	{
+		bool birth = ((rule.birth >> n) & 1u) != 0;
+		bool survival = ((rule.survival >> n) & 1u) != 0;
+		if (!birth && !survival)
+		{
+			continue;
+		}
+		uint64_t matches = ((n & 1) ? count0 : ~count0) & ((n & 2) ? count1 : ~count1) & ((n & 4) ? count2 : ~count2) & ((n & 8) ? count3 : ~count3);
+		if (birth && survival)
+		{
+			next |= matches;
+		}
+		else if (birth)
+		{
+			next |= matches & ~alive;
+		}
+		else
+		{
+			next |= matches & alive;
+		}
+	}
+	return next;
+}
+
+// Steps one row of 64 cells given the rows above, at and below it and the words from the tiles either side.
+template <typename RuleT>
+inline uint64_t stepRowWord(uint64_t upWest, uint64_t up, uint64_t upEast, uint64_t west, uint64_t alive, uint64_t east,
+	uint64_t downWest, uint64_t down, uint64_t downEast, RuleT rule)
+{
+	return stepWord((up << 1) | (upWest >> 63), up, (up >> 1) | (upEast << 63),
+		(alive << 1) | (west >> 63), alive, (alive >> 1) | (east << 63),
+		(down << 1) | (downWest >> 63), down, (down >> 1) | (downEast << 63), rule);
+}
+
+// Steps words [firstWord, endWord) of a row of packed cells, bit j of word k being column 64k + j. Rows outside the grid are passed as all zero words.
+// lastMask keeps the unused bits of the last word dead.
+template <typename RuleT>
+void stepPackedWords(const uint64_t* up, const uint64_t* row, const uint64_t* down, uint64_t* out, int words, int firstWord, int endWord, uint64_t lastMask, RuleT rule)
+{
+	for (int k = firstWord; k < endWord; ++k)
+	{
+		bool west = k > 0;
+		bool east = k + 1 < words;
+		out[k] = stepRowWord(west ? up[k - 1] : 0, up[k], east ? up[k + 1] : 0,
+			west ? row[k - 1] : 0, row[k], east ? row[k + 1] : 0,
+			west ? down[k - 1] : 0, down[k], east ? down[k + 1] : 0, rule);
+	}
+	if (endWord == words)
+	{
+		out[words - 1] &= lastMask;
+	}
+}
+
+// Steps one whole row of packed cells.
+template <typename RuleT>
+void stepPackedRow(const uint64_t* up, const uint64_t* row, const uint64_t* down, uint64_t* out, int words, uint64_t lastMask, RuleT rule)
+{
+	stepPackedWords(up, row, down, out, words, 0, words, lastMask, rule);
+}
+
+// A 64x64 block of cells, one word per row.
+struct BitTile
+{
+	uint64_t rows[64];
+};
+
+// Steps a whole tile. Neighbour tiles outside the grid are passed as nullptr and read as dead.
+// neighbours is ordered north-west, north, north-east, west, east, south-west, south, south-east.
+template <typename RuleT>
+void stepBitTile(const BitTile& centre, const BitTile* const neighbours[8], BitTile& out, int validRows, uint64_t validCols, RuleT rule)
+{
+	auto word = [](const BitTile* tile, int row) -> uint64_t { return tile ? tile->rows[row] : 0; };
+	const BitTile* west = neighbours[3];
+	const BitTile* east = neighbours[4];
+
+	for (int r = 0; r < 64; ++r)
+	{
+		if (r >= validRows)
+		{
+			out.rows[r] = 0;
+			continue;
+		}
+		uint64_t upWest, up, upEast, downWest, down, downEast;
+		if (r > 0)
+		{
+			upWest = word(west, r - 1);
+			up = centre.rows[r - 1];
+			upEast = word(east, r - 1);
+		}
+		else
+		{
+			upWest = word(neighbours[0], 63);
+			up = word(neighbours[1], 63);
+			upEast = word(neighbours[2], 63);
+		}
+		if (r < 63)
+		{
+			downWest = word(west, r + 1);
+			down = centre.rows[r + 1];
+			downEast = word(east, r + 1);
+		}
+		else
+		{
+			downWest = word(neighbours[5], 0);
+			down = word(neighbours[6], 0);
+			downEast = word(neighbours[7], 0);
+		}
+		out.rows[r] = stepRowWord(upWest, up, upEast, word(west, r), centre.rows[r], word(east, r), downWest, down, downEast, rule) & validCols;
+	}
+}
+
+// Interleaves the bits of a tile's row and column to give its position along the Z-order curve.
+inline uint64_t mortonCode(uint32_t tileRow, uint32_t tileCol)
+{
+	uint64_t code = 0;
+	for (int bit = 0; bit < 32; ++bit)
+	{
+		code |= static_cast<uint64_t>((tileCol >> bit) & 1u) << (2 * bit);
+		code |= static_cast<uint64_t>((tileRow >> bit) & 1u) << (2 * bit + 1);
+	}
+	return code;
+}
+
+// Grid of single-bit cells stored as 64x64 tiles laid out along a Z-order curve.
+// Vertically adjacent cells sit in neighbouring words of the same tile and nearby tiles sit nearby in memory, which suits very large grids.
+class MortonTiledGrid
+{
+
+	private:
+		int rows;
+		int cols;
+		int tilesDown;
+		int tilesAcross;
+		vector<int> slotOfTile; // tile (row * tilesAcross + col) to its position in tiles
+		vector<int> tileOfSlot;
+		vector<BitTile> tiles;
+		vector<BitTile> nextTiles;
+
+		const BitTile* tileAt(int tileRow, int tileCol) const
+		{
+			if (tileRow < 0 || tileRow >= tilesDown || tileCol < 0 || tileCol >= tilesAcross)
+			{
+				return nullptr;
+			}
+			return &tiles[slotOfTile[tileRow * tilesAcross + tileCol]];
+		}
+
+	public:
+		MortonTiledGrid() : rows(0), cols(0), tilesDown(0), tilesAcross(0) {}
+
+		MortonTiledGrid(int rows, int cols)
+			: rows(rows), cols(cols), tilesDown((rows + 63) / 64), tilesAcross((cols + 63) / 64)
+		{
+			int numTiles = tilesDown * tilesAcross;
+			tileOfSlot.resize(numTiles);
+			for (int i = 0; i < numTiles; ++i)
+			{
+				tileOfSlot[i] = i;
+			}
+			sort(tileOfSlot.begin(), tileOfSlot.end(), [&](int a, int b)
+			{
+				return mortonCode(a / tilesAcross, a % tilesAcross) < mortonCode(b / tilesAcross, b % tilesAcross);
+			});
+			slotOfTile.resize(numTiles);
+			for (int slot = 0; slot < numTiles; ++slot)
+			{
+				slotOfTile[tileOfSlot[slot]] = slot;
+			}
+			tiles.assign(numTiles, BitTile());
+			nextTiles.assign(numTiles, BitTile());
+		}
+
+		// Get functions
+		int getRows() const { return rows; }
+		int getCols() const { return cols; }
+
+		bool isAlive(int x, int y) const
+		{
+			return (tiles[slotOfTile[(x / 64) * tilesAcross + y / 64]].rows[x % 64] >> (y % 64)) & 1u;
+		}
+
+		// Set functions
+		void setAlive(int x, int y, bool alive)
+		{
+			uint64_t& word = tiles[slotOfTile[(x / 64) * tilesAcross + y / 64]].rows[x % 64];
+			uint64_t bit = uint64_t(1) << (y % 64);
+			word = alive ? (word | bit) : (word & ~bit);
+		}
+
+		// Sets every cell to dead without reallocating.
+		void clear()
+		{
+			fill(tiles.begin(), tiles.end(), BitTile());
+		}
+
+		bool allDead() const
+		{
+			for (const BitTile& tile : tiles)
+			{
+				for (uint64_t word : tile.rows)
+				{
+					if (word)
+					{
+						return false;
+					}
+				}
+			}
+			return true;
+		}
+
+		// Advances one generation. Tiles are handed out in Z-order so each worker walks through nearby memory.
+		template <typename RuleT>
+		void step(RuleT rule, ChangeMap* changes = nullptr, ActivityMap* activity = nullptr)
+		{
+			if (activity)
+			{
+				activity->beginStep(rows, cols);
+			}
+			getScheduler().parallelFor(static_cast<int>(tiles.size()), [&](int slot)
+			{
+				int tile = tileOfSlot[slot];
+				int tileRow = tile / tilesAcross;
+				int tileCol = tile % tilesAcross;
+				const BitTile* neighbours[8] = {
+					tileAt(tileRow - 1, tileCol - 1), tileAt(tileRow - 1, tileCol), tileAt(tileRow - 1, tileCol + 1),
+					tileAt(tileRow, tileCol - 1), tileAt(tileRow, tileCol + 1),
+					tileAt(tileRow + 1, tileCol - 1), tileAt(tileRow + 1, tileCol), tileAt(tileRow + 1, tileCol + 1)
+				};
+				int validRows = min(64, rows - tileRow * 64);
+				int colsInTile = min(64, cols - tileCol * 64);
+				uint64_t validCols = colsInTile == 64 ? ~uint64_t(0) : (uint64_t(1) << colsInTile) - 1;
+				stepBitTile(tiles[slot], neighbours, nextTiles[slot], validRows, validCols, rule);
+				if (changes && !equal(begin(tiles[slot].rows), end(tiles[slot].rows), begin(nextTiles[slot].rows)))
+				{
+					changes->markCells(tileRow * 64, tileRow * 64 + validRows, tileCol * 64, tileCol * 64 + colsInTile);
+				}
+				if (activity)
+				{
+					// Each tile row is already one word of the live bitmap
+					for (int x = 0; x < validRows; ++x)
+					{
+						activity->getLiveRow(tileRow * 64 + x)[tileCol] = nextTiles[slot].rows[x];
+					}
+				}
+			});
+			tiles.swap(nextTiles);
+		}
+};
+
+// Grid of single-bit cells that only stores the 64x64 tiles with live cells in them, found through a hash map.
+// A tile is taken from a pool when a live cell could spread into it and handed back once it is empty, so memory follows the occupied area
+// rather than the size of the grid, while each tile is still stepped a word at a time by stepBitTile.
+class SparseTileGrid
+{
+
+	private:
+		int rows;
+		int cols;
+		int tilesDown;
+		int tilesAcross;
+		unordered_map<uint64_t, int> slotOfTile; // (tile row << 32 | tile col) to its position in the pool
+		vector<BitTile> pool;
+		vector<BitTile> nextPool;
+		vector<uint64_t> keyOfSlot;
+		vector<int> freeSlots;
+		vector<int> occupied; // slots in use, in the order they are stepped
+
+		static uint64_t tileKey(int tileRow, int tileCol) { return (uint64_t(uint32_t(tileRow)) << 32) | uint32_t(tileCol); }
+
+		const BitTile* tileAt(int tileRow, int tileCol) const
+		{
+			auto found = slotOfTile.find(tileKey(tileRow, tileCol));
+			return found == slotOfTile.end() ? nullptr : &pool[found->second];
+		}
+
+		// Returns the slot of a tile, taking an empty one from the pool if it has none. The tile must be inside the grid.
+		int acquireTile(int tileRow, int tileCol)
+		{
+			uint64_t key = tileKey(tileRow, tileCol);
+			auto found = slotOfTile.find(key);
+			if (found != slotOfTile.end())
+			{
+				return found->second;
+			}
+			int slot;
+			if (!freeSlots.empty())
+			{
+				slot = freeSlots.back();
+				freeSlots.pop_back();
+				pool[slot] = BitTile();
+				keyOfSlot[slot] = key;
+			}
+			else
+			{
+				slot = static_cast<int>(pool.size());
+				pool.push_back(BitTile());
+				nextPool.push_back(BitTile());
+				keyOfSlot.push_back(key);
+			}
+			slotOfTile.emplace(key, slot);
+			occupied.push_back(slot);
+			return slot;
+		}
+
+		// Takes a tile for the neighbour in direction (dRow, dCol) of a tile if it is inside the grid.
+		void acquireNeighbour(int tileRow, int tileCol, int dRow, int dCol)
+		{
+			int row = tileRow + dRow;
+			int col = tileCol + dCol;
+			if (row >= 0 && row < tilesDown && col >= 0 && col < tilesAcross)
+			{
+				acquireTile(row, col);
+			}
+		}
+
+	public:
+		SparseTileGrid() : rows(0), cols(0), tilesDown(0), tilesAcross(0) {}
+
+		SparseTileGrid(int rows, int cols) : rows(rows), cols(cols), tilesDown((rows + 63) / 64), tilesAcross((cols + 63) / 64) {}
+
+		// Get functions
+		int getRows() const { return rows; }
+		int getCols() const { return cols; }
+		int getOccupiedTiles() const { return static_cast<int>(occupied.size()); }
+		int getPooledTiles() const { return static_cast<int>(pool.size()); }
+
+		bool isAlive(int x, int y) const
+		{
+			const BitTile* tile = tileAt(x / 64, y / 64);
+			return tile && ((tile->rows[x % 64] >> (y % 64)) & 1u);
+		}
+
+		// Set functions
+		void setAlive(int x, int y, bool alive)
+		{
+			if (!alive && !tileAt(x / 64, y / 64))
+			{
+				return;
+			}
+			uint64_t& word = pool[acquireTile(x / 64, y / 64)].rows[x % 64];
+			uint64_t bit = uint64_t(1) << (y % 64);
+			word = alive ? (word | bit) : (word & ~bit);
+		}
+
+		// Hands every tile back to the pool, leaving all cells dead.
+		void clear()
+		{
+			for (int slot : occupied)
+			{
+				freeSlots.push_back(slot);
+			}
+			occupied.clear();
+			slotOfTile.clear();
+		}
+
+		bool allDead() const
+		{
+			for (int slot : occupied)
+			{
+				for (uint64_t word : pool[slot].rows)
+				{
+					if (word)
+					{
+						return false;
+					}
+				}
+			}
+			return true;
+		}
+
+		// Advances one generation. First every tile a live cell on an edge could spread into is taken from the pool, then the occupied tiles
+		// are stepped in parallel, and tiles left empty go back to the pool. Rules with B0 bring empty space to life, so every tile is taken for them.
+		template <typename RuleT>
+		void step(RuleT rule, ChangeMap* changes = nullptr, ActivityMap* activity = nullptr)
+		{
+			if ((rule.birth & 1u) != 0)
+			{
+				for (int tileRow = 0; tileRow < tilesDown; ++tileRow)
+				{
+					for (int tileCol = 0; tileCol < tilesAcross; ++tileCol)
+					{
+						acquireTile(tileRow, tileCol);
+					}
+				}
+			}
+			else
+			{
+				size_t current = occupied.size();
+				for (size_t i = 0; i < current; ++i)
+				{
+					const BitTile& tile = pool[occupied[i]];
+					int tileRow = static_cast<int>(keyOfSlot[occupied[i]] >> 32);
+					int tileCol = static_cast<int>(uint32_t(keyOfSlot[occupied[i]]));
+					uint64_t westEdge = 0;
+					uint64_t eastEdge = 0;
+					for (uint64_t word : tile.rows)
+					{
+						westEdge |= word & 1u;
+						eastEdge |= word >> 63;
+					}
+					uint64_t top = tile.rows[0];
+					uint64_t bottom = tile.rows[63];
+					if (top) { acquireNeighbour(tileRow, tileCol, -1, 0); }
+					if (bottom) { acquireNeighbour(tileRow, tileCol, 1, 0); }
+					if (westEdge) { acquireNeighbour(tileRow, tileCol, 0, -1); }
+					if (eastEdge) { acquireNeighbour(tileRow, tileCol, 0, 1); }
+					if (top & 1u) { acquireNeighbour(tileRow, tileCol, -1, -1); }
+					if (top >> 63) { acquireNeighbour(tileRow, tileCol, -1, 1); }
+					if (bottom & 1u) { acquireNeighbour(tileRow, tileCol, 1, -1); }
+					if (bottom >> 63) { acquireNeighbour(tileRow, tileCol, 1, 1); }
+				}
+			}
+
+			if (activity)
+			{
+				// Tiles that are not stored are dead. The map clears the tiles written last time, and only the stored tiles are written now
+				activity->beginTileStep(rows, cols);
+				for (int slot : occupied)
+				{
+					activity->markTile(static_cast<int>(keyOfSlot[slot] >> 32), static_cast<int>(uint32_t(keyOfSlot[slot])));
+				}
+			}
+
+			getScheduler().parallelFor(static_cast<int>(occupied.size()), [&](int i)
+			{
+				int slot = occupied[i];
+				int tileRow = static_cast<int>(keyOfSlot[slot] >> 32);
+				int tileCol = static_cast<int>(uint32_t(keyOfSlot[slot]));
+				const BitTile* neighbours[8] = {
+					tileAt(tileRow - 1, tileCol - 1), tileAt(tileRow - 1, tileCol), tileAt(tileRow - 1, tileCol + 1),
+					tileAt(tileRow, tileCol - 1), tileAt(tileRow, tileCol + 1),
+					tileAt(tileRow + 1, tileCol - 1), tileAt(tileRow + 1, tileCol), tileAt(tileRow + 1, tileCol + 1)
+				};
+				int validRows = min(64, rows - tileRow * 64);
+				int colsInTile = min(64, cols - tileCol * 64);
+				uint64_t validCols = colsInTile == 64 ? ~uint64_t(0) : (uint64_t(1) << colsInTile) - 1;
+				stepBitTile(pool[slot], neighbours, nextPool[slot], validRows, validCols, rule);
+				if (changes && !equal(begin(pool[slot].rows), end(pool[slot].rows), begin(nextPool[slot].rows)))
+				{
+					changes->markCells(tileRow * 64, tileRow * 64 + validRows, tileCol * 64, tileCol * 64 + colsInTile);
+				}
+				if (activity)
+				{
+					for (int x = 0; x < validRows; ++x)
+					{
+						activity->getLiveRow(tileRow * 64 + x)[tileCol] = nextPool[slot].rows[x];
+					}
+				}
+			});
+			pool.swap(nextPool);
+
+			// Hand empty tiles back to the pool
+			size_t kept = 0;
+			for (int slot : occupied)
+			{
+				if (all_of(begin(pool[slot].rows), end(pool[slot].rows), [](uint64_t word) { return word == 0; }))
+				{
+					slotOfTile.erase(keyOfSlot[slot]);
+					freeSlots.push_back(slot);
+				}
+				else
+				{
+					occupied[kept++] = slot;
+				}
+			}
+			occupied.resize(kept);
+		}
+};
+
+// DISTRIBUTED
+
+// Memory that forked worker processes all see. Where processes cannot share memory it is ordinary memory, and the workers run as threads instead.
+class SharedBuffer
+{
+
+	private:
+		unsigned char* data;
+		size_t bytes;
+		bool shared;
+	public:
+		SharedBuffer(size_t size) : data(nullptr), bytes(max(size, size_t(1))), shared(false)
+		{
+#ifndef _WIN32
+			void* mapping = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+			if (mapping != MAP_FAILED)
+			{
+				data = static_cast<unsigned char*>(mapping);
+				shared = true;
+				return;
+			}
+#endif
+			data = new unsigned char[bytes]();
+		}
+
+		~SharedBuffer()
+		{
+#ifndef _WIN32
+			if (shared)
+			{
+				munmap(data, bytes);
+				return;
+			}
+#endif
+			delete[] data;
+		}
+
+		SharedBuffer(const SharedBuffer&) = delete;
+		SharedBuffer& operator=(const SharedBuffer&) = delete;
+
+		// Get functions
+		unsigned char* getData() const { return data; }
+		size_t getBytes() const { return bytes; }
+		bool isShared() const { return shared; }
+};
+
+// Passes the boundary rows of each slab to the slabs above and below it once per generation. Slab s sends its top row up and its bottom row down,
+// and receives the bottom row of slab s - 1 and the top row of slab s + 1 into its halo rows. Slabs at the edge of the grid receive dead rows.
+class HaloTransport
+{
+
+	public:
+		virtual ~HaloTransport() = default;
+
+		virtual void sendEdges(int slab, int generation, const uint64_t* top, const uint64_t* bottom) = 0;
+		virtual void receiveHalos(int slab, int generation, uint64_t* above, uint64_t* below) = 0;
+
+		// Closes the ends of the transport that slab does not use, so a failed neighbour is seen as a closed end. A slab of -1 closes every end,
+		// as the parent does once its workers are forked.
+		virtual void keepSlab(int) {}
+
+		// Tells every slab still waiting for rows to give up, after a worker has failed.
+		virtual void abort() {}
+};
+
+// Transport through a mailbox per slab and direction in shared memory. Each mailbox holds two rows used on alternate generations and a counter of
+// the generations sent. A neighbour can only be a generation ahead, as it waits for this slab's rows before it can move on, so two rows are enough.
+// An abort flag ahead of the mailboxes lets the parent stop workers that are waiting on a failed one. Such a worker exits, as SocketTransport's do.
+class SharedMemoryTransport : public HaloTransport
+{
+
+	private:
+		static const size_t HEADER_BYTES = 64; // keeps each counter on its own cache line
+		int slabs;
+		int words;
+		size_t mailboxBytes;
+		SharedBuffer memory;
+		int parent; // process that forked the workers, or 0 if the slabs are threads
+
+		atomic<int>* abortFlag() const
+		{
+			return reinterpret_cast<atomic<int>*>(memory.getData());
+		}
+
+		atomic<int>* sentCounter(int slab, int direction) const
+		{
+			return reinterpret_cast<atomic<int>*>(memory.getData() + HEADER_BYTES + (static_cast<size_t>(slab) * 2 + direction) * mailboxBytes);
+		}
+
+		uint64_t* row(int slab, int direction, int generation) const
+		{
+			unsigned char* mailbox = memory.getData() + HEADER_BYTES + (static_cast<size_t>(slab) * 2 + direction) * mailboxBytes;
+			return reinterpret_cast<uint64_t*>(mailbox + HEADER_BYTES) + static_cast<size_t>(generation % 2) * words;
+		}
+
+		// Waits for a neighbour's row. A worker process gives up if it is aborted or its parent has gone, as nobody would ever read its rows.
+		void waitFor(int slab, int direction, int generation) const
+		{
+			for (unsigned int spins = 0; sentCounter(slab, direction)->load(memory_order_acquire) <= generation; ++spins)
+			{
+#ifndef _WIN32
+				if (parent != 0 && (abortFlag()->load(memory_order_relaxed) != 0 || (spins % 1024 == 0 && getppid() != parent)))
+				{
+					_exit(1);
+				}
+#endif
+				this_thread::yield();
+			}
+		}
+
+	public:
+		static const int UP = 0;
+		static const int DOWN = 1;
+
+		SharedMemoryTransport(int slabs, int words, bool useProcesses = false)
+			: slabs(slabs), words(words), mailboxBytes(HEADER_BYTES + 2 * words * sizeof(uint64_t)),
+			memory(HEADER_BYTES + static_cast<size_t>(slabs) * 2 * mailboxBytes), parent(0)
+		{
+#ifndef _WIN32
+			if (useProcesses)
+			{
+				parent = static_cast<int>(getpid());
+			}
+#endif
+			new (abortFlag()) atomic<int>(0);
+			for (int slab = 0; slab < slabs; ++slab)
+			{
+				new (sentCounter(slab, UP)) atomic<int>(0);
+				new (sentCounter(slab, DOWN)) atomic<int>(0);
+			}
+		}
+
+		// Get functions
+		bool isShared() const { return memory.isShared(); }
+
+		void abort() override
+		{
+			abortFlag()->store(1, memory_order_relaxed);
+		}
+
+		void sendEdges(int slab, int generation, const uint64_t* top, const uint64_t* bottom) override
+		{
+			copy(top, top + words, row(slab, UP, generation));
+			copy(bottom, bottom + words, row(slab, DOWN, generation));
+			sentCounter(slab, UP)->store(generation + 1, memory_order_release);
+			sentCounter(slab, DOWN)->store(generation + 1, memory_order_release);
+		}
+
+		void receiveHalos(int slab, int generation, uint64_t* above, uint64_t* below) override
+		{
+			if (slab > 0)
+			{
+				waitFor(slab - 1, DOWN, generation);
+				const uint64_t* sent = row(slab - 1, DOWN, generation);
+				copy(sent, sent + words, above);
+			}
+			else
+			{
+				fill(above, above + words, 0);
+			}
+			if (slab + 1 < slabs)
+			{
+				waitFor(slab + 1, UP, generation);
+				const uint64_t* sent = row(slab + 1, UP, generation);
+				copy(sent, sent + words, below);
+			}
+			else
+			{
+				fill(below, below + words, 0);
+			}
+		}
+};
+
+#ifndef _WIN32
+// Transport through a Unix domain socket pair between each two neighbouring slabs. The streams keep rows in order so no generation counter is needed.
+class SocketTransport : public HaloTransport
+{
+
+	private:
+		int slabs;
+		int words;
+		vector<int> upSockets; // the socket slab s shares with slab s - 1
+		vector<int> downSockets; // the socket slab s shares with slab s + 1
+		bool ready;
+
+		void sendRow(int socket, const uint64_t* row) const
+		{
+			const char* data = reinterpret_cast<const char*>(row);
+			size_t left = words * sizeof(uint64_t);
+			while (left > 0)
+			{
+				ssize_t sent = send(socket, data, left, 0);
+				if (sent <= 0)
+				{
+					_exit(1);
+				}
+				data += sent;
+				left -= sent;
+			}
+		}
+
+		void receiveRow(int socket, uint64_t* row) const
+		{
+			char* data = reinterpret_cast<char*>(row);
+			size_t left = words * sizeof(uint64_t);
+			while (left > 0)
+			{
+				ssize_t received = recv(socket, data, left, 0);
+				if (received <= 0)
+				{
+					_exit(1);
+				}
+				data += received;
+				left -= received;
+			}
+		}
+
+	public:
+		SocketTransport(int slabs, int words) : slabs(slabs), words(words), upSockets(slabs, -1), downSockets(slabs, -1), ready(true)
+		{
+			// Both ends send before they receive, so each socket must buffer a whole row or the pair would wait on each other.
+			int bufferBytes = static_cast<int>(4 * words * sizeof(uint64_t) + 4096);
+			for (int slab = 1; slab < slabs && ready; ++slab)
+			{
+				int pair[2];
+				if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0)
+				{
+					ready = false;
+					break;
+				}
+				for (int end : pair)
+				{
+					setsockopt(end, SOL_SOCKET, SO_SNDBUF, &bufferBytes, sizeof(bufferBytes));
+					setsockopt(end, SOL_SOCKET, SO_RCVBUF, &bufferBytes, sizeof(bufferBytes));
+				}
+				downSockets[slab - 1] = pair[0];
+				upSockets[slab] = pair[1];
+			}
+		}
+
+		~SocketTransport()
+		{
+			keepSlab(-1);
+		}
+
+		SocketTransport(const SocketTransport&) = delete;
+		SocketTransport& operator=(const SocketTransport&) = delete;
+
+		// Get functions
+		bool isReady() const { return ready; }
+
+		void keepSlab(int slab) override
+		{
+			for (int other = 0; other < slabs; ++other)
+			{
+				if (other == slab)
+				{
+					continue;
+				}
+				if (upSockets[other] >= 0)
+				{
+					close(upSockets[other]);
+					upSockets[other] = -1;
+				}
+				if (downSockets[other] >= 0)
+				{
+					close(downSockets[other]);
+					downSockets[other] = -1;
+				}
+			}
+		}
+
+		void sendEdges(int slab, int, const uint64_t* top, const uint64_t* bottom) override
+		{
+			if (slab > 0)
+			{
+				sendRow(upSockets[slab], top);
+			}
+			if (slab + 1 < slabs)
+			{
+				sendRow(downSockets[slab], bottom);
+			}
+		}
+
+		void receiveHalos(int slab, int, uint64_t* above, uint64_t* below) override
+		{
+			if (slab > 0)
+			{
+				receiveRow(upSockets[slab], above);
+			}
+			else
+			{
+				fill(above, above + words, 0);
+			}
+			if (slab + 1 < slabs)
+			{
+				receiveRow(downSockets[slab], below);
+			}
+			else
+			{
+				fill(below, below + words, 0);
+			}
+		}
+};
+#endif
+
+// Steps one slab of packed rows for a number of generations, counting them from firstGeneration for the transport. The slab is copied into
+// current, which has room for a halo row above and below it. Each generation its edge rows are sent first, then the interior rows, which need no halo,
+// are stepped into next while the neighbours' rows are on their way. The first and last rows are stepped once the halos arrive.
+// The result is copied back over the slab's rows. Nothing is allocated, so a forked worker can call it.
+template <typename RuleT>
+void stepSlab(uint64_t* slabRows, int rows, int words, uint64_t lastMask, int firstGeneration, int generations, int slab, HaloTransport& transport, RuleT rule,
+	vector<uint64_t>& current, vector<uint64_t>& next)
+{
+	size_t rowWords = words;
+	copy(slabRows, slabRows + rows * rowWords, current.begin() + rowWords);
+	auto at = [&](vector<uint64_t>& buffer, int row) { return buffer.data() + row * rowWords; };
+
+	for (int generation = firstGeneration; generation < firstGeneration + generations; ++generation)
+	{
+		transport.sendEdges(slab, generation, at(current, 1), at(current, rows));
+
+		for (int row = 2; row < rows; ++row)
+		{
+			stepPackedRow(at(current, row - 1), at(current, row), at(current, row + 1), at(next, row), words, lastMask, rule);
+		}
+
+		transport.receiveHalos(slab, generation, at(current, 0), at(current, rows + 1));
+		stepPackedRow(at(current, 0), at(current, 1), at(current, 2), at(next, 1), words, lastMask, rule);
+		if (rows > 1)
+		{
+			stepPackedRow(at(current, rows - 1), at(current, rows), at(current, rows + 1), at(next, rows), words, lastMask, rule);
+		}
+		current.swap(next);
+	}
+	copy(current.begin() + rowWords, current.begin() + (rows + 1) * rowWords, slabRows);
+}
+
+// Creates the transport the slabs of a grid swap boundary rows through. Falls back to shared memory if sockets cannot be made.
+inline unique_ptr<HaloTransport> createTransport(int slabs, int words, TransportType transportType, bool useProcesses)
+{
+#ifndef _WIN32
+	if (transportType == TransportType::UnixSocket && useProcesses)
+	{
+		unique_ptr<SocketTransport> sockets(new SocketTransport(slabs, words));
+		if (sockets->isReady())
+		{
+			return unique_ptr<HaloTransport>(sockets.release());
+		}
+		cout << endl << "Error: Unable to create sockets. Using shared memory instead.";
+	}
+#endif
+	return unique_ptr<HaloTransport>(new SharedMemoryTransport(slabs, words, useProcesses));
+}
+
+// Steps a grid of packed rows split into horizontal slabs with one thread each, exchanging rows through memory. Used where the grid's memory
+// cannot be shared with worker processes, as on Windows.
+template <typename RuleT>
+void runSlabs(const SharedBuffer& cells, int rows, int words, uint64_t lastMask, int generations, int workers, TransportType transportType, RuleT rule)
+{
+	uint64_t* packed = reinterpret_cast<uint64_t*>(cells.getData());
+	int slabs = max(1, min(workers, rows));
+	auto slabStart = [&](int slab) { return static_cast<int>(static_cast<long long>(rows) * slab / slabs); };
+	unique_ptr<HaloTransport> transport = createTransport(slabs, words, transportType, false);
+
+	vector<thread> threads;
+	for (int slab = 0; slab < slabs; ++slab)
+	{
+		threads.emplace_back([&, slab]()
+		{
+			int first = slabStart(slab);
+			int slabRows = slabStart(slab + 1) - first;
+			vector<uint64_t> current(static_cast<size_t>(slabRows + 2) * words, 0);
+			vector<uint64_t> next(static_cast<size_t>(slabRows + 2) * words, 0);
+			stepSlab(packed + static_cast<size_t>(first) * words, slabRows, words, lastMask, 0, generations, slab, *transport, rule, current, next);
+		});
+	}
+	for (thread& worker : threads)
+	{
+		worker.join();
+	}
+}
+
+#ifndef _WIN32
+const int WORKER_POLL_MS = 100; // how long a step waits for replies before checking that no worker has died
+
+// Worker processes that each own one slab of a grid in shared memory and step it whenever asked, exchanging their boundary rows over the chosen transport.
+// They are forked once and reused for every step. A child of a process with running threads must not allocate, as another thread may have held the
+// heap lock when it forked, so every buffer a worker uses is allocated before its fork and a worker only reads and writes its command socket.
+// If a worker dies the others are aborted and killed rather than left waiting on its rows, and the step that saw it returns false.
+class SlabWorkers
+{
+
+	private:
+		unique_ptr<HaloTransport> transport;
+		vector<pid_t> children;
+		vector<int> commandSockets; // the parent's end of a socket pair with each worker
+		vector<pollfd> waiting; // the command sockets still to reply in a step
+		int generationsDone; // generations stepped so far, which the transport numbers rows by
+
+		// Reads or writes a whole value on a socket. Returns false if the other end has gone.
+		static bool sendAll(int socket, const void* value, size_t bytes)
+		{
+#ifdef MSG_NOSIGNAL
+			int flags = MSG_NOSIGNAL;
+#else
+			int flags = 0;
+#endif
+			const char* data = static_cast<const char*>(value);
+			while (bytes > 0)
+			{
+				ssize_t sent = send(socket, data, bytes, flags);
+				if (sent <= 0)
+				{
+					return false;
+				}
+				data += sent;
+				bytes -= sent;
+			}
+			return true;
+		}
+
+		static bool receiveAll(int socket, void* value, size_t bytes)
+		{
+			char* data = static_cast<char*>(value);
+			while (bytes > 0)
+			{
+				ssize_t received = recv(socket, data, bytes, 0);
+				if (received <= 0)
+				{
+					return false;
+				}
+				data += received;
+				bytes -= received;
+			}
+			return true;
+		}
+
+		// Returns true if a worker has exited or been killed.
+		bool anyWorkerDied() const
+		{
+			for (pid_t child : children)
+			{
+				if (waitpid(child, nullptr, WNOHANG) != 0)
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		// Stops the workers after one has failed. The others may be waiting on its rows, so they are aborted and killed rather than asked to quit.
+		void abortWorkers()
+		{
+			if (transport)
+			{
+				transport->abort();
+			}
+			for (pid_t child : children)
+			{
+				kill(child, SIGKILL);
+			}
+			stop();
+		}
+
+	public:
+		SlabWorkers() : generationsDone(0) {}
+
+		~SlabWorkers()
+		{
+			stop();
+		}
+
+		SlabWorkers(const SlabWorkers&) = delete;
+		SlabWorkers& operator=(const SlabWorkers&) = delete;
+
+		// Get functions
+		bool isRunning() const { return !children.empty(); }
+		const vector<pid_t>& getChildren() const { return children; }
+
+		// Forks a worker for each slab of the grid. Returns false if the memory is not shared or a worker could not be started.
+		template <typename RuleT>
+		bool start(const SharedBuffer& cells, int rows, int words, uint64_t lastMask, int workers, TransportType transportType, RuleT rule)
+		{
+			stop();
+			if (!cells.isShared() || rows == 0)
+			{
+				return false;
+			}
+			uint64_t* packed = reinterpret_cast<uint64_t*>(cells.getData());
+			int slabs = max(1, min(workers, rows));
+			auto slabStart = [&](int slab) { return static_cast<int>(static_cast<long long>(rows) * slab / slabs); };
+			transport = createTransport(slabs, words, transportType, true);
+			SharedMemoryTransport* mailboxes = dynamic_cast<SharedMemoryTransport*>(transport.get());
+			if (mailboxes && !mailboxes->isShared())
+			{
+				transport.reset();
+				return false;
+			}
+			generationsDone = 0;
+
+			// Output is flushed first so the children do not write out copies of it.
+			cout.flush();
+			for (int slab = 0; slab < slabs; ++slab)
+			{
+				int first = slabStart(slab);
+				int slabRows = slabStart(slab + 1) - first;
+				vector<uint64_t> current(static_cast<size_t>(slabRows + 2) * words, 0);
+				vector<uint64_t> next(static_cast<size_t>(slabRows + 2) * words, 0);
+				int pair[2];
+				if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0)
+				{
+					stop();
+					cout << endl << "Error: Unable to start worker processes.";
+					return false;
+				}
+
+				pid_t child = fork();
+				if (child == 0)
+				{
+					// The child only has this thread, so it must not use the scheduler, allocate or run any destructors.
+					close(pair[0]);
+					for (int socket : commandSockets)
+					{
+						close(socket);
+					}
+					transport->keepSlab(slab);
+					uint64_t* slabCells = packed + static_cast<size_t>(first) * words;
+					int done = 0;
+					int generations;
+					while (receiveAll(pair[1], &generations, sizeof(generations)) && generations > 0)
+					{
+						stepSlab(slabCells, slabRows, words, lastMask, done, generations, slab, *transport, rule, current, next);
+						done += generations;
+						if (!sendAll(pair[1], &done, sizeof(done)))
+						{
+							break;
+						}
+					}
+					_exit(0);
+				}
+				close(pair[1]);
+				if (child < 0)
+				{
+					close(pair[0]);
+					stop();
+					cout << endl << "Error: Unable to start worker processes.";
+					return false;
+				}
+				children.push_back(child);
+				commandSockets.push_back(pair[0]);
+			}
+
+			// Only the workers use the transport's ends, so a worker that dies closes the last copy of its own
+			transport->keepSlab(-1);
+			waiting.assign(commandSockets.size(), pollfd());
+			return true;
+		}
+
+		// Has every worker step its slab and waits for them all. Returns false if a worker has failed, after which the workers are stopped.
+		bool step(int generations)
+		{
+			bool succeeded = true;
+			for (size_t i = 0; i < commandSockets.size(); ++i)
+			{
+				succeeded = sendAll(commandSockets[i], &generations, sizeof(generations)) && succeeded;
+				waiting[i].fd = commandSockets[i];
+				waiting[i].events = POLLIN;
+				waiting[i].revents = 0;
+			}
+
+			// Replies are polled for so a worker that dies is seen even while the others are blocked waiting on it. Replied sockets are set to -1, which poll skips.
+			size_t replies = 0;
+			while (succeeded && replies < waiting.size())
+			{
+				int ready = poll(waiting.data(), waiting.size(), WORKER_POLL_MS);
+				if (ready < 0 && errno != EINTR)
+				{
+					succeeded = false;
+				}
+				else if (ready == 0)
+				{
+					succeeded = !anyWorkerDied();
+				}
+				for (size_t i = 0; ready > 0 && i < waiting.size(); ++i)
+				{
+					if (waiting[i].fd >= 0 && waiting[i].revents != 0)
+					{
+						int done;
+						succeeded = receiveAll(waiting[i].fd, &done, sizeof(done)) && done == generationsDone + generations && succeeded;
+						waiting[i].fd = -1;
+						replies++;
+					}
+				}
+			}
+			generationsDone += generations;
+			if (!succeeded)
+			{
+				abortWorkers();
+				cout << endl << "Error: A worker process failed.";
+			}
+			return succeeded;
+		}
+
+		// Tells the workers to exit and waits for them. A worker that has already failed sees its socket close instead.
+		void stop()
+		{
+			int quit = 0;
+			for (int socket : commandSockets)
+			{
+				sendAll(socket, &quit, sizeof(quit));
+				close(socket);
+			}
+			for (pid_t child : children)
+			{
+				waitpid(child, nullptr, 0);
+			}
+			commandSockets.clear();
+			children.clear();
+			transport.reset();
+		}
+};
+#endif
+
+// SNAPSHOTS
+
+// Header at the start of a binary snapshot. It is followed by the cells, one row after another, each row packed into little-endian 64-bit words
+// with bit j of word k being column 64k + j. generation counts the generations the file has been advanced on disk.
+struct SnapshotHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t headerBytes;
+	uint64_t rows;
+	uint64_t cols;
+	uint64_t generation;
+	uint32_t birth;
+	uint32_t survival;
+	uint64_t reserved[2];
+};
+
+static_assert(sizeof(SnapshotHeader) == 64, "snapshot header must stay 64 bytes");
+
+const char SNAPSHOT_MAGIC[8] = { 'G', 'O', 'L', 'S', 'N', 'A', 'P', '\0' };
+const uint32_t SNAPSHOT_VERSION = 1;
+
+// Returns a header for a snapshot of the given size and rule.
+SnapshotHeader makeSnapshotHeader(uint64_t rows, uint64_t cols, uint64_t generation, const RuleSpec& rule)
+{
+	SnapshotHeader header = {};
+	copy(begin(SNAPSHOT_MAGIC), end(SNAPSHOT_MAGIC), header.magic);
+	header.version = SNAPSHOT_VERSION;
+	header.headerBytes = sizeof(SnapshotHeader);
+	header.rows = rows;
+	header.cols = cols;
+	header.generation = generation;
+	header.birth = rule.getBirth();
+	header.survival = rule.getSurvival();
+	return header;
+}
+
+// Returns the number of bytes a snapshot of this size takes up, header included.
+uint64_t snapshotBytes(uint64_t rows, uint64_t cols)
+{
+	return sizeof(SnapshotHeader) + rows * ((cols + 63) / 64) * sizeof(uint64_t);
+}
+
+// Checks a header read from a file of the given size. Prints what is wrong and returns false if it is not a snapshot this build can read.
+bool checkSnapshotHeader(const SnapshotHeader& header, uint64_t fileBytes)
+{
+	if (!equal(begin(SNAPSHOT_MAGIC), end(SNAPSHOT_MAGIC), header.magic))
+	{
+		cout << endl << "Error: The file is not a snapshot.";
+		return false;
+	}
+	if (header.version != SNAPSHOT_VERSION || header.headerBytes != sizeof(SnapshotHeader))
+	{
+		cout << endl << "Error: The snapshot was saved by a different version.";
+		return false;
+	}
+	if (header.rows == 0 || header.cols == 0 || header.cols > uint64_t(INT_MAX) || fileBytes < snapshotBytes(header.rows, header.cols))
+	{
+		cout << endl << "Error: The snapshot is damaged.";
+		return false;
+	}
+	return true;
+}
+
+// A file mapped into memory, read and write. Parts of it can be prefetched ahead of use and released once done with,
+// so the operating system only needs to keep the part in use in memory however large the file is.
+class MappedFile
+{
+
+	private:
+		unsigned char* data;
+		size_t bytes;
+#ifdef _WIN32
+		HANDLE file;
+		HANDLE mapping;
+#else
+		int file;
+
+		// Page aligned range covering [offset, offset + length).
+		void pageRange(size_t offset, size_t length, unsigned char*& start, size_t& rangeBytes) const
+		{
+			size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+			size_t first = offset / page * page;
+			size_t last = min(bytes, offset + length);
+			start = data + first;
+			rangeBytes = last > first ? last - first : 0;
+		}
+#endif
+
+		bool map(const string& filename, size_t size, bool create)
+		{
+			close();
+#ifdef _WIN32
+			file = CreateFileA(filename.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, create ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (file == INVALID_HANDLE_VALUE)
+			{
+				return false;
+			}
+			if (!create)
+			{
+				LARGE_INTEGER fileSize;
+				GetFileSizeEx(file, &fileSize);
+				size = static_cast<size_t>(fileSize.QuadPart);
+			}
+			if (size == 0)
+			{
+				close();
+				return false;
+			}
+			mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, static_cast<DWORD>(uint64_t(size) >> 32), static_cast<DWORD>(size), nullptr);
+			data = mapping ? static_cast<unsigned char*>(MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0)) : nullptr;
+#else
+			file = ::open(filename.c_str(), create ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDWR, 0644);
+			if (file < 0)
+			{
+				return false;
+			}
+			struct stat info;
+			if (create ? ftruncate(file, static_cast<off_t>(size)) != 0 : fstat(file, &info) != 0)
+			{
+				close();
+				return false;
+			}
+			size = create ? size : static_cast<size_t>(info.st_size);
+			if (size == 0)
+			{
+				close();
+				return false;
+			}
+			void* mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+			data = mapped == MAP_FAILED ? nullptr : static_cast<unsigned char*>(mapped);
+#endif
+			bytes = size;
+			if (!data)
+			{
+				close();
+				return false;
+			}
+			return true;
+		}
+
+	public:
+#ifdef _WIN32
+		MappedFile() : data(nullptr), bytes(0), file(INVALID_HANDLE_VALUE), mapping(nullptr) {}
+#else
+		MappedFile() : data(nullptr), bytes(0), file(-1) {}
+#endif
+
+		~MappedFile() { close(); }
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		// Creates or replaces a file of the given size and maps it. Returns false if it could not.
+		bool create(const string& filename, size_t size) { return map(filename, size, true); }
+
+		// Maps an existing file. Returns false if it could not.
+		bool open(const string& filename) { return map(filename, 0, false); }
+
+		void close()
+		{
+#ifdef _WIN32
+			if (data)
+			{
+				FlushViewOfFile(data, 0);
+				UnmapViewOfFile(data);
+			}
+			if (mapping)
+			{
+				CloseHandle(mapping);
+			}
+			if (file != INVALID_HANDLE_VALUE)
+			{
+				CloseHandle(file);
+			}
+			mapping = nullptr;
+			file = INVALID_HANDLE_VALUE;
+#else
+			if (data)
+			{
+				munmap(data, bytes);
+			}
+			if (file >= 0)
+			{
+				::close(file);
+			}
+			file = -1;
+#endif
+			data = nullptr;
+			bytes = 0;
+		}
+
+		// Get functions
+		unsigned char* getData() const { return data; }
+		size_t getBytes() const { return bytes; }
+		bool isOpen() const { return data != nullptr; }
+
+		// Asks the operating system to start reading a range in the background. Returns straight away.
+		void prefetch(size_t offset, size_t length) const
+		{
+			if (offset >= bytes)
+			{
+				return;
+			}
+#ifdef _WIN32
+#if _WIN32_WINNT >= 0x0602
+			WIN32_MEMORY_RANGE_ENTRY range = { data + offset, min(length, bytes - offset) };
+			PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#endif
+#else
+			unsigned char* start;
+			size_t rangeBytes;
+			pageRange(offset, length, start, rangeBytes);
+			madvise(start, rangeBytes, MADV_WILLNEED);
+#endif
+		}
+
+		// Starts writing a range back to the file and lets the operating system drop it from memory.
+		void release(size_t offset, size_t length) const
+		{
+			if (offset >= bytes)
+			{
+				return;
+			}
+#ifdef _WIN32
+			FlushViewOfFile(data + offset, min(length, bytes - offset));
+#else
+			unsigned char* start;
+			size_t rangeBytes;
+			pageRange(offset, length, start, rangeBytes);
+			msync(start, rangeBytes, MS_ASYNC);
+			madvise(start, rangeBytes, MADV_DONTNEED);
+#endif
+		}
+};
+
+// Rows the wavefront prefetches and releases at a time, and how many of those bands it reads ahead.
+const int WAVEFRONT_BAND_ROWS = 64;
+const int WAVEFRONT_PREFETCH_BANDS = 4;
+const int WAVEFRONT_DEPTH = 16; // generations advanced per pass down the file
+const int PACKED_ROW_CHUNK = 2048; // words per task when a wide row is split across the scheduler
+
+// Steps a packed row, splitting very wide rows across the scheduler.
+template <typename RuleT>
+void stepPackedRowParallel(const uint64_t* up, const uint64_t* row, const uint64_t* down, uint64_t* out, int words, uint64_t lastMask, RuleT rule)
+{
+	if (words <= PACKED_ROW_CHUNK)
+	{
+		stepPackedRow(up, row, down, out, words, lastMask, rule);
+		return;
+	}
+	getScheduler().parallelFor((words + PACKED_ROW_CHUNK - 1) / PACKED_ROW_CHUNK, [&](int chunk)
+	{
+		stepPackedWords(up, row, down, out, words, chunk * PACKED_ROW_CHUNK, min(words, (chunk + 1) * PACKED_ROW_CHUNK), lastMask, rule);
+	});
+}
+
+// Advances the cells of a mapped snapshot by depth generations in one pass down the file. Each generation keeps a ring of its last three rows,
+// so generation l can produce row i - l as soon as generation l - 1 has produced row i - l + 1, and the deepest one writes its row back over the file.
+// Every row it overwrites has already been copied into the first ring, so the file is updated in place using 3 * (depth + 1) rows of memory.
+// Bands ahead of the wavefront are prefetched in the background and bands behind it are released, so the working set stays bounded.
+// Rows that change are marked in changes, and the rows written are copied into activity, if they are given.
+template <typename RuleT>
+void advanceWavefront(MappedFile& file, int64_t rows, int cols, int words, uint64_t lastMask, int depth, RuleT rule, ChangeMap* changes = nullptr, ActivityMap* activity = nullptr)
+{
+	size_t rowBytes = static_cast<size_t>(words) * sizeof(uint64_t);
+	uint64_t* cells = reinterpret_cast<uint64_t*>(file.getData() + sizeof(SnapshotHeader));
+	auto fileRow = [&](int64_t x) { return cells + static_cast<size_t>(x) * words; };
+	auto rowOffset = [&](int64_t x) { return sizeof(SnapshotHeader) + static_cast<size_t>(x) * rowBytes; };
+
+	// Kept per thread so a pass over a file of the same width allocates nothing.
+	static thread_local vector<uint64_t> rings;
+	static thread_local vector<uint64_t> deadRow;
+	rings.assign(static_cast<size_t>(depth + 1) * 3 * words, 0);
+	deadRow.assign(words, 0);
+	auto ringRow = [&](int level, int64_t x) { return rings.data() + (static_cast<size_t>(level) * 3 + static_cast<size_t>(x % 3)) * words; };
+	auto levelRow = [&](int level, int64_t x) -> const uint64_t* { return (x < 0 || x >= rows) ? deadRow.data() : ringRow(level, x); };
+
+	file.prefetch(rowOffset(0), WAVEFRONT_BAND_ROWS * (WAVEFRONT_PREFETCH_BANDS + 1) * rowBytes);
+	for (int64_t i = 0; i < rows + depth; ++i)
+	{
+		if (i < rows)
+		{
+			if (i % WAVEFRONT_BAND_ROWS == 0)
+			{
+				file.prefetch(rowOffset(i + WAVEFRONT_BAND_ROWS * WAVEFRONT_PREFETCH_BANDS), WAVEFRONT_BAND_ROWS * rowBytes);
+			}
+			copy(fileRow(i), fileRow(i) + words, ringRow(0, i));
+		}
+
+		for (int level = 1; level <= depth; ++level)
+		{
+			int64_t x = i - level;
+			if (x >= 0 && x < rows)
+			{
+				stepPackedRowParallel(levelRow(level - 1, x - 1), levelRow(level - 1, x), levelRow(level - 1, x + 1), ringRow(level, x), words, lastMask, rule);
+			}
+		}
+
+		int64_t written = i - depth;
+		if (written >= 0)
+		{
+			const uint64_t* result = ringRow(depth, written);
+			if (changes)
+			{
+				const uint64_t* before = fileRow(written);
+				for (int word = 0; word < words; ++word)
+				{
+					if (before[word] != result[word])
+					{
+						changes->markCells(static_cast<int>(written), static_cast<int>(written) + 1, word * 64, min(cols, word * 64 + 64));
+					}
+				}
+			}
+			if (activity)
+			{
+				copy(result, result + words, activity->getLiveRow(static_cast<int>(written)));
+			}
+			copy(result, result + words, fileRow(written));
+
+			// Release each band once the wavefront has written all of it
+			if ((written + 1) % WAVEFRONT_BAND_ROWS == 0 || written + 1 == rows)
+			{
+				int64_t bandStart = written / WAVEFRONT_BAND_ROWS * WAVEFRONT_BAND_ROWS;
+				file.release(rowOffset(bandStart), static_cast<size_t>(written + 1 - bandStart) * rowBytes);
+			}
+		}
+	}
+}
+
+// Advances a mapped snapshot by a number of generations using the rule in its header, and updates the generation it records.
+void advanceMappedSnapshot(MappedFile& file, int64_t generations, ChangeMap* changes = nullptr, ActivityMap* activity = nullptr)
+{
+	SnapshotHeader& header = *reinterpret_cast<SnapshotHeader*>(file.getData());
+	int64_t rows = static_cast<int64_t>(header.rows);
+	int cols = static_cast<int>(header.cols);
+	int words = (cols + 63) / 64;
+	uint64_t lastMask = cols % 64 == 0 ? ~uint64_t(0) : (uint64_t(1) << (cols % 64)) - 1;
+	RuleSpec rule(header.birth, header.survival);
+
+	dispatchRule(rule, [&](auto compiledRule)
+	{
+		while (generations > 0)
+		{
+			int depth = static_cast<int>(min<int64_t>(generations, WAVEFRONT_DEPTH));
+			bool lastPass = depth == generations;
+			if (lastPass && activity)
+			{
+				activity->beginStep(static_cast<int>(rows), cols);
+			}
+			advanceWavefront(file, rows, cols, words, lastMask, depth, compiledRule, changes, lastPass ? activity : nullptr);
+			header.generation += depth;
+			generations -= depth;
+		}
+	});
+}
+
+// Creates a snapshot file of random cells without holding the grid in memory. Cells are chosen the same way as scatterCells,
+// filling each row straight into the mapped file. Returns false if the file could not be created.
+bool createSnapshotFile(const string& filename, int64_t rows, int cols, int64_t numCells, unsigned int seed, const RuleSpec& rule)
+{
+	MappedFile file;
+	if (!file.create(filename, static_cast<size_t>(snapshotBytes(rows, cols))))
+	{
+		cout << endl << "Error: Unable to create the file.";
+		return false;
+	}
+	*reinterpret_cast<SnapshotHeader*>(file.getData()) = makeSnapshotHeader(rows, cols, 0, rule);
+
+	mt19937 gen(seed);
+	uint64_t key = (uint64_t(gen()) << 32) | gen();
+	uint64_t maxCells = uint64_t(rows) * cols;
+	uint64_t liveCells = min(maxCells, uint64_t(max<int64_t>(0, numCells)));
+	IndexPermutation shuffle(maxCells, key);
+	int words = (cols + 63) / 64;
+	uint64_t* cells = reinterpret_cast<uint64_t*>(file.getData() + sizeof(SnapshotHeader));
+
+	for (int64_t band = 0; band < rows; band += WAVEFRONT_BAND_ROWS)
+	{
+		int64_t endRow = min(rows, band + WAVEFRONT_BAND_ROWS);
+		getScheduler().parallelFor(static_cast<int>(endRow - band), [&](int offset)
+		{
+			int64_t x = band + offset;
+			uint64_t* row = cells + static_cast<size_t>(x) * words;
+			for (int y = 0; y < cols; ++y)
+			{
+				if (liveCells > 0 && shuffle.permute(uint64_t(x) * cols + y) < liveCells)
+				{
+					row[y / 64] |= uint64_t(1) << (y % 64);
+				}
+			}
+		});
+		file.release(sizeof(SnapshotHeader) + static_cast<size_t>(band) * words * sizeof(uint64_t), static_cast<size_t>(endRow - band) * words * sizeof(uint64_t));
+	}
+	return true;
+}
+
+// Writes a grid to a snapshot file at the given generation. Returns false if the file could not be created.
+template <typename T>
+bool writeSnapshotFile(const string& filename, GridView<T> grid, uint64_t generation, const RuleSpec& rule)
+{
+	int rows = grid.getRows();
+	int cols = grid.getCols();
+	MappedFile snapshotFile;
+	if (!snapshotFile.create(filename, static_cast<size_t>(snapshotBytes(rows, cols))))
+	{
+		return false;
+	}
+	*reinterpret_cast<SnapshotHeader*>(snapshotFile.getData()) = makeSnapshotHeader(rows, cols, generation, rule);
+	uint64_t* cells = reinterpret_cast<uint64_t*>(snapshotFile.getData() + sizeof(SnapshotHeader));
+	int words = (cols + 63) / 64;
+	for (int x = 0; x < rows; ++x)
+	{
+		for (int y = 0; y < cols; ++y)
+		{
+			cells[static_cast<size_t>(x) * words + y / 64] |= uint64_t(grid.isAlive(x, y)) << (y % 64);
+		}
+	}
+	return true;
+}
+
+// Reads a snapshot file into the grid. The rule and generation saved in it are written to the pointers if they are given.
+// Returns false without changing the grid if the file is missing, damaged or too large to hold in memory.
+template <typename T>
+bool readSnapshotFile(const string& filename, Grid<T>& grid, RuleSpec* rulePointer = nullptr, uint64_t* generationPointer = nullptr)
+{
+	MappedFile snapshotFile;
+	if (!snapshotFile.open(filename) || snapshotFile.getBytes() < sizeof(SnapshotHeader))
+	{
+		return false;
+	}
+	const SnapshotHeader& header = *reinterpret_cast<const SnapshotHeader*>(snapshotFile.getData());
+	if (!checkSnapshotHeader(header, snapshotFile.getBytes()))
+	{
+		return false;
+	}
+	if (header.rows > uint64_t(INT_MAX))
+	{
+		cout << endl << "Error: The snapshot is too large to load into memory. Advance it on disk instead.";
+		return false;
+	}
+
+	int rows = static_cast<int>(header.rows);
+	int cols = static_cast<int>(header.cols);
+	int words = (cols + 63) / 64;
+	const uint64_t* cells = reinterpret_cast<const uint64_t*>(snapshotFile.getData() + sizeof(SnapshotHeader));
+	Grid<T> loadedGrid(rows, cols);
+	for (int x = 0; x < rows; ++x)
+	{
+		for (int y = 0; y < cols; ++y)
+		{
+			loadedGrid.setAlive(x, y, (cells[static_cast<size_t>(x) * words + y / 64] >> (y % 64)) & 1u);
+		}
+	}
+	grid.swap(loadedGrid);
+
+	if (rulePointer)
+	{
+		*rulePointer = RuleSpec(header.birth, header.survival);
+	}
+	if (generationPointer)
+	{
+		*generationPointer = header.generation;
+	}
+	return true;
+}
+
+// FRAME EXPORT
+
+const int EXPORT_QUEUE_FRAMES = 8; // frames waiting to be written before new ones are dropped
+
+// Returns the CRC-32 PNG chunks end with.
+uint32_t crc32(const uint8_t* data, size_t bytes, uint32_t crc = 0)
+{
+	static const vector<uint32_t> table = []()
+	{
+		vector<uint32_t> values(256);
+		for (uint32_t n = 0; n < 256; ++n)
+		{
+			uint32_t c = n;
+			for (int k = 0; k < 8; ++k)
+			{
+				c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+			}
+			values[n] = c;
+		}
+		return values;
+	}();
+	crc = ~crc;
+	for (size_t i = 0; i < bytes; ++i)
+	{
+		crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+	}
+	return ~crc;
+}
+
+// Appends a number as four bytes, most significant first.
+inline void writeBigEndian(vector<uint8_t>& out, uint32_t value)
+{
+	for (int shift = 24; shift >= 0; shift -= 8)
+	{
+		out.push_back(static_cast<uint8_t>(value >> shift));
+	}
+}
+
+// Appends a PNG chunk with its length and CRC.
+void writePngChunk(vector<uint8_t>& out, const char* type, const vector<uint8_t>& data)
+{
+	writeBigEndian(out, static_cast<uint32_t>(data.size()));
+	size_t start = out.size();
+	out.insert(out.end(), type, type + 4);
+	out.insert(out.end(), data.begin(), data.end());
+	writeBigEndian(out, crc32(out.data() + start, out.size() - start));
+}
+
+// Encodes packed cells as an image, each cell scale x scale pixels with live cells black. PBM and PNG use one bit a pixel,
+// PGM one byte. The PNG is zlib with stored blocks, which costs nothing to make and needs no library.
+void encodeImage(ImageFormat format, const uint64_t* cells, int rows, int cols, int words, int scale, vector<uint8_t>& out)
+{
+	int width = cols * scale;
+	int height = rows * scale;
+	out.clear();
+	if (format == ImageFormat::PGM)
+	{
+		string header = "P5\n" + to_string(width) + " " + to_string(height) + "\n255\n";
+		out.assign(header.begin(), header.end());
+		out.reserve(out.size() + static_cast<size_t>(width) * height);
+		for (int x = 0; x < rows; ++x)
+		{
+			size_t rowStart = out.size();
+			for (int y = 0; y < cols; ++y)
+			{
+				bool alive = (cells[static_cast<size_t>(x) * words + y / 64] >> (y % 64)) & 1u;
+				out.insert(out.end(), scale, alive ? 0 : 255);
+			}
+			for (int repeat = 1; repeat < scale; ++repeat)
+			{
+				out.insert(out.end(), out.begin() + rowStart, out.begin() + rowStart + width);
+			}
+		}
+		return;
+	}
+
+	// One bit a pixel, most significant first. PBM marks black with 1 and PNG greyscale marks white with 1.
+	int rowBytes = (width + 7) / 8;
+	bool liveBit = format == ImageFormat::PBM;
+	vector<uint8_t> pixels(static_cast<size_t>(height) * rowBytes, 0);
+	for (int x = 0; x < rows; ++x)
+	{
+		uint8_t* pixelRow = &pixels[static_cast<size_t>(x) * scale * rowBytes];
+		for (int y = 0; y < cols; ++y)
+		{
+			bool alive = (cells[static_cast<size_t>(x) * words + y / 64] >> (y % 64)) & 1u;
+			if (alive == liveBit)
+			{
+				for (int pixel = y * scale; pixel < (y + 1) * scale; ++pixel)
+				{
+					pixelRow[pixel / 8] |= static_cast<uint8_t>(0x80 >> (pixel % 8));
+				}
+			}
+		}
+		for (int repeat = 1; repeat < scale; ++repeat)
+		{
+			copy(pixelRow, pixelRow + rowBytes, pixelRow + static_cast<size_t>(repeat) * rowBytes);
+		}
+	}
+
+	if (format == ImageFormat::PBM)
+	{
+		string header = "P4\n" + to_string(width) + " " + to_string(height) + "\n";
+		out.assign(header.begin(), header.end());
+		out.insert(out.end(), pixels.begin(), pixels.end());
+		return;
+	}
+
+	const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+	out.assign(signature, signature + 8);
+	vector<uint8_t> header;
+	writeBigEndian(header, static_cast<uint32_t>(width));
+	writeBigEndian(header, static_cast<uint32_t>(height));
+	header.insert(header.end(), { 1, 0, 0, 0, 0 }); // 1 bit greyscale, deflate, no filter, no interlace
+	writePngChunk(out, "IHDR", header);
+
+	// Each scanline starts with filter type 0, then the zlib stream holds them in stored blocks of up to 65535 bytes
+	vector<uint8_t> scanlines;
+	scanlines.reserve(static_cast<size_t>(height) * (rowBytes + 1));
+	for (int row = 0; row < height; ++row)
+	{
+		scanlines.push_back(0);
+		scanlines.insert(scanlines.end(), pixels.begin() + static_cast<size_t>(row) * rowBytes, pixels.begin() + static_cast<size_t>(row + 1) * rowBytes);
+	}
+	vector<uint8_t> zlib = { 0x78, 0x01 };
+	size_t offset = 0;
+	do
+	{
+		size_t blockBytes = min<size_t>(65535, scanlines.size() - offset);
+		zlib.push_back(offset + blockBytes == scanlines.size() ? 1 : 0);
+		zlib.push_back(static_cast<uint8_t>(blockBytes));
+		zlib.push_back(static_cast<uint8_t>(blockBytes >> 8));
+		zlib.push_back(static_cast<uint8_t>(~blockBytes));
+		zlib.push_back(static_cast<uint8_t>(~blockBytes >> 8));
+		zlib.insert(zlib.end(), scanlines.begin() + offset, scanlines.begin() + offset + blockBytes);
+		offset += blockBytes;
+	} while (offset < scanlines.size());
+	uint32_t a = 1;
+	uint32_t b = 0;
+	for (uint8_t byte : scanlines)
+	{
+		a = (a + byte) % 65521;
+		b = (b + a) % 65521;
+	}
+	writeBigEndian(zlib, (b << 16) | a);
+	writePngChunk(out, "IDAT", zlib);
+	writePngChunk(out, "IEND", vector<uint8_t>());
+}
+
+// Writes frames of a run as numbered image files, <prefix>_<generation>.pbm, .pgm or .png, on a thread of its own. The simulation
+// thread only copies the cropped rows into one of EXPORT_QUEUE_FRAMES buffers. If every buffer is still waiting to be written
+// the frame is dropped and counted instead, so a slow disk never holds the simulation up.
+class FrameExporter
+{
+
+	private:
+		// One cropped frame of packed cells.
+		struct Frame
+		{
+			int64_t generation;
+			int rows;
+			int cols;
+			vector<uint64_t> cells;
+		};
+
+		ExportSettings settings;
+		vector<Frame> frames;
+		vector<int> freeFrames;
+		deque<int> readyFrames;
+		mutex lock;
+		condition_variable ready;
+		bool stopping;
+		size_t written;
+		size_t dropped;
+		thread writer;
+
+		// Encodes and writes queued frames until asked to stop with none left.
+		void writeFrames()
+		{
+			vector<uint8_t> image;
+			unique_lock<mutex> guard(lock);
+			while (true)
+			{
+				ready.wait(guard, [&]() { return stopping || !readyFrames.empty(); });
+				if (readyFrames.empty())
+				{
+					return;
+				}
+				int index = readyFrames.front();
+				readyFrames.pop_front();
+				guard.unlock();
+
+				const Frame& frame = frames[index];
+				encodeImage(settings.format, frame.cells.data(), frame.rows, frame.cols, (frame.cols + 63) / 64, settings.scale, image);
+				stringstream filename;
+				filename << settings.prefix << "_" << setw(6) << setfill('0') << frame.generation
+					<< (settings.format == ImageFormat::PBM ? ".pbm" : settings.format == ImageFormat::PGM ? ".pgm" : ".png");
+				ofstream imageFile(filename.str(), ios::binary);
+				imageFile.write(reinterpret_cast<const char*>(image.data()), image.size());
+				imageFile.close();
+
+				guard.lock();
+				freeFrames.push_back(index);
+				if (imageFile.fail())
+				{
+					dropped++;
+				}
+				else
+				{
+					written++;
+				}
+			}
+		}
+
+	public:
+		FrameExporter(const ExportSettings& settings)
+			: settings(settings), frames(EXPORT_QUEUE_FRAMES), stopping(false), written(0), dropped(0)
+		{
+			this->settings.scale = max(1, settings.scale);
+			this->settings.stride = max(1, settings.stride);
+			for (int i = EXPORT_QUEUE_FRAMES - 1; i >= 0; --i)
+			{
+				freeFrames.push_back(i);
+			}
+			writer = thread(&FrameExporter::writeFrames, this);
+		}
+
+		// Writes every frame still queued before returning.
+		~FrameExporter()
+		{
+			finish();
+		}
+
+		// Get functions
+		size_t getWritten() { lock_guard<mutex> guard(lock); return written; }
+		size_t getDropped() { lock_guard<mutex> guard(lock); return dropped; }
+
+		// Returns whether a generation is one the stride exports.
+		bool wants(int64_t generation) const { return generation % settings.stride == 0; }
+
+		// Queues the crop of a generation held as packed rows, rowStride words apart. Returns false if it was dropped because the queue is full.
+		bool push(const uint64_t* cells, size_t rowStride, int64_t rows, int cols, int64_t generation)
+		{
+			int top = static_cast<int>(min<int64_t>(settings.cropTop, rows));
+			int left = min(settings.cropLeft, cols);
+			int frameRows = static_cast<int>(settings.cropRows > 0 ? min<int64_t>(settings.cropRows, rows - top) : rows - top);
+			int frameCols = settings.cropCols > 0 ? min(settings.cropCols, cols - left) : cols - left;
+			if (frameRows <= 0 || frameCols <= 0)
+			{
+				return false;
+			}
+
+			int index;
+			{
+				lock_guard<mutex> guard(lock);
+				if (freeFrames.empty())
+				{
+					dropped++;
+					return false;
+				}
+				index = freeFrames.back();
+				freeFrames.pop_back();
+			}
+
+			// Shifts the cropped columns down to bit 0 a word at a time
+			Frame& frame = frames[index];
+			int words = (frameCols + 63) / 64;
+			int sourceWords = (cols + 63) / 64;
+			frame.generation = generation;
+			frame.rows = frameRows;
+			frame.cols = frameCols;
+			frame.cells.assign(static_cast<size_t>(frameRows) * words, 0);
+			for (int x = 0; x < frameRows; ++x)
+			{
+				const uint64_t* source = cells + static_cast<size_t>(top + x) * rowStride;
+				uint64_t* target = &frame.cells[static_cast<size_t>(x) * words];
+				for (int word = 0; word < words; ++word)
+				{
+					int bit = left + word * 64;
+					int shift = bit % 64;
+					uint64_t value = source[bit / 64] >> shift;
+					if (shift > 0 && bit / 64 + 1 < sourceWords)
+					{
+						value |= source[bit / 64 + 1] << (64 - shift);
+					}
+					target[word] = value;
+				}
+				if (frameCols % 64 != 0)
+				{
+					target[words - 1] &= (uint64_t(1) << (frameCols % 64)) - 1;
+				}
+			}
+
+			{
+				lock_guard<mutex> guard(lock);
+				readyFrames.push_back(index);
+			}
+			ready.notify_one();
+			return true;
+		}
+
+		// Writes every queued frame and stops the writer thread.
+		void finish()
+		{
+			{
+				lock_guard<mutex> guard(lock);
+				stopping = true;
+			}
+			ready.notify_one();
+			if (writer.joinable())
+			{
+				writer.join();
+			}
+		}
+};
+
+// ENGINES
+
+// Returns the name shown for an engine in the menus.
+string engineName(EngineType engine)
+{
+	switch (engine)
+	{
+		case EngineType::MortonTiled:
+			return "Z-order tiled bit grid";
+		case EngineType::Distributed:
+			return "Distributed slabs";
+		case EngineType::OutOfCore:
+			return "Out-of-core snapshot file";
+		case EngineType::SparseTiles:
+			return "Sparse tile map";
+		default:
+			return "Standard grid";
+	}
+}
+
+// Interface for an engine that keeps its own copy of the cells between generations. load and store copy the cells in and out of a grid.
+template <typename T, typename Cell>
+class StepEngine
+{
+
+	protected:
+		ChangeMap* changes = nullptr;
+		ActivityMap* activity = nullptr;
+	public:
+		virtual ~StepEngine() = default;
+
+		// Tiles with cells that change while stepping are marked in this map. nullptr turns tracking off.
+		void trackChanges(ChangeMap* changeMap) { changes = changeMap; }
+
+		// The live cells of the last generation stepped are written to this map. nullptr turns it off.
+		void trackActivity(ActivityMap* activityMap) { activity = activityMap; }
+
+		virtual void load(const Grid<T, Cell>& grid) = 0;
+		virtual void store(Grid<T, Cell>& grid) const = 0;
+		virtual void step(int generations) = 0;
+		virtual bool allDead() const = 0;
+};
+
+// Engine that steps the grid in place, with temporal blocking if it is turned on.
+template <typename T, typename Cell>
+class GridEngine : public StepEngine<T, Cell>
+{
+
+	private:
+		Grid<T, Cell>& grid;
+		RuleSpec rule;
+		int blockDepth;
+	public:
+		GridEngine(Grid<T, Cell>& grid, const RuleSpec& rule, int blockDepth) : grid(grid), rule(rule), blockDepth(blockDepth) {}
+
+		void load(const Grid<T, Cell>&) override {}
+		void store(Grid<T, Cell>&) const override {}
+		void step(int generations) override { advanceGenerations(grid, generations, rule, blockDepth, this->changes, this->activity); }
+		bool allDead() const override { return checkForDeadCells(grid); }
+};
+
+// Engine that keeps alive/dead cells in a Z-order tiled bit grid. Cells carrying extra state go back to a fresh state when stored.
+template <typename T, typename Cell>
+class MortonEngine : public StepEngine<T, Cell>
+{
+
+	private:
+		MortonTiledGrid tiled;
+		RuleSpec rule;
+	public:
+		MortonEngine(const RuleSpec& rule) : rule(rule) {}
+
+		void load(const Grid<T, Cell>& grid) override
+		{
+			// A grid of the same size reuses the tiles it already has
+			if (tiled.getRows() == grid.getRows() && tiled.getCols() == grid.getCols())
+			{
+				tiled.clear();
+			}
+			else
+			{
+				tiled = MortonTiledGrid(grid.getRows(), grid.getCols());
+			}
+			for (int x = 0; x < grid.getRows(); ++x)
+			{
+				for (int y = 0; y < grid.getCols(); ++y)
+				{
+					if (grid.isAlive(x, y))
+					{
+						tiled.setAlive(x, y, true);
+					}
+				}
+			}
+		}
+
+		void store(Grid<T, Cell>& grid) const override
+		{
+			for (int x = 0; x < grid.getRows(); ++x)
+			{
+				for (int y = 0; y < grid.getCols(); ++y)
+				{
+					if (tiled.isAlive(x, y) != grid.isAlive(x, y))
+					{
+						grid.setAlive(x, y, tiled.isAlive(x, y));
+					}
+				}
+			}
+		}
+
+		void step(int generations) override
+		{
+			dispatchRule(rule, [&](auto compiledRule)
+			{
+				for (int i = 0; i < generations; ++i)
+				{
+					tiled.step(compiledRule, this->changes, i == generations - 1 ? this->activity : nullptr);
+				}
+			});
+		}
+
+		bool allDead() const override { return tiled.allDead(); }
+};
+
+// Engine that steps a sparse tile map, so only the tiles near live cells are stored and stepped.
+template <typename T, typename Cell>
+class SparseTileEngine : public StepEngine<T, Cell>
+{
+
+	private:
+		SparseTileGrid sparse;
+		RuleSpec rule;
+	public:
+		SparseTileEngine(const RuleSpec& rule) : rule(rule) {}
+
+		void load(const Grid<T, Cell>& grid) override
+		{
+			// A grid of the same size keeps its pool of tiles
+			if (sparse.getRows() == grid.getRows() && sparse.getCols() == grid.getCols())
+			{
+				sparse.clear();
+			}
+			else
+			{
+				sparse = SparseTileGrid(grid.getRows(), grid.getCols());
+			}
+			for (int x = 0; x < grid.getRows(); ++x)
+			{
+				for (int y = 0; y < grid.getCols(); ++y)
+				{
+					if (grid.isAlive(x, y))
+					{
+						sparse.setAlive(x, y, true);
+					}
+				}
+			}
+		}
+
+		void store(Grid<T, Cell>& grid) const override
+		{
+			for (int x = 0; x < grid.getRows(); ++x)
+			{
+				for (int y = 0; y < grid.getCols(); ++y)
+				{
+					if (sparse.isAlive(x, y) != grid.isAlive(x, y))
+					{
+						grid.setAlive(x, y, sparse.isAlive(x, y));
+					}
+				}
+			}
+		}
+
+		void step(int generations) override
+		{
+			dispatchRule(rule, [&](auto compiledRule)
+			{
+				for (int i = 0; i < generations; ++i)
+				{
+					sparse.step(compiledRule, this->changes, i == generations - 1 ? this->activity : nullptr);
+				}
+			});
+		}
+
+		bool allDead() const override { return sparse.allDead(); }
+};
+
+// Engine that splits the grid into horizontal slabs of packed rows and steps each slab in its own worker process, swapping boundary rows every generation.
+// The workers are started when a grid is loaded and kept for every step after it. Loading a grid of the same size again only rewrites the shared cells,
+// as each worker copies its slab from them at the start of every step. Where the workers cannot be started, or once one has failed, each step runs
+// the slabs on threads instead.
+template <typename T, typename Cell>
+class DistributedEngine : public StepEngine<T, Cell>
+{
+
+	private:
+		RuleSpec rule;
+		int workers;
+		TransportType transport;
+		int rows;
+		int cols;
+		int words;
+		unique_ptr<SharedBuffer> cells;
+		vector<uint64_t> before; // the cells a step began with
+#ifndef _WIN32
+		SlabWorkers slabWorkers;
+#endif
+
+		uint64_t* packedRow(int x) const { return reinterpret_cast<uint64_t*>(cells->getData()) + static_cast<size_t>(x) * words; }
+		uint64_t lastMask() const { return cols % 64 == 0 ? ~uint64_t(0) : (uint64_t(1) << (cols % 64)) - 1; }
+
+	public:
+		DistributedEngine(const RuleSpec& rule, int workers, TransportType transport)
+			: rule(rule), workers(workers), transport(transport), rows(0), cols(0), words(0) {}
+
+		void load(const Grid<T, Cell>& grid) override
+		{
+			bool resized = !cells || rows != grid.getRows() || cols != grid.getCols();
+			rows = grid.getRows();
+			cols = grid.getCols();
+			words = (cols + 63) / 64;
+			if (resized)
+			{
+#ifndef _WIN32
+				slabWorkers.stop();
+#endif
+				cells.reset(new SharedBuffer(static_cast<size_t>(rows) * words * sizeof(uint64_t)));
+			}
+			for (int x = 0; x < rows; ++x)
+			{
+				uint64_t* row = packedRow(x);
+				fill(row, row + words, 0);
+				for (int y = 0; y < cols; ++y)
+				{
+					row[y / 64] |= uint64_t(grid.isAlive(x, y)) << (y % 64);
+				}
+			}
+#ifndef _WIN32
+			if (resized || !slabWorkers.isRunning())
+			{
+				dispatchRule(rule, [&](auto compiledRule) { slabWorkers.start(*cells, rows, words, lastMask(), workers, transport, compiledRule); });
+			}
+#endif
+		}
+
+		void store(Grid<T, Cell>& grid) const override
+		{
+			for (int x = 0; x < rows; ++x)
+			{
+				const uint64_t* row = packedRow(x);
+				for (int y = 0; y < cols; ++y)
+				{
+					bool alive = (row[y / 64] >> (y % 64)) & 1u;
+					if (alive != grid.isAlive(x, y))
+					{
+						grid.setAlive(x, y, alive);
+					}
+				}
+			}
+		}
+
+		void step(int generations) override
+		{
+			if (rows == 0 || generations <= 0)
+			{
+				return;
+			}
+			bool keepBefore = this->changes != nullptr;
+#ifndef _WIN32
+			keepBefore = keepBefore || slabWorkers.isRunning();
+#endif
+			if (keepBefore)
+			{
+				before.assign(packedRow(0), packedRow(rows));
+			}
+
+			bool stepped = false;
+#ifndef _WIN32
+			if (slabWorkers.isRunning())
+			{
+				// Workers that failed may have left some slabs stepped and others not, so the step is run again on threads from the cells it began with
+				stepped = slabWorkers.step(generations);
+				if (!stepped)
+				{
+					copy(before.begin(), before.end(), packedRow(0));
+				}
+			}
+#endif
+			if (!stepped)
+			{
+				dispatchRule(rule, [&](auto compiledRule) { runSlabs(*cells, rows, words, lastMask(), generations, workers, transport, compiledRule); });
+			}
+
+			if (this->changes)
+			{
+				// Tiles start on a word, so each tile covers whole words of every row
+				for (int x = 0; x < rows; ++x)
+				{
+					for (int word = 0; word < words; ++word)
+					{
+						if (before[static_cast<size_t>(x) * words + word] != packedRow(x)[word])
+						{
+							this->changes->markCells(x, x + 1, word * 64, min(cols, word * 64 + 64));
+						}
+					}
+				}
+			}
+			if (this->activity)
+			{
+				this->activity->beginStep(rows, cols);
+				for (int x = 0; x < rows; ++x)
+				{
+					copy(packedRow(x), packedRow(x) + words, this->activity->getLiveRow(x));
+				}
+			}
+		}
+
+		bool allDead() const override
+		{
+			return rows == 0 || all_of(packedRow(0), packedRow(rows), [](uint64_t word) { return word == 0; });
+		}
+};
+
+// Engine that keeps the cells in a snapshot file mapped into memory instead of in the grid's own memory, and advances them with a wavefront
+// down the file. Only a few rows per generation are held in memory at once, so the file can be far larger than physical memory.
+template <typename T, typename Cell>
+class OutOfCoreEngine : public StepEngine<T, Cell>
+{
+
+	private:
+		RuleSpec rule;
+		string backingFile;
+		MappedFile file;
+		int rows;
+		int cols;
+		int words;
+
+		const uint64_t* packedRow(int x) const { return reinterpret_cast<const uint64_t*>(file.getData() + sizeof(SnapshotHeader)) + static_cast<size_t>(x) * words; }
+
+	public:
+		OutOfCoreEngine(const RuleSpec& rule, const string& backingFile) : rule(rule), backingFile(backingFile), rows(0), cols(0), words(0) {}
+
+		// Loading a grid of the same size again rewrites the mapped file instead of creating it again.
+		void load(const Grid<T, Cell>& grid) override
+		{
+			rows = grid.getRows();
+			cols = grid.getCols();
+			words = (cols + 63) / 64;
+			size_t bytes = static_cast<size_t>(snapshotBytes(rows, cols));
+			if ((!file.getData() || file.getBytes() != bytes) && !file.create(backingFile, bytes))
+			{
+				cout << endl << "Error: Unable to create the backing file " << backingFile << ".";
+				rows = 0;
+				return;
+			}
+			*reinterpret_cast<SnapshotHeader*>(file.getData()) = makeSnapshotHeader(rows, cols, 0, rule);
+			for (int x = 0; x < rows; ++x)
+			{
+				uint64_t* row = const_cast<uint64_t*>(packedRow(x));
+				fill(row, row + words, 0);
+				for (int y = 0; y < cols; ++y)
+				{
+					row[y / 64] |= uint64_t(grid.isAlive(x, y)) << (y % 64);
+				}
+			}
+		}
+
+		void store(Grid<T, Cell>& grid) const override
+		{
+			for (int x = 0; x < rows; ++x)
+			{
+				const uint64_t* row = packedRow(x);
+				for (int y = 0; y < cols; ++y)
+				{
+					bool alive = (row[y / 64] >> (y % 64)) & 1u;
+					if (alive != grid.isAlive(x, y))
+					{
+						grid.setAlive(x, y, alive);
+					}
+				}
+			}
+		}
+
+		void step(int generations) override
+		{
+			if (rows > 0 && generations > 0)
+			{
+				advanceMappedSnapshot(file, generations, this->changes, this->activity);
+			}
+		}
+
+		bool allDead() const override
+		{
+			return rows == 0 || all_of(packedRow(0), packedRow(rows), [](uint64_t word) { return word == 0; });
+		}
+};
+
+// Creates the engine chosen in the settings for a grid.
+template <typename T, typename Cell>
+unique_ptr<StepEngine<T, Cell>> createEngine(Grid<T, Cell>& grid, const SimulationSettings& settings)
+{
+	switch (settings.getEngine())
+	{
+		case EngineType::MortonTiled:
+			return unique_ptr<StepEngine<T, Cell>>(new MortonEngine<T, Cell>(settings.getRule()));
+		case EngineType::Distributed:
+			return unique_ptr<StepEngine<T, Cell>>(new DistributedEngine<T, Cell>(settings.getRule(), settings.getWorkers(), settings.getTransport()));
+		case EngineType::OutOfCore:
+			return unique_ptr<StepEngine<T, Cell>>(new OutOfCoreEngine<T, Cell>(settings.getRule(), settings.getBackingFile()));
+		case EngineType::SparseTiles:
+			return unique_ptr<StepEngine<T, Cell>>(new SparseTileEngine<T, Cell>(settings.getRule()));
+		default:
+			return unique_ptr<StepEngine<T, Cell>>(new GridEngine<T, Cell>(grid, settings.getRule(), settings.getBlockDepth()));
+	}
+}
+
+// REPLAY
+
+// Returns a checksum of which cells are alive. Rows are packed into words and hashed a band at a time, then the band hashes are combined in order,
+// so the result only depends on the cells and not on the engine or how many threads worked on it.
+template <typename T, typename Cell>
+uint64_t gridChecksum(const Grid<T, Cell>& grid)
+{
+	int rows = grid.getRows();
+	int cols = grid.getCols();
+	int bands = (rows + TILE_ROWS - 1) / TILE_ROWS;
+	vector<uint64_t> bandSums(bands, 0);
+
+	getScheduler().parallelFor(bands, [&](int band)
+	{
+		uint64_t sum = 0;
+		int endRow = min(rows, (band + 1) * TILE_ROWS);
+		for (int x = band * TILE_ROWS; x < endRow; ++x)
+		{
+			for (int y = 0; y < cols; y += 64)
+			{
+				uint64_t word = 0;
+				for (int bit = 0; bit < 64 && y + bit < cols; ++bit)
+				{
+					word |= uint64_t(grid.isAlive(x, y + bit)) << bit;
+				}
+				sum = mixBits(sum ^ word) + 1;
+			}
+		}
+		bandSums[band] = sum;
+	});
+
+	uint64_t checksum = mixBits((uint64_t(rows) << 32) | uint64_t(cols));
+	for (uint64_t sum : bandSums)
+	{
+		checksum = mixBits(checksum ^ sum);
+	}
+	return checksum;
+}
+
+// Class to store the checksum of each generation a run stopped at, so a replay can be checked against it.
+class ReplayLog
+{
+
+	private:
+		map<int, uint64_t> checksums; // generation to checksum
+	public:
+		// Get functions
+		const map<int, uint64_t>& getChecksums() const { return checksums; }
+		bool empty() const { return checksums.empty(); }
+
+		bool getChecksum(int generation, uint64_t& checksum) const
+		{
+			auto found = checksums.find(generation);
+			if (found == checksums.end())
+			{
+				return false;
+			}
+			checksum = found->second;
+			return true;
+		}
+
+		// Set functions
+		void record(int generation, uint64_t checksum) { checksums[generation] = checksum; }
+		void clear() { checksums.clear(); }
+
+		// Compares every generation both logs have. Returns the first generation that differs, or -1 if none do.
+		int firstMismatch(const ReplayLog& other, int& compared) const
+		{
+			compared = 0;
+			for (const auto& entry : checksums)
+			{
+				uint64_t otherChecksum;
+				if (other.getChecksum(entry.first, otherChecksum))
+				{
+					compared++;
+					if (otherChecksum != entry.second)
+					{
+						return entry.first;
+					}
+				}
+			}
+			return -1;
+		}
+};
+
+// Shows whether a replay gave the same grids as the saved run at every generation both of them stopped at.
+void displayReplayCheck(const ReplayLog& saved, const ReplayLog& replay)
+{
+	int compared;
+	int mismatch = saved.firstMismatch(replay, compared);
+	if (mismatch >= 0)
+	{
+		cout << endl << "Error: Replay differs from the saved run at generation " << mismatch << ".";
+	}
+	else
+	{
+		cout << endl << "Replay matches the saved run at all " << compared << " checked generations.";
+	}
+}
+
+const int HISTORY_KEYFRAME_INTERVAL = 64; // generations recorded between two whole frames of a rewind history
+
+// Appends a number to a byte buffer seven bits at a time, the top bit of each byte saying whether more follow.
+inline void writeVarint(vector<uint8_t>& out, uint64_t value)
+{
+	while (value >= 0x80)
+	{
+		out.push_back(static_cast<uint8_t>(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back(static_cast<uint8_t>(value));
+}
+
+// Reads a number written by writeVarint and moves in past it.
+inline uint64_t readVarint(const uint8_t*& in)
+{
+	uint64_t value = 0;
+	for (int shift = 0; ; shift += 7)
+	{
+		uint8_t byte = *in++;
+		value |= uint64_t(byte & 0x7f) << shift;
+		if (byte < 0x80)
+		{
+			return value;
+		}
+	}
+}
+
+// Run-length codes the bytes of words as pairs of counts, zero bytes skipped then bytes copied, followed by the copied bytes.
+// A copy only ends at two zero bytes in a row, as one would cost as much to skip as to copy. The XOR of two generations is mostly
+// zero bytes, so a frame that changed in a few places takes a few bytes.
+void encodeByteRuns(const uint64_t* words, size_t count, vector<uint8_t>& out)
+{
+	const uint8_t* bytes = reinterpret_cast<const uint8_t*>(words);
+	size_t total = count * sizeof(uint64_t);
+	size_t i = 0;
+	while (i < total)
+	{
+		size_t start = i;
+		while (i < total && bytes[i] == 0)
+		{
+			i++;
+		}
+		size_t zeros = i - start;
+		start = i;
+		while (i < total && (bytes[i] != 0 || (i + 1 < total && bytes[i + 1] != 0)))
+		{
+			i++;
+		}
+		writeVarint(out, zeros);
+		writeVarint(out, i - start);
+		out.insert(out.end(), bytes + start, bytes + i);
+	}
+}
+
+// Decodes bytes written by encodeByteRuns and XORs them into target, so a delta moves target on a generation and a whole frame XORed into zeros sets it.
+void xorByteRuns(const uint8_t* in, uint64_t* target, size_t count)
+{
+	uint8_t* bytes = reinterpret_cast<uint8_t*>(target);
+	size_t total = count * sizeof(uint64_t);
+	size_t i = 0;
+	while (i < total)
+	{
+		i += static_cast<size_t>(readVarint(in));
+		size_t literals = static_cast<size_t>(readVarint(in));
+		for (size_t j = 0; j < literals; ++j)
+		{
+			bytes[i++] ^= *in++;
+		}
+	}
+}
+
+// Recent generations of a run kept in memory so it can be rewound. Every HISTORY_KEYFRAME_INTERVAL recorded generations a whole frame is kept,
+// and each generation after it is kept as the run-length coded XOR with the one before. Rewinding decodes the nearest earlier whole frame
+// and applies the deltas up to the generation asked for, so it never costs more than one interval of deltas. When the history grows past
+// its budget the oldest whole frame and its deltas are dropped.
+class GenerationHistory
+{
+
+	private:
+		// A whole frame and the deltas recorded after it. offsets[i] is where frame i starts in data.
+		struct Segment
+		{
+			vector<int> generations;
+			vector<size_t> offsets;
+			vector<uint8_t> data;
+		};
+
+		size_t budget;
+		int rows;
+		int cols;
+		int words;
+		deque<Segment> segments;
+		size_t bytes;
+		vector<uint64_t> last; // packed cells of the newest generation
+		vector<uint64_t> packed;
+		vector<uint64_t> delta;
+	public:
+		GenerationHistory(size_t budgetBytes) : budget(budgetBytes), rows(0), cols(0), words(0), bytes(0) {}
+
+		// Get functions
+		bool empty() const { return segments.empty(); }
+		int getOldest() const { return segments.empty() ? -1 : segments.front().generations.front(); }
+		int getNewest() const { return segments.empty() ? -1 : segments.back().generations.back(); }
+		size_t getBytes() const { return bytes; }
+		size_t getKeyframes() const { return segments.size(); }
+
+		// Forgets every generation.
+		void clear()
+		{
+			segments.clear();
+			bytes = 0;
+		}
+
+		// Records the grid as it is at a generation later than the last one recorded.
+		template <typename T, typename Cell>
+		void record(int generation, const Grid<T, Cell>& grid)
+		{
+			if (grid.getRows() != rows || grid.getCols() != cols || (!segments.empty() && generation <= getNewest()))
+			{
+				clear();
+				rows = grid.getRows();
+				cols = grid.getCols();
+				words = (cols + 63) / 64;
+			}
+			packed.assign(static_cast<size_t>(rows) * words, 0);
+			for (int x = 0; x < rows; ++x)
+			{
+				for (int y = 0; y < cols; ++y)
+				{
+					packed[static_cast<size_t>(x) * words + y / 64] |= uint64_t(grid.isAlive(x, y)) << (y % 64);
+				}
+			}
+
+			bool keyframe = segments.empty() || segments.back().generations.size() >= static_cast<size_t>(HISTORY_KEYFRAME_INTERVAL);
+			if (keyframe)
+			{
+				segments.emplace_back();
+			}
+			Segment& segment = segments.back();
+			size_t before = segment.data.size();
+			segment.generations.push_back(generation);
+			segment.offsets.push_back(before);
+			if (keyframe)
+			{
+				encodeByteRuns(packed.data(), packed.size(), segment.data);
+			}
+			else
+			{
+				delta.resize(packed.size());
+				for (size_t i = 0; i < packed.size(); ++i)
+				{
+					delta[i] = packed[i] ^ last[i];
+				}
+				encodeByteRuns(delta.data(), delta.size(), segment.data);
+			}
+			bytes += segment.data.size() - before + sizeof(int) + sizeof(size_t);
+			last.swap(packed);
+
+			// The newest segment is always kept so the run can still be rewound a little
+			while (bytes > budget && segments.size() > 1)
+			{
+				const Segment& oldest = segments.front();
+				bytes -= oldest.data.size() + oldest.generations.size() * (sizeof(int) + sizeof(size_t));
+				segments.pop_front();
+			}
+		}
+
+		// Puts the cells of a recorded generation into the grid. Returns false, leaving the grid as it was, if that generation is not kept.
+		template <typename T, typename Cell>
+		bool rewind(int generation, Grid<T, Cell>& grid) const
+		{
+			return generation >= 0 && generation <= getNewest() && rewindBefore(generation, grid) == generation;
+		}
+
+		// Puts the cells of the latest recorded generation at or before a generation into the grid. Only drawn generations are recorded,
+		// so with temporal blocking the ones in between must be stepped on from here. Returns the generation put in the grid, or -1,
+		// leaving the grid as it was, if every recorded generation is later.
+		template <typename T, typename Cell>
+		int rewindBefore(int generation, Grid<T, Cell>& grid) const
+		{
+			auto segment = upper_bound(segments.begin(), segments.end(), generation, [](int wanted, const Segment& candidate) { return wanted < candidate.generations.front(); });
+			if (segment == segments.begin())
+			{
+				return -1;
+			}
+			--segment;
+			auto frame = upper_bound(segment->generations.begin(), segment->generations.end(), generation) - 1;
+
+			static thread_local vector<uint64_t> cells;
+			cells.assign(static_cast<size_t>(rows) * words, 0);
+			for (size_t i = 0; i <= static_cast<size_t>(frame - segment->generations.begin()); ++i)
+			{
+				xorByteRuns(segment->data.data() + segment->offsets[i], cells.data(), cells.size());
+			}
+			grid.reset(rows, cols);
+			for (int x = 0; x < rows; ++x)
+			{
+				for (int y = 0; y < cols; ++y)
+				{
+					grid.setAlive(x, y, (cells[static_cast<size_t>(x) * words + y / 64] >> (y % 64)) & 1u);
+				}
+			}
+			return *frame;
+		}
+};
+
+// Runs the simulation with an engine that already holds the grid, so a caller stepping many short runs can keep one engine and its buffers.
+// If a history is given every drawn generation is recorded in it so the run can be rewound. With a renderer only the changed cells of each frame are drawn,
+// and if an overview map is given as well the renderer shows the density of the live rows the engine writes to it instead of the cells.
+// An exporter is handed the live rows of exportRows for every generation its stride asks for.
+template <typename T>
+void runLoadedSimulation(Grid<T>& grid, int totalCycles, int blockDepth, StepEngine<T, NormalCell<T>>& engine, ReplayLog* log = nullptr, GenerationHistory* history = nullptr,
+	TerminalRenderer* renderer = nullptr, const ActivityMap* overview = nullptr, FrameExporter* exporter = nullptr, const ActivityMap* exportRows = nullptr)
+{
+	// Runs the simulation for x cycles
+	int currentCycle = 0;
+	if (log)
+	{
+		log->record(0, gridChecksum(grid));
+	}
+	if (history)
+	{
+		history->record(0, grid);
+	}
+
+	// Returns the live rows a map holds, or packs them from the grid if no step has written the map yet
+	int words = (grid.getCols() + 63) / 64;
+	vector<uint64_t> packed;
+	auto packedRows = [&](const ActivityMap* map) -> const uint64_t*
+	{
+		if (map->isReady())
+		{
+			return map->getLiveRow(0);
+		}
+		packed.assign(static_cast<size_t>(grid.getRows()) * words, 0);
+		for (int x = 0; x < grid.getRows(); ++x)
+		{
+			for (int y = 0; y < grid.getCols(); ++y)
+			{
+				packed[static_cast<size_t>(x) * words + y / 64] |= uint64_t(grid.isAlive(x, y)) << (y % 64);
+			}
+		}
+		return packed.data();
+	};
+
+	int exportedCycle = -1;
+	auto drawFrame = [&]()
+	{
+		if (exporter && exportRows && currentCycle != exportedCycle && exporter->wants(currentCycle))
+		{
+			exporter->push(packedRows(exportRows), words, grid.getRows(), grid.getCols(), currentCycle);
+			exportedCycle = currentCycle;
+		}
+
+		if (renderer && overview)
+		{
+			drawDensityOverview(*renderer, packedRows(overview), words, grid.getRows(), grid.getCols(), currentCycle);
+		}
+		else if (renderer)
+		{
+			renderer->draw(grid.view(), currentCycle);
+		}
+		else
+		{
+			cout << grid;
+		}
+	};
+
+	bool allDead = false;
+	while (currentCycle < totalCycles)
+	{
+		drawFrame();
+
+		// With temporal blocking a frame is drawn once per block of generations.
+		int generations = min(blockDepth, totalCycles - currentCycle);
+		engine.step(generations);
+		engine.store(grid);
+		currentCycle += generations;
+		if (log)
+		{
+			log->record(currentCycle, gridChecksum(grid));
+		}
+		if (history)
+		{
+			history->record(currentCycle, grid);
+		}
+
+		// checks to see if all cells are dead. if so stops function prematurely
+		if (engine.allDead())
+		{
+			allDead = true;
+			break;
+		}
+	}
+
+	if (renderer)
+	{
+		drawFrame();
+		renderer->finish();
+	}
+	else if (exporter && exportRows && exporter->wants(currentCycle) && currentCycle != exportedCycle)
+	{
+		exporter->push(packedRows(exportRows), words, grid.getRows(), grid.getCols(), currentCycle);
+	}
+	if (allDead)
+	{
+		cout << endl << "All cells have died. Stopping simulation.";
+	}
+}
+
+// Updates the grid for X cycles. If a log is given the checksum of every drawn generation and the last one is recorded in it.
+template <typename T>
+void runSimulation(Grid<T> &grid, int totalCycles, const SimulationSettings& settings, ChangeMap* changes = nullptr, ActivityMap* activity = nullptr, ReplayLog* log = nullptr,
+	GenerationHistory* history = nullptr)
+{
+	unique_ptr<StepEngine<T, NormalCell<T>>> engine = createEngine(grid, settings);
+	engine->load(grid);
+	engine->trackChanges(changes);
+	engine->trackActivity(activity);
+	unique_ptr<TerminalRenderer> renderer;
+	unique_ptr<FrameExporter> exporter;
+	ActivityMap liveRows;
+	if (settings.getDisplay() != DisplayType::FullFrames)
+	{
+		renderer = unique_ptr<TerminalRenderer>(new TerminalRenderer(cout, settings.getViewTop(), settings.getViewLeft()));
+	}
+	if (!settings.getExport().prefix.empty())
+	{
+		exporter = unique_ptr<FrameExporter>(new FrameExporter(settings.getExport()));
+	}
+	bool overview = settings.getDisplay() == DisplayType::DensityOverview;
+	if ((overview || exporter) && !activity)
+	{
+		engine->trackActivity(&liveRows);
+		activity = &liveRows;
+	}
+	runLoadedSimulation(grid, totalCycles, settings.getBlockDepth(), *engine, log, history, renderer.get(),
+		overview ? activity : nullptr, exporter.get(), activity);
+	if (exporter)
+	{
+		exporter->finish();
+		cout << endl << exporter->getWritten() << " frames exported, " << exporter->getDropped() << " dropped.";
+	}
+}
+
+// Jumps the grid straight to a generation without drawing any frames.
+template <typename T>
+void fastForward(Grid<T>& grid, int generations, const SimulationSettings& settings)
+{
+	unique_ptr<StepEngine<T, NormalCell<T>>> engine = createEngine(grid, settings);
+	engine->load(grid);
+
+	// Steps in large chunks so a run that dies out can stop early. Without births from zero neighbours a dead grid stays dead.
+	const int CHUNK = 256;
+	bool deadStaysDead = (settings.getRule().getBirth() & 1u) == 0;
+	int currentCycle = 0;
+	while (currentCycle < generations && !(deadStaysDead && engine->allDead()))
+	{
+		int chunk = min(CHUNK, generations - currentCycle);
+		engine->step(chunk);
+		currentCycle += chunk;
+	}
+	engine->store(grid);
+}
+
+const int SPACESHIP_MAX_PERIOD = 16; // longest period a moving object is looked for over
+const int SPACESHIP_MAX_SIZE = 64; // objects taller or wider than this are not hashed
+
+// An object that came back displaced after period generations, moving dx rows down and dy columns across. row and col are its top left corner now.
+struct MovingObject
+{
+	int period;
+	int dx;
+	int dy;
+	int row;
+	int col;
+};
+
+// Finds spaceships of any shape while a simulation runs. Each generation every object with a live cell in a changed tile is found by grouping
+// live cells up to two apart, normalised to its bounding box and hashed. An object whose hash was seen up to SPACESHIP_MAX_PERIOD generations ago
+// at another place is run on its own for that many generations to check it really moves that way, so debris that happens to look the same is not counted.
+// Objects that did not change are never hashed, and the buffers are kept between generations, so a warm update costs little more than the flood fill.
+class SpaceshipTracker
+{
+
+	private:
+		// One object seen in a generation.
+		struct Sighting
+		{
+			uint64_t hash;
+			int row;
+			int col;
+
+			bool operator<(const Sighting& other) const { return hash < other.hash; }
+		};
+
+		RuleSpec rule;
+		int generation;
+		vector<vector<Sighting>> history; // sightings of the last SPACESHIP_MAX_PERIOD generations, sorted by hash
+		map<tuple<uint64_t, int, int, int>, bool> checked; // whether a shape really moves by (period, dx, dy)
+		vector<uint32_t> visited; // stamp of the last update that reached each cell
+		uint32_t stamp;
+		vector<pair<int, int>> stack;
+		vector<pair<int, int>> objectCells;
+		vector<uint64_t> shape;
+		vector<MovingObject> found;
+
+		// Hashes an object's rows with its size, so the same shape anywhere in the grid has the same hash.
+		uint64_t hashShape(int rows, int cols) const
+		{
+			uint64_t hash = mixBits((uint64_t(rows) << 32) | uint32_t(cols));
+			for (int r = 0; r < rows; ++r)
+			{
+				hash = mixBits(hash ^ shape[r]);
+			}
+			return hash;
+		}
+
+		// Runs the shape on its own and returns whether it is the same shape dx rows and dy columns away after period generations.
+		bool movesBy(int rows, int cols, int period, int dx, int dy) const
+		{
+			// Nothing moves faster than one cell a generation, so a margin of period cells keeps every cell it could reach.
+			int margin = period + 1;
+			int paddedRows = rows + 2 * margin;
+			int paddedCols = cols + 2 * margin;
+			int words = (paddedCols + 63) / 64;
+			uint64_t lastMask = paddedCols % 64 == 0 ? ~uint64_t(0) : (uint64_t(1) << (paddedCols % 64)) - 1;
+			auto place = [&](vector<uint64_t>& cells, int top, int left)
+			{
+				cells.assign(static_cast<size_t>(paddedRows) * words, 0);
+				for (int r = 0; r < rows; ++r)
+				{
+					for (int c = 0; c < cols; ++c)
+					{
+						int y = left + c;
+						cells[static_cast<size_t>(top + r) * words + y / 64] |= ((shape[r] >> c) & 1u) << (y % 64);
+					}
+				}
+			};
+
+			static thread_local vector<uint64_t> cells;
+			static thread_local vector<uint64_t> next;
+			static thread_local vector<uint64_t> expected;
+			vector<uint64_t> deadRow(words, 0);
+			place(cells, margin, margin);
+			place(expected, margin + dx, margin + dy);
+			next.resize(cells.size());
+			dispatchRule(rule, [&](auto compiledRule)
+			{
+				for (int generation = 0; generation < period; ++generation)
+				{
+					for (int x = 0; x < paddedRows; ++x)
+					{
+						const uint64_t* up = x > 0 ? &cells[static_cast<size_t>(x - 1) * words] : deadRow.data();
+						const uint64_t* down = x + 1 < paddedRows ? &cells[static_cast<size_t>(x + 1) * words] : deadRow.data();
+						stepPackedRow(up, &cells[static_cast<size_t>(x) * words], down, &next[static_cast<size_t>(x) * words], words, lastMask, compiledRule);
+					}
+					cells.swap(next);
+				}
+			});
+			return cells == expected;
+		}
+
+		// Looks for the object now in shape at (row, col) among the sightings of earlier generations, nearest first, and adds it to found if it moved.
+		void matchObject(uint64_t hash, int rows, int cols, int row, int col)
+		{
+			int depth = static_cast<int>(history.size());
+			for (int period = 1; period < depth && period <= generation; ++period)
+			{
+				const vector<Sighting>& earlier = history[(generation - period) % depth];
+				auto range = equal_range(earlier.begin(), earlier.end(), Sighting{ hash, 0, 0 });
+				for (auto sighting = range.first; sighting != range.second; ++sighting)
+				{
+					int dx = row - sighting->row;
+					int dy = col - sighting->col;
+					if ((dx == 0 && dy == 0) || abs(dx) > period || abs(dy) > period)
+					{
+						continue;
+					}
+					auto key = make_tuple(hash, period, dx, dy);
+					auto result = checked.find(key);
+					if (result == checked.end())
+					{
+						result = checked.emplace(key, movesBy(rows, cols, period, dx, dy)).first;
+					}
+					if (result->second)
+					{
+						found.push_back(MovingObject{ period, dx, dy, row, col });
+						return;
+					}
+				}
+			}
+		}
+
+	public:
+		SpaceshipTracker(const RuleSpec& rule = RuleSpec()) : rule(rule), generation(0), history(SPACESHIP_MAX_PERIOD + 1), stamp(0) {}
+
+		// Get functions
+		const vector<MovingObject>& getFound() const { return found; }
+
+		// Forgets every earlier generation, for a new soup in the same grid.
+		void clear()
+		{
+			generation = 0;
+			for (auto& sightings : history)
+			{
+				sightings.clear();
+			}
+			found.clear();
+		}
+
+		// Hashes the objects in the tiles the changes mark, clears them and returns whether any object has come back displaced.
+		// Every object that did is in getFound until the next update.
+		template <typename T, typename Cell>
+		bool update(const Grid<T, Cell>& grid, ChangeMap& changes)
+		{
+			int rows = grid.getRows();
+			int cols = grid.getCols();
+			if (visited.size() != static_cast<size_t>(rows) * cols)
+			{
+				visited.assign(static_cast<size_t>(rows) * cols, 0);
+				stamp = 0;
+			}
+			if (++stamp == 0)
+			{
+				fill(visited.begin(), visited.end(), 0);
+				stamp = 1;
+			}
+
+			int depth = static_cast<int>(history.size());
+			vector<Sighting>& sightings = history[generation % depth];
+			sightings.clear();
+			found.clear();
+
+			for (int tileRow = 0; tileRow < changes.getTilesDown(); ++tileRow)
+			{
+				for (int tileCol = 0; tileCol < changes.getTilesAcross(); ++tileCol)
+				{
+					if (!changes.isChanged(tileRow, tileCol))
+					{
+						continue;
+					}
+					for (int x = tileRow * TILE_ROWS; x < min(rows, (tileRow + 1) * TILE_ROWS); ++x)
+					{
+						for (int y = tileCol * TILE_COLS; y < min(cols, (tileCol + 1) * TILE_COLS); ++y)
+						{
+							if (!grid.isAlive(x, y) || visited[static_cast<size_t>(x) * cols + y] == stamp)
+							{
+								continue;
+							}
+
+							// Flood fill the object
+							objectCells.clear();
+							stack.assign(1, make_pair(x, y));
+							visited[static_cast<size_t>(x) * cols + y] = stamp;
+							int top = x, bottom = x, left = y, right = y;
+							while (!stack.empty())
+							{
+								pair<int, int> cell = stack.back();
+								stack.pop_back();
+								objectCells.push_back(cell);
+								top = min(top, cell.first);
+								bottom = max(bottom, cell.first);
+								left = min(left, cell.second);
+								right = max(right, cell.second);
+								for (int nx = max(0, cell.first - 2); nx <= min(rows - 1, cell.first + 2); ++nx)
+								{
+									for (int ny = max(0, cell.second - 2); ny <= min(cols - 1, cell.second + 2); ++ny)
+									{
+										if (visited[static_cast<size_t>(nx) * cols + ny] != stamp && grid.isAlive(nx, ny))
+										{
+											visited[static_cast<size_t>(nx) * cols + ny] = stamp;
+											stack.push_back(make_pair(nx, ny));
+										}
+									}
+								}
+							}
+
+							int height = bottom - top + 1;
+							int width = right - left + 1;
+							if (height > SPACESHIP_MAX_SIZE || width > SPACESHIP_MAX_SIZE)
+							{
+								continue;
+							}
+							shape.assign(height, 0);
+							for (const auto& cell : objectCells)
+							{
+								shape[cell.first - top] |= uint64_t(1) << (cell.second - left);
+							}
+							uint64_t hash = hashShape(height, width);
+							sightings.push_back(Sighting{ hash, top, left });
+							matchObject(hash, height, width, top, left);
+						}
+					}
+				}
+			}
+			sort(sightings.begin(), sightings.end());
+			changes.clear();
+			generation++;
+			return !found.empty();
+		}
+};
+
+// returns based if still life has remained for required generations
+template <typename T>
+bool checkForStableStillLife(Grid<T>& grid, IncrementalDetector& detector, ChangeMap& changes, ActivityMap& activity, int &stableGenerations, int currentCycle){
+	if (currentCycle > 0 && detector.update(grid, changes, &activity))
+	{
+		stableGenerations++;
+	}
+	else
+	{
+		stableGenerations = 0;
+	}
+	if (stableGenerations >= 2)
+	{
+		return true;
+	}
+	return false;
+
+}
+
+// returns based if oscillator has remained for required generations
+template <typename T>
+bool checkForStableOscillator(Grid<T>& grid, IncrementalDetector& detector, ChangeMap& changes, ActivityMap& activity, int& stableGenerations, int currentCycle)
+{
+	if (currentCycle > 0 && detector.update(grid, changes, &activity))
+	{
+		stableGenerations++;
+	}
+	else
+	{
+		stableGenerations = 0;
+	}
+	if (stableGenerations >= 3)
+	{
+		return true;
+	}
+	return false;
+}
+
+// returns based if an object has come back displaced. The tracker has already run it on its own for a whole period, so one sighting is enough.
+template <typename T>
+bool checkForStableSpaceship(Grid<T>& grid, SpaceshipTracker& tracker, ChangeMap& changes)
+{
+	return tracker.update(grid, changes);
+}
+
+// Function to check if all cells are dead. Scans bands of rows in parallel and stops as soon as any band finds a live cell.
+template <typename T, typename Cell>
+bool checkForDeadCells(const Grid<T, Cell>& grid)
+{
+	int rows = grid.getRows();
+	int cols = grid.getCols();
+	int bands = (rows + TILE_ROWS - 1) / TILE_ROWS;
+	atomic<bool> foundLive(false);
+
+	getScheduler().parallelFor(bands, [&](int band)
+	{
+		int endRow = min(rows, (band + 1) * TILE_ROWS);
+		for (int x = band * TILE_ROWS; x < endRow && !foundLive.load(memory_order_relaxed); ++x)
+		{
+			for (int y = 0; y < cols; ++y)
+			{
+				if (grid.isAlive(x, y))
+				{
+					foundLive = true;
+					return;
+				}
+			}
+		}
+	});
+	return !foundLive.load();
+}
+
+// Displays pattern menu
+int menu_displayPatternMenu()
+{
+	int patternChoice;
+
+
+	// Poorly implemented due to implementation with runExperiement will change if have time
+	while (true) {
+		cout << endl << "|| 1. Block and Beehive";
+		cout << endl << "|| 2. Blinker or toad";
+		cout << endl << "|| 3. Any spaceship";
+		cout << endl << "|| Choose a pattern to search for: ";
+
+		if (cin >> patternChoice)
+		{
+			if (patternChoice >= 1 && patternChoice <= 3)
+			{
+				break;
+			}
+			else
+			{
+				cout << "Error: Invalid choice. Please try again.";
+			}
+		}
+		else {
+			cout << endl << "Error: Invalid Option. Please try again.";
+			cin >> ClearAndIgnore();
+		}
+	}
+;
+
+	return patternChoice;
+}
+
+// runs infinite simulation until chosen patterns are found
+template <typename T>
+void runExperiment(Grid<T>& grid, const SimulationSettings& settings)
+{
+	int MAX_EXPERIMENT = 300;
+	int patternChoice = menu_displayPatternMenu();
+	int experimentCount = 0;
+	int stableGenerations = 0; // Track how many 'frames' the pattern appears for.
+	bool patternFound = false;
+	int cycles = 1;
+	int totalCycles;
+	int totalCells;
+	bool allowedInput = false;
+	ChangeMap changes(grid.getRows(), grid.getCols());
+	ActivityMap activity; // live cells written by each step so the detector can skip empty areas
+	
+	// Check input
+	while (!allowedInput)
+	{
+		cout << endl << "Enter the number of phases to run per experiement: ";
+		cin >> totalCycles;
+
+		if (isValidInput(totalCycles))
+		{
+			cout << endl << "Enter the number of living cells per experiment: ";
+			cin >> totalCells;
+			
+			if (isValidInput(totalCells))
+			{
+				allowedInput = true;
+			}
+		}
+	}
+
+	// Keeps the chosen pattern's matches between generations so only tiles near changed cells are scanned again
+	IncrementalDetector detector(patternChoice == 1 ? getStillLifePatterns() : patternChoice == 2 ? getOscillatorPatterns() : getSpaceshipPatterns());
+	SpaceshipTracker tracker(settings.getRule());
+
+	// One engine is kept for every experiment. Each soup is cleared into the same grid and the engine's buffers are reused,
+	// so once the first experiment has warmed them up the loop does no heap work.
+	unique_ptr<StepEngine<T, NormalCell<T>>> engine = createEngine(grid, settings);
+	engine->trackChanges(&changes);
+	engine->trackActivity(&activity);
+	random_device rd;
+
+	while (!patternFound && experimentCount < MAX_EXPERIMENT)
+	{
+		unsigned int seed = rd(); // Generate new seed.
+		experimentCount++;
+		createCells(grid);
+		scatterCells(grid, totalCells, seed);
+		engine->load(grid);
+		changes.markAll();
+		activity.invalidate();
+		tracker.clear();
+
+		cout << endl << "Running experiment #" << experimentCount << endl;
+
+		int currentCycle = 0;
+		// need to add max cycle limit
+		while (currentCycle < totalCycles && !patternFound)
+		{
+			runLoadedSimulation(grid, cycles, settings.getBlockDepth(), *engine);
+			switch (patternChoice)
+			{
+				case 1:
+					// Check for block or beehive after each generation of cells.
+					if (checkForStableStillLife(grid, detector, changes, activity, stableGenerations, currentCycle))
+					{
+						patternFound = true;
+						cout << endl << "Block or Beehive detected in experiment #" << experimentCount << " after " << currentCycle << " generations!";
+						calculateERN(grid.view(), totalCells, &patternChoice);
+					}
+					break;
+				case 2:
+					// Check for blinker or toad after each geneation of cells
+					if (checkForStableOscillator(grid, detector, changes, activity, stableGenerations, currentCycle))
+					{
+						patternFound = true;
+						cout << endl << "Blinker or Toad detected in experiment #" << experimentCount << " after " << currentCycle << " generations!";
+						calculateERN(grid.view(), totalCells, &patternChoice);
+					}
+					break;
+				case 3:
+					// Check for any object that has moved after each generation of cells
+					if (checkForStableSpaceship(grid, tracker, changes))
+					{
+						const MovingObject& ship = tracker.getFound()[0];
+						patternFound = true;
+						cout << endl << "Spaceship with period " << ship.period << " moving (" << ship.dx << ", " << ship.dy << ") detected at (" << ship.row << ", " << ship.col
+							<< ") in experiment #" << experimentCount << " after " << currentCycle << " generations!";
+						calculateERN(grid.view(), totalCells, &patternChoice, &ship);
+					}
+					break;
+
+
+			}
+
+			if (patternFound)
+			{
+				menu_displaySaveMenu(grid.view(), seed, totalCycles, totalCells, nullptr, settings.getRule());
+				break;
+			}
+			
+			// stop experiment prematurely if grid contains only dead cells. Prevents waiting if cycles is set to a large number.
+			if (checkForDeadCells(grid))
+			{
+				cout << grid;
+				cout << endl << "All Cells for experiment #" << experimentCount << " have died.";
+				break;
+			}
+			currentCycle++;
+		}
+		if (experimentCount == MAX_EXPERIMENT)
+		{
+			cout << endl << "Error: Hard Limit Reached. Start another experiment";
+		}
+	}
+}
+
+// Calculates the ERN for the simulation or pattern. For a spaceship the one that was found is named if it is given.
+template <typename T>
+void calculateERN(GridView<T> grid, int totalCells, int* patternChoice, const MovingObject* ship = nullptr)
+{
+	int xSpaces = grid.getRows();
+	int ySpaces = grid.getCols();
+	// Create a dictionary of patterns with the phase that has the minium amount of available cells to appear.
+	int ern = xSpaces + ySpaces + totalCells;
+
+	if (patternChoice != nullptr)
+	{
+		map<string, int> minGridForPattern = {
+			{"Block", 4},
+			{"Beehive", 12},
+			{"Blinker", 9},
+			{"Toad", 16},
+			{"Glider", 9}
+		};
+
+		switch (*patternChoice)
+		{
+		case 1:
+		{
+			int blockMinCells = minGridForPattern["Block"];
+			int beehiveMinCells = minGridForPattern["Beehive"];
+			int gridSize = xSpaces * ySpaces;
+
+			if (gridSize < blockMinCells && gridSize < beehiveMinCells) {
+				cout << endl << "A block or a beehive cannot appear in a " << xSpaces << "x" << ySpaces << "grid. ERN Unavailable.";
+				break;
+			}
+			else if (gridSize >= blockMinCells && gridSize < beehiveMinCells) {
+				cout << endl << "A beehive cannot appear in a " << xSpaces << "x" << ySpaces << " grid.";
+				cout << endl << "ERN for Block is: " << ern;
+				break;
+			}
+			else {
+				cout << endl << "The ERN for a block or a beehive in a " << xSpaces << "x" << ySpaces << " grid is: " << ern;
+				break;
+			}
+			break;
+		}
+
+		case 2:
+		{
+			int blinkerMinCells = minGridForPattern["Blinker"];
+			int toadMinCells = minGridForPattern["Toad"];
+			int gridSize = xSpaces * ySpaces;
+
+			if (gridSize < blinkerMinCells && gridSize < toadMinCells)
+			{
+				cout << endl << "A blinker or a toad cannot appear in a " << xSpaces << "x" << ySpaces << " grid. ERN Unavailable.";
+				break;
+			}
+			else if (gridSize >= blinkerMinCells && gridSize < toadMinCells)
+			{
+				cout << endl << "A toad cannot appear in a " << xSpaces << "x" << ySpaces << " grid.";
+				cout << endl << "ERN for blinker is: " << ern;
+				break;
+			}
+			else
+			{
+				cout << endl << "The ERN for a blinker or a toad in a " << xSpaces << "x" << ySpaces << " grid is: " << ern;
+				break;
+			}
+			break;
+		}
+		case 3:
+		{
+			// The glider is the smallest spaceship, so no spaceship fits in a grid a glider cannot
+			int spaceshipMinCells = minGridForPattern["Glider"];
+			int gridSize = xSpaces * ySpaces;
+
+			if (gridSize < spaceshipMinCells)
+			{
+				cout << endl << "A spaceship cannot appear in a " << xSpaces << "x" << ySpaces << " grid. ERN Unavailable";
+				break;
+			}
+			else if (ship != nullptr)
+			{
+				cout << endl << "The ERN for a spaceship with period " << ship->period << " moving (" << ship->dx << ", " << ship->dy << ") in a "
+					<< xSpaces << "x" << ySpaces << " grid is: " << ern;
+				break;
+			}
+			else
+			{
+				cout << endl << "The ERN for a spaceship in a " << xSpaces << "x" << ySpaces << " grid is: " << ern;
+				break;
+			}
+			break;
+		}
+
+		default:
+			cout << endl << "Unknown pattern. ERN Unavailable";
+		}
+	}
+
+	cout << endl << "The ERN for a " << xSpaces << "x" << ySpaces << " grid with " << totalCells << " live cells is: " << ern;
+}
+
+// RESULT CACHE
+
+const int CACHE_VERSION = 2; // raise whenever a change to stepping could change the cells a run ends with
+const uint64_t CACHE_SNAPSHOT_LIMIT = uint64_t(64) << 20; // final grids with larger snapshots only have their summary cached
+
+// Creates a folder if it does not exist yet. Returns false if it does not exist afterwards.
+bool makeDirectory(const string& directory)
+{
+#ifdef _WIN32
+	return CreateDirectoryA(directory.c_str(), nullptr) != 0 || GetLastError() == ERROR_ALREADY_EXISTS;
+#else
+	struct stat info;
+	return mkdir(directory.c_str(), 0755) == 0 || (stat(directory.c_str(), &info) == 0 && S_ISDIR(info.st_mode));
+#endif
+}
+
+// What a cached run ended with.
+struct CachedResult
+{
+	uint64_t checksum;
+	int population;
+	bool hasSnapshot;
+	int rows; // grid size and live cells the ERN is worked out from
+	int cols;
+	int totalCells;
+	int endGeneration; // generation the run stopped at, earlier than asked for if every cell died
+	int settledAt; // first generation the grid stayed as it ended from, as far as the logged checksums show, or -1 if none were logged
+};
+
+// Sums up how a run ended. The settle generation is found from the log, so it is only as exact as the generations the log holds.
+template <typename T>
+CachedResult summarizeRun(const Grid<T>& grid, int totalCells, int endGeneration, const ReplayLog* log = nullptr)
+{
+	CachedResult result;
+	result.checksum = gridChecksum(grid);
+	result.population = 0;
+	for (int x = 0; x < grid.getRows(); ++x)
+	{
+		for (int y = 0; y < grid.getCols(); ++y)
+		{
+			result.population += grid.isAlive(x, y) ? 1 : 0;
+		}
+	}
+	result.hasSnapshot = false;
+	result.rows = grid.getRows();
+	result.cols = grid.getCols();
+	result.totalCells = totalCells;
+	result.endGeneration = endGeneration;
+	result.settledAt = -1;
+	if (log)
+	{
+		const map<int, uint64_t>& checksums = log->getChecksums();
+		for (auto entry = checksums.rbegin(); entry != checksums.rend() && entry->second == result.checksum; ++entry)
+		{
+			result.settledAt = entry->first;
+		}
+	}
+	return result;
+}
+
+// Shows how a run ended.
+void displayRunSummary(const CachedResult& result)
+{
+	cout << endl << "Generation " << result.endGeneration << ": checksum " << hex << result.checksum << dec << ", " << result.population << " live cells.";
+	if (result.settledAt >= 0 && result.settledAt < result.endGeneration)
+	{
+		cout << endl << "The grid has not changed since generation " << result.settledAt << ".";
+	}
+}
+
+// Finished runs kept on disk, so a run asked for again returns straight away. Each run is described by everything that decides its result:
+// the grid size, seed, cell count, sampler and generation, the engine, the rule and CACHE_VERSION. The description is hashed to name its files,
+// <hash>.csv holding the description and summary and <hash>.snap the final grid, and the description is checked on reading so two runs
+// that share a hash can never be mixed up.
+class ResultCache
+{
+
+	private:
+		string directory;
+	public:
+		ResultCache(const string& directory) : directory(directory) {}
+
+		// Get functions
+		bool isEnabled() const { return !directory.empty(); }
+
+		// Returns the path of a run's files without the extension.
+		string getEntryPath(const string& description) const
+		{
+			// FNV-1a
+			uint64_t hash = 14695981039346656037ULL;
+			for (char c : description)
+			{
+				hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+			}
+			stringstream path;
+			path << directory << "/" << hex << setw(16) << setfill('0') << hash;
+			return path.str();
+		}
+
+		// Returns the description of a run of a soup.
+		static string describe(int rows, int cols, unsigned int seed, int totalCells, int generations, const SimulationSettings& settings,
+			int scatterVersion = SCATTER_VERSION)
+		{
+			stringstream description;
+			description << rows << "," << cols << "," << seed << "," << totalCells << "," << generations << ","
+				<< engineName(settings.getEngine()) << "," << settings.getRule().toString() << ",s" << scatterVersion << ",v" << CACHE_VERSION;
+			return description.str();
+		}
+
+		// Returns the description of a replay of a soup. A replay logs the checksum of every drawn generation, so it also depends on the generations per pass.
+		static string describeReplay(int rows, int cols, unsigned int seed, int totalCells, int generations, const SimulationSettings& settings,
+			int scatterVersion = SCATTER_VERSION)
+		{
+			return describe(rows, cols, seed, totalCells, generations, settings, scatterVersion) + ",replay every " + to_string(settings.getBlockDepth());
+		}
+
+		// Reads the summary of a run, and the checksums it logged if a log is given. Returns false if the run is not cached.
+		bool lookup(const string& description, CachedResult& result, ReplayLog* log = nullptr) const
+		{
+			if (!isEnabled())
+			{
+				return false;
+			}
+			ifstream entryFile(getEntryPath(description) + ".csv");
+			string line;
+			if (!entryFile.is_open() || !getline(entryFile, line) || line != description || !getline(entryFile, line))
+			{
+				return false;
+			}
+			stringstream ss(line);
+			char comma;
+			if (!(ss >> hex >> result.checksum >> dec >> comma >> result.population >> comma >> result.hasSnapshot >> comma >> result.rows >> comma >> result.cols
+				>> comma >> result.totalCells >> comma >> result.endGeneration >> comma >> result.settledAt))
+			{
+				return false;
+			}
+
+			// The summary is followed by the logged checksums, one generation and checksum per line
+			if (log)
+			{
+				log->clear();
+				while (getline(entryFile, line))
+				{
+					stringstream entry(line);
+					int generation;
+					uint64_t checksum;
+					if (!(entry >> generation >> comma >> hex >> checksum))
+					{
+						return false;
+					}
+					log->record(generation, checksum);
+				}
+			}
+			return true;
+		}
+
+		// Reads the final grid of a run into grid. Returns false, leaving the grid as it was, if it is not cached or does not match its summary.
+		template <typename T>
+		bool loadGrid(const string& description, Grid<T>& grid) const
+		{
+			CachedResult result;
+			Grid<T> cached;
+			if (!lookup(description, result) || !result.hasSnapshot || !readSnapshotFile(getEntryPath(description) + ".snap", cached) || gridChecksum(cached) != result.checksum)
+			{
+				return false;
+			}
+			grid.swap(cached);
+			return true;
+		}
+
+		// Caches the final grid of a run with its summary, and the checksums it logged if a log is given. The summary is written last,
+		// under a temporary name and then renamed, so a run is only ever found once it is whole.
+		template <typename T>
+		bool store(const string& description, const Grid<T>& grid, const RuleSpec& rule, CachedResult summary, const ReplayLog* log = nullptr)
+		{
+			if (!isEnabled() || !makeDirectory(directory))
+			{
+				return false;
+			}
+			string path = getEntryPath(description);
+			summary.hasSnapshot = snapshotBytes(grid.getRows(), grid.getCols()) <= CACHE_SNAPSHOT_LIMIT && writeSnapshotFile(path + ".snap", grid.view(), 0, rule);
+
+			ofstream entryFile(path + ".csv.tmp");
+			entryFile << description << endl << hex << summary.checksum << dec << "," << summary.population << "," << summary.hasSnapshot << "," << summary.rows << ","
+				<< summary.cols << "," << summary.totalCells << "," << summary.endGeneration << "," << summary.settledAt << endl;
+			if (log)
+			{
+				for (const auto& entry : log->getChecksums())
+				{
+					entryFile << entry.first << "," << hex << entry.second << dec << endl;
+				}
+			}
+			entryFile.close();
+			remove((path + ".csv").c_str());
+			return !entryFile.fail() && rename((path + ".csv.tmp").c_str(), (path + ".csv").c_str()) == 0;
+		}
+};
+
+// SOUP SEARCH
+
+// Small grids are searched as one 64-bit board, row r in bits 8r to 8r + 7 with bit 8r + c being column c.
+const int SOUP_BOARD_SIDE = 8;
+const int MAX_SOUP_SIDE = 7; // largest grid side the menu offers. 7x7 already has 2^49 soups
+const int MAX_SOUP_GENERATIONS = 1024; // a soup that has not settled by then is stopped
+const uint64_t SOUP_CHUNK = 1 << 14; // soups per scheduler task
+
+// Returns a board with every cell of a rows x cols grid set.
+inline uint64_t boardMask(int rows, int cols)
+{
+	uint64_t rowMask = cols >= SOUP_BOARD_SIDE ? 0xFFu : (uint64_t(1) << cols) - 1;
+	uint64_t mask = 0;
+	for (int r = 0; r < rows; ++r)
+	{
+		mask |= rowMask << (SOUP_BOARD_SIDE * r);
+	}
+	return mask;
+}
+
+// Steps a board one generation. Cells outside the grid stay dead, as they do on a Grid.
+template <typename RuleT>
+inline uint64_t stepBoard(uint64_t board, uint64_t gridMask, RuleT rule)
+{
+	// Bit 8r + c of west holds cell (r, c - 1) and of east holds cell (r, c + 1)
+	uint64_t west = (board << 1) & 0xFEFEFEFEFEFEFEFEULL;
+	uint64_t east = (board >> 1) & 0x7F7F7F7F7F7F7F7FULL;
+	return stepWord(west << 8, board << 8, east << 8, west, board, east, west >> 8, board >> 8, east >> 8, rule) & gridMask;
+}
+
+// Reverses the order of the rows of a board with the given number of rows.
+inline uint64_t flipBoardRows(uint64_t board, int rows)
+{
+	board = ((board >> 8) & 0x00FF00FF00FF00FFULL) | ((board & 0x00FF00FF00FF00FFULL) << 8);
+	board = ((board >> 16) & 0x0000FFFF0000FFFFULL) | ((board & 0x0000FFFF0000FFFFULL) << 16);
+	board = (board >> 32) | (board << 32);
+	return board >> (SOUP_BOARD_SIDE * (SOUP_BOARD_SIDE - rows));
+}
+
+// Reverses the order of the columns of a board with the given number of columns.
+inline uint64_t flipBoardCols(uint64_t board, int cols)
+{
+	board = ((board >> 1) & 0x5555555555555555ULL) | ((board & 0x5555555555555555ULL) << 1);
+	board = ((board >> 2) & 0x3333333333333333ULL) | ((board & 0x3333333333333333ULL) << 2);
+	board = ((board >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((board & 0x0F0F0F0F0F0F0F0FULL) << 4);
+	// The low bits of every row are now empty, so the whole board can shift without rows bleeding into each other
+	return board >> (SOUP_BOARD_SIDE - cols);
+}
+
+// Swaps rows and columns, moving cell (r, c) to (c, r).
+inline uint64_t transposeBoard(uint64_t board)
+{
+	uint64_t t = (board ^ (board >> 7)) & 0x00AA00AA00AA00AAULL;
+	board ^= t ^ (t << 7);
+	t = (board ^ (board >> 14)) & 0x0000CCCC0000CCCCULL;
+	board ^= t ^ (t << 14);
+	t = (board ^ (board >> 28)) & 0x00000000F0F0F0F0ULL;
+	board ^= t ^ (t << 28);
+	return board;
+}
+
+// Returns whether a soup is the smallest board among its reflections and rotations. Every other soup behaves like one that is,
+// so only these need to be run. Square grids have eight symmetries, other grids four.
+inline bool isCanonicalSoup(uint64_t board, int rows, int cols)
+{
+	uint64_t flippedRows = flipBoardRows(board, rows);
+	uint64_t flippedCols = flipBoardCols(board, cols);
+	uint64_t turned = flipBoardCols(flippedRows, cols);
+	if (flippedRows < board || flippedCols < board || turned < board)
+	{
+		return false;
+	}
+	if (rows == cols)
+	{
+		uint64_t images[4] = { transposeBoard(board), transposeBoard(flippedRows), transposeBoard(flippedCols), transposeBoard(turned) };
+		for (uint64_t image : images)
+		{
+			if (image < board)
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+// Returns n choose k from a table built the first time it is used.
+uint64_t binomial(int n, int k)
+{
+	static const vector<vector<uint64_t>> table = []()
+	{
+		vector<vector<uint64_t>> rowsOfTable(65, vector<uint64_t>(65, 0));
+		for (int i = 0; i <= 64; ++i)
+		{
+			rowsOfTable[i][0] = 1;
+			for (int j = 1; j <= i; ++j)
+			{
+				rowsOfTable[i][j] = rowsOfTable[i - 1][j - 1] + (j < i ? rowsOfTable[i - 1][j] : 0);
+			}
+		}
+		return rowsOfTable;
+	}();
+	return (k < 0 || k > n) ? 0 : table[n][k];
+}
+
+// Returns the next larger number with the same number of set bits (Gosper's hack), which steps through combinations in colex order.
+inline uint64_t nextCombination(uint64_t combination)
+{
+	uint64_t lowest = combination & (~combination + 1);
+	uint64_t ripple = combination + lowest;
+	return (((ripple ^ combination) >> 2) / lowest) | ripple;
+}
+
+// Returns the combination of k set bits out of n at a position in colex order, so a task can start Gosper's hack part way through.
+uint64_t unrankCombination(uint64_t rank, int n, int k)
+{
+	uint64_t combination = 0;
+	for (int i = k; i >= 1; --i)
+	{
+		int bit = i - 1;
+		while (bit + 1 < n && binomial(bit + 1, i) <= rank)
+		{
+			++bit;
+		}
+		rank -= binomial(bit, i);
+		combination |= uint64_t(1) << bit;
+		n = bit;
+	}
+	return combination;
+}
+
+// Places a combination of rows * cols bits, one row after another, onto a board.
+inline uint64_t spreadToBoard(uint64_t combination, int rows, int cols)
+{
+	uint64_t rowMask = (uint64_t(1) << cols) - 1;
+	uint64_t board = 0;
+	for (int r = 0; r < rows; ++r)
+	{
+		board |= ((combination >> (r * cols)) & rowMask) << (SOUP_BOARD_SIDE * r);
+	}
+	return board;
+}
+
+// One place a pattern variant can sit on the board. The pattern is there when the cells under window are exactly alive.
+struct BoardPlacement
+{
+	uint64_t window;
+	uint64_t alive;
+	int endRow;
+	int endCol;
+};
+
+// Returns every placement of every variant of a pattern set on the board.
+vector<BoardPlacement> boardPlacements(const PatternSet& patterns)
+{
+	vector<BoardPlacement> placements;
+	for (const PatternMask& mask : patterns.getMasks())
+	{
+		for (int top = 0; top + mask.rows <= SOUP_BOARD_SIDE; ++top)
+		{
+			for (int left = 0; left + mask.cols <= SOUP_BOARD_SIDE; ++left)
+			{
+				BoardPlacement placement = { 0, 0, top + mask.rows, left + mask.cols };
+				for (int i = 0; i < mask.rows; ++i)
+				{
+					uint64_t rowWindow = ((uint64_t(1) << mask.cols) - 1) << left;
+					placement.window |= rowWindow << (SOUP_BOARD_SIDE * (top + i));
+					placement.alive |= (mask.alive[i] << left) << (SOUP_BOARD_SIDE * (top + i));
+				}
+				placements.push_back(placement);
+			}
+		}
+	}
+	return placements;
+}
+
+// Runs a soup until it settles into a cycle and returns a bit for each target that appears in any generation from the first on.
+// Only the targets in wanted are looked for. A cycle is found with Brent's method: a saved board is compared each generation
+// and moved on at every power of two, so when it comes round again every board of the cycle has been checked.
+template <typename RuleT>
+uint32_t runSoup(uint64_t soup, uint64_t gridMask, const vector<vector<BoardPlacement>>& placements, uint32_t wanted, RuleT rule)
+{
+	uint32_t seen = 0;
+	uint64_t board = soup;
+	uint64_t saved = soup;
+	int power = 1;
+	int sinceSaved = 0;
+	for (int generation = 1; generation <= MAX_SOUP_GENERATIONS; ++generation)
+	{
+		board = stepBoard(board, gridMask, rule);
+		for (uint32_t target = 0; target < placements.size(); ++target)
+		{
+			if (((wanted & ~seen) >> target) & 1u)
+			{
+				for (const BoardPlacement& placement : placements[target])
+				{
+					if ((board & placement.window) == placement.alive)
+					{
+						seen |= 1u << target;
+						break;
+					}
+				}
+			}
+		}
+		if (seen == wanted || board == saved)
+		{
+			break;
+		}
+		if (++sinceSaved == power)
+		{
+			saved = board;
+			power *= 2;
+			sinceSaved = 0;
+		}
+	}
+	return seen;
+}
+
+// Smallest soup found that produces a target. ERN is rows + cols + cells, the same measure calculateERN gives.
+struct SoupRecord
+{
+	bool found;
+	int rows;
+	int cols;
+	int cells;
+	uint64_t soup;
+
+	int getERN() const { return rows + cols + cells; }
+};
+
+// Searches every soup of every grid up to maxSide x maxSide, in order of increasing ERN, for the first soup that produces each pattern.
+// Grids are only searched one way round and soups only up to symmetry, as rotated and reflected grids give rotated and reflected runs
+// and the pattern sets hold every variant. The soups of each grid and cell count are shared between cores in chunks, and for each pattern
+// the soup with the lowest colex rank wins, so the answer does not depend on the number of cores.
+vector<SoupRecord> findLowestERNSoups(const vector<vector<vector<bool>>>& patterns, int maxSide, const RuleSpec& rule, const vector<string>* names = nullptr)
+{
+	int numTargets = static_cast<int>(patterns.size());
+	assert(numTargets <= 32 && maxSide <= SOUP_BOARD_SIDE);
+	vector<vector<BoardPlacement>> allPlacements;
+	for (const auto& pattern : patterns)
+	{
+		allPlacements.push_back(boardPlacements(PatternSet({ pattern })));
+	}
+	vector<SoupRecord> records(numTargets, SoupRecord{ false, 0, 0, 0, 0 });
+	uint32_t remaining = numTargets == 32 ? ~0u : (1u << numTargets) - 1;
+
+	dispatchRule(rule, [&](auto compiledRule)
+	{
+		for (int ern = 3; ern <= 2 * maxSide + maxSide * maxSide && remaining; ++ern)
+		{
+			uint32_t foundThisERN = 0;
+			for (int rows = 1; rows <= maxSide; ++rows)
+			{
+				for (int cols = rows; cols <= maxSide; ++cols)
+				{
+					int cells = ern - rows - cols;
+					int area = rows * cols;
+					if (cells < 1 || cells > area)
+					{
+						continue;
+					}
+
+					// Only placements inside this grid can match, and targets already found at this ERN keep the grid found first
+					vector<vector<BoardPlacement>> placements(numTargets);
+					uint32_t wanted = 0;
+					for (int target = 0; target < numTargets; ++target)
+					{
+						if (((remaining & ~foundThisERN) >> target) & 1u)
+						{
+							for (const BoardPlacement& placement : allPlacements[target])
+							{
+								if (placement.endRow <= rows && placement.endCol <= cols)
+								{
+									placements[target].push_back(placement);
+								}
+							}
+							if (!placements[target].empty())
+							{
+								wanted |= 1u << target;
+							}
+						}
+					}
+					if (!wanted)
+					{
+						continue;
+					}
+
+					uint64_t total = binomial(area, cells);
+					uint64_t chunkSize = max(SOUP_CHUNK, total / (1u << 20));
+					int chunks = static_cast<int>((total + chunkSize - 1) / chunkSize);
+					uint64_t gridMask = boardMask(rows, cols);
+					vector<atomic<uint64_t>> bestRank(numTargets);
+					for (auto& best : bestRank)
+					{
+						best.store(UINT64_MAX, memory_order_relaxed);
+					}
+
+					getScheduler().parallelFor(chunks, [&](int chunk)
+					{
+						uint64_t start = chunk * chunkSize;
+						uint64_t end = min(total, start + chunkSize);
+						uint64_t combination = unrankCombination(start, area, cells);
+						for (uint64_t rank = start; rank < end; ++rank, combination = nextCombination(combination))
+						{
+							// A target already found at a lower rank cannot be beaten by this chunk
+							uint32_t stillWanted = 0;
+							for (int target = 0; target < numTargets; ++target)
+							{
+								if (((wanted >> target) & 1u) && bestRank[target].load(memory_order_relaxed) > rank)
+								{
+									stillWanted |= 1u << target;
+								}
+							}
+							if (!stillWanted)
+							{
+								return;
+							}
+
+							uint64_t soup = spreadToBoard(combination, rows, cols);
+							if (!isCanonicalSoup(soup, rows, cols))
+							{
+								continue;
+							}
+							uint32_t seen = runSoup(soup, gridMask, placements, stillWanted, compiledRule);
+							for (int target = 0; target < numTargets; ++target)
+							{
+								uint64_t best = bestRank[target].load(memory_order_relaxed);
+								while (((seen >> target) & 1u) && rank < best && !bestRank[target].compare_exchange_weak(best, rank))
+								{
+								}
+							}
+						}
+					});
+
+					for (int target = 0; target < numTargets; ++target)
+					{
+						uint64_t best = bestRank[target].load();
+						if (best != UINT64_MAX)
+						{
+							records[target] = SoupRecord{ true, rows, cols, cells, spreadToBoard(unrankCombination(best, area, cells), rows, cols) };
+							foundThisERN |= 1u << target;
+							if (names)
+							{
+								cout << endl << "Found " << (*names)[target] << " with ERN " << ern << " (" << rows << "x" << cols << " grid, " << cells << " cells)";
+							}
+						}
+					}
+				}
+			}
+			remaining &= ~foundThisERN;
+		}
+	});
+	return records;
+}
+
+// Returns a grid holding a soup from the search.
+Grid<bool> soupToGrid(uint64_t soup, int rows, int cols)
+{
+	Grid<bool> grid(rows, cols);
+	for (int x = 0; x < rows; ++x)
+	{
+		for (int y = 0; y < cols; ++y)
+		{
+			grid.setAlive(x, y, (soup >> (SOUP_BOARD_SIDE * x + y)) & 1u);
+		}
+	}
+	return grid;
+}
+
+// Calculates and displays the lowest possible ERN for all paterns by searching every soup on grids up to maxSide x maxSide
+void displayLowestPossibleERN(int maxSide, const RuleSpec& rule)
+{
+	vector<vector<bool>> block = {
+		{true, true},
+		{true, true},
+	};
+
+	vector<vector<bool>> beehive = {
+		{false, true, true, false},
+		{true, false, false, true},
+		{false, true, true, false}
+	};
+
+	vector<vector<bool>> blinker =
+	{
+		{true},
+		{true},
+		{true}
+	};
+
+	vector<vector<bool>> toad =
+	{
+		{false, true, true, true},
+		{true, true, true, false}
+	};
+
+	vector<vector<bool>> glider =
+	{
+		{false, true, false},
+		{false, false, true},
+		{true, true, true}
+	};
+
+	vector<vector<bool>> lwss =
+	{
+		{false, true, false, false, true},
+		{true, false, false, false, false},
+		{true, false, false, false, true},
+		{true, true, true, true, false}
+	};
+
+	vector<vector<vector<bool>>> patterns = { block, beehive, blinker, toad, glider, lwss };
+	vector<string> patternNames = { "Block", "Beehive", "Blinker", "Toad", "Glider", "LWSS" };
+
+	cout << endl << "Searching every soup up to " << maxSide << "x" << maxSide << " with " << rule.toString() << "...";
+	vector<SoupRecord> records = findLowestERNSoups(patterns, maxSide, rule, &patternNames);
+
+	for (size_t p = 0; p < patterns.size(); ++p)
+	{
+		const SoupRecord& record = records[p];
+		if (!record.found)
+		{
+			cout << endl << "No soup up to " << maxSide << "x" << maxSide << " produces a " << patternNames[p] << ".";
+			continue;
+		}
+		cout << endl << "The lowest possible ERN for a " << patternNames[p] << " in a " << record.rows << "x" << record.cols << " grid is: " << record.getERN()
+			<< " (" << record.cells << " starting cells)" << endl;
+		cout << soupToGrid(record.soup, record.rows, record.cols);
+	}
+}
+
+// SOUP CENSUS
+
+const int MAX_CENSUS_GENERATIONS = 20000; // a soup that has not settled by then is counted as unsettled
+const int MAX_OBJECT_PERIOD = 64; // longest period an object is run for on its own
+const int OBJECT_MARGIN = 3; // dead cells kept around an object run on its own
+const int CENSUS_BATCH = 4096; // soups run between saves of the census
+
+// Steps packed cells one generation into next. Cells outside the rows x (words * 64) area stay dead and lastMask keeps the unused columns dead.
+template <typename RuleT>
+void stepPackedCells(const vector<uint64_t>& cells, vector<uint64_t>& next, int rows, int words, uint64_t lastMask, RuleT rule)
+{
+	static thread_local vector<uint64_t> deadRow;
+	deadRow.assign(words, 0);
+	next.resize(cells.size());
+	for (int x = 0; x < rows; ++x)
+	{
+		const uint64_t* up = x > 0 ? &cells[static_cast<size_t>(x - 1) * words] : deadRow.data();
+		const uint64_t* down = x + 1 < rows ? &cells[static_cast<size_t>(x + 1) * words] : deadRow.data();
+		stepPackedRow(up, &cells[static_cast<size_t>(x) * words], down, &next[static_cast<size_t>(x) * words], words, lastMask, rule);
+	}
+}
+
+// Runs packed cells until they repeat and returns the period, or 0 if they have not settled after MAX_CENSUS_GENERATIONS.
+// Uses Brent's method, so only one earlier state is kept: it is compared every generation and moved on at every power of two.
+template <typename RuleT>
+int settleCells(vector<uint64_t>& cells, int rows, int words, uint64_t lastMask, RuleT rule)
+{
+	static thread_local vector<uint64_t> saved;
+	static thread_local vector<uint64_t> next;
+	saved = cells;
+	int power = 1;
+	int sinceSaved = 0;
+	for (int generation = 1; generation <= MAX_CENSUS_GENERATIONS; ++generation)
+	{
+		stepPackedCells(cells, next, rows, words, lastMask, rule);
+		cells.swap(next);
+		++sinceSaved;
+		if (cells == saved)
+		{
+			return sinceSaved;
+		}
+		if (sinceSaved == power)
+		{
+			saved = cells;
+			power *= 2;
+			sinceSaved = 0;
+		}
+	}
+	return 0;
+}
+
+// A small group of cells as one word per row, bit c being column c, trimmed to its bounding box.
+struct CensusShape
+{
+	int rows;
+	int cols;
+	vector<uint64_t> bits;
+
+	bool operator<(const CensusShape& other) const
+	{
+		return tie(rows, cols, bits) < tie(other.rows, other.cols, other.bits);
+	}
+
+	bool operator==(const CensusShape& other) const
+	{
+		return rows == other.rows && cols == other.cols && bits == other.bits;
+	}
+};
+
+// Returns the shape with its rows in reverse order.
+CensusShape flipShapeRows(const CensusShape& shape)
+{
+	CensusShape flipped = shape;
+	reverse(flipped.bits.begin(), flipped.bits.end());
+	return flipped;
+}
+
+// Returns the shape with its columns in reverse order.
+CensusShape flipShapeCols(const CensusShape& shape)
+{
+	CensusShape flipped = { shape.rows, shape.cols, vector<uint64_t>(shape.rows, 0) };
+	for (int r = 0; r < shape.rows; ++r)
+	{
+		for (int c = 0; c < shape.cols; ++c)
+		{
+			flipped.bits[r] |= ((shape.bits[r] >> c) & 1u) << (shape.cols - 1 - c);
+		}
+	}
+	return flipped;
+}
+
+// Returns the shape with rows and columns swapped. Shapes taller than 64 rows cannot be transposed and are returned as they are.
+CensusShape transposeShape(const CensusShape& shape)
+{
+	if (shape.rows > 64)
+	{
+		return shape;
+	}
+	CensusShape turned = { shape.cols, shape.rows, vector<uint64_t>(shape.cols, 0) };
+	for (int r = 0; r < shape.rows; ++r)
+	{
+		for (int c = 0; c < shape.cols; ++c)
+		{
+			turned.bits[c] |= ((shape.bits[r] >> c) & 1u) << r;
+		}
+	}
+	return turned;
+}
+
+// Returns the smallest of a shape's rotations and reflections, so every orientation of an object gives the same shape.
+CensusShape canonicalShape(const CensusShape& shape)
+{
+	CensusShape best = shape;
+	CensusShape flipped = flipShapeRows(shape);
+	CensusShape images[7] = { flipped, flipShapeCols(shape), flipShapeCols(flipped), transposeShape(shape), transposeShape(flipped),
+		transposeShape(flipShapeCols(shape)), transposeShape(flipShapeCols(flipped)) };
+	for (const CensusShape& image : images)
+	{
+		best = min(best, image);
+	}
+	return best;
+}
+
+// Writes a shape as rows x cols followed by the hex value of each row, e.g. 2x2:3.3 for a block.
+string shapeCode(const CensusShape& shape)
+{
+	stringstream code;
+	code << shape.rows << "x" << shape.cols << ":" << hex;
+	for (int r = 0; r < shape.rows; ++r)
+	{
+		code << (r > 0 ? "." : "") << shape.bits[r];
+	}
+	return code.str();
+}
+
+// Returns the live cells of packed cells trimmed to their bounding box. Returns a shape with no rows if every cell is dead or it is wider than 64 columns.
+CensusShape trimShape(const vector<uint64_t>& cells, int rows, int words)
+{
+	int top = rows;
+	int bottom = -1;
+	int left = words * 64;
+	int right = -1;
+	for (int x = 0; x < rows; ++x)
+	{
+		for (int word = 0; word < words; ++word)
+		{
+			uint64_t bitsHere = cells[static_cast<size_t>(x) * words + word];
+			for (int bit = 0; bitsHere && bit < 64; ++bit)
+			{
+				if ((bitsHere >> bit) & 1u)
+				{
+					top = min(top, x);
+					bottom = max(bottom, x);
+					left = min(left, word * 64 + bit);
+					right = max(right, word * 64 + bit);
+				}
+			}
+		}
+	}
+	CensusShape shape = { 0, 0, {} };
+	if (bottom < 0 || right - left >= 64)
+	{
+		return shape;
+	}
+	shape.rows = bottom - top + 1;
+	shape.cols = right - left + 1;
+	shape.bits.assign(shape.rows, 0);
+	for (int x = top; x <= bottom; ++x)
+	{
+		for (int y = left; y <= right; ++y)
+		{
+			shape.bits[x - top] |= ((cells[static_cast<size_t>(x) * words + y / 64] >> (y % 64)) & 1u) << (y - left);
+		}
+	}
+	return shape;
+}
+
+// Runs a shape on its own with a margin of dead cells around it. Returns its period, or 0 if it does not come back to the same cells
+// within MAX_OBJECT_PERIOD generations or reaches the edge of the margin. The canonical shape of every phase is added to phases.
+template <typename RuleT>
+int objectPeriod(const CensusShape& shape, RuleT rule, vector<CensusShape>& phases)
+{
+	int rows = shape.rows + 2 * OBJECT_MARGIN;
+	int cols = shape.cols + 2 * OBJECT_MARGIN;
+	int words = (cols + 63) / 64;
+	uint64_t lastMask = cols % 64 == 0 ? ~uint64_t(0) : (uint64_t(1) << (cols % 64)) - 1;
+	vector<uint64_t> start(static_cast<size_t>(rows) * words, 0);
+	for (int r = 0; r < shape.rows; ++r)
+	{
+		for (int c = 0; c < shape.cols; ++c)
+		{
+			int y = c + OBJECT_MARGIN;
+			start[static_cast<size_t>(r + OBJECT_MARGIN) * words + y / 64] |= ((shape.bits[r] >> c) & 1u) << (y % 64);
+		}
+	}
+
+	vector<uint64_t> cells = start;
+	vector<uint64_t> next;
+	phases.push_back(canonicalShape(shape));
+	for (int generation = 1; generation <= MAX_OBJECT_PERIOD; ++generation)
+	{
+		stepPackedCells(cells, next, rows, words, lastMask, rule);
+		cells.swap(next);
+		if (cells == start)
+		{
+			return generation;
+		}
+
+		// Cells on the outer ring mean the object is growing or moving away
+		bool escaped = false;
+		for (int word = 0; word < words && !escaped; ++word)
+		{
+			escaped = cells[word] != 0 || cells[static_cast<size_t>(rows - 1) * words + word] != 0;
+		}
+		for (int x = 0; x < rows && !escaped; ++x)
+		{
+			escaped = (cells[static_cast<size_t>(x) * words] & 1u) != 0 || ((cells[static_cast<size_t>(x) * words + (cols - 1) / 64] >> ((cols - 1) % 64)) & 1u) != 0;
+		}
+		CensusShape phase = trimShape(cells, rows, words);
+		if (escaped || phase.rows == 0)
+		{
+			return 0;
+		}
+		phases.push_back(canonicalShape(phase));
+	}
+	return 0;
+}
+
+// Returns the census name of an object: its period and the smallest of its canonical phases, e.g. p1:2x2:3.3 for a block.
+// Objects that do not repeat on their own are named by the shape they were found in, after "unstable:".
+template <typename RuleT>
+string objectKey(const CensusShape& shape, RuleT rule)
+{
+	vector<CensusShape> phases;
+	int period = objectPeriod(shape, rule, phases);
+	if (period == 0)
+	{
+		return "unstable:" + shapeCode(canonicalShape(shape));
+	}
+	return "p" + to_string(period) + ":" + shapeCode(*min_element(phases.begin(), phases.end()));
+}
+
+// Returns the common name of an object's census key, or the key itself if it has none. Names are worked out once per rule.
+string objectName(const string& key, const RuleSpec& rule)
+{
+	static mutex namesMutex;
+	static map<pair<unsigned int, unsigned int>, map<string, string>> namesByRule;
+
+	lock_guard<mutex> lock(namesMutex);
+	auto ruleKey = make_pair(rule.getBirth(), rule.getSurvival());
+	auto found = namesByRule.find(ruleKey);
+	if (found == namesByRule.end())
+	{
+		vector<pair<string, vector<vector<bool>>>> known = {
+			{ "Block", { { true, true }, { true, true } } },
+			{ "Beehive", { { false, true, true, false }, { true, false, false, true }, { false, true, true, false } } },
+			{ "Loaf", { { false, true, true, false }, { true, false, false, true }, { false, true, false, true }, { false, false, true, false } } },
+			{ "Boat", { { true, true, false }, { true, false, true }, { false, true, false } } },
+			{ "Ship", { { true, true, false }, { true, false, true }, { false, true, true } } },
+			{ "Tub", { { false, true, false }, { true, false, true }, { false, true, false } } },
+			{ "Pond", { { false, true, true, false }, { true, false, false, true }, { true, false, false, true }, { false, true, true, false } } },
+			{ "Blinker", { { true, true, true } } },
+			{ "Toad", { { false, true, true, true }, { true, true, true, false } } },
+			{ "Beacon", { { true, true, false, false }, { true, true, false, false }, { false, false, true, true }, { false, false, true, true } } }
+		};
+		map<string, string> names;
+		dispatchRule(rule, [&](auto compiledRule)
+		{
+			for (const auto& object : known)
+			{
+				CensusShape shape = { static_cast<int>(object.second.size()), static_cast<int>(object.second[0].size()), vector<uint64_t>(object.second.size(), 0) };
+				for (int r = 0; r < shape.rows; ++r)
+				{
+					for (int c = 0; c < shape.cols; ++c)
+					{
+						shape.bits[r] |= uint64_t(object.second[r][c]) << c;
+					}
+				}
+				names.emplace(objectKey(shape, compiledRule), object.first);
+			}
+		});
+		found = namesByRule.emplace(ruleKey, names).first;
+	}
+	auto name = found->second.find(key);
+	return name == found->second.end() ? key : name->second;
+}
+
+// Splits packed cells into objects and adds the census key of each to keys. Live cells up to two apart are put in the same object,
+// as they share a dead neighbour and can affect each other, so every object can be run on its own and behave as it did in the soup.
+template <typename RuleT>
+void takeCensus(const vector<uint64_t>& cells, int rows, int cols, int words, RuleT rule, vector<string>& keys)
+{
+	vector<unsigned char> visited(static_cast<size_t>(rows) * cols, 0);
+	vector<pair<int, int>> stack;
+	vector<pair<int, int>> objectCells;
+	auto alive = [&](int x, int y) { return ((cells[static_cast<size_t>(x) * words + y / 64] >> (y % 64)) & 1u) != 0; };
+
+	for (int x = 0; x < rows; ++x)
+	{
+		for (int y = 0; y < cols; ++y)
+		{
+			if (!alive(x, y) || visited[static_cast<size_t>(x) * cols + y])
+			{
+				continue;
+			}
+
+			// Flood fill the object
+			objectCells.clear();
+			stack.assign(1, make_pair(x, y));
+			visited[static_cast<size_t>(x) * cols + y] = 1;
+			int top = x, bottom = x, left = y, right = y;
+			while (!stack.empty())
+			{
+				pair<int, int> cell = stack.back();
+				stack.pop_back();
+				objectCells.push_back(cell);
+				top = min(top, cell.first);
+				bottom = max(bottom, cell.first);
+				left = min(left, cell.second);
+				right = max(right, cell.second);
+				for (int dx = -2; dx <= 2; ++dx)
+				{
+					for (int dy = -2; dy <= 2; ++dy)
+					{
+						int nx = cell.first + dx;
+						int ny = cell.second + dy;
+						if (nx >= 0 && nx < rows && ny >= 0 && ny < cols && !visited[static_cast<size_t>(nx) * cols + ny] && alive(nx, ny))
+						{
+							visited[static_cast<size_t>(nx) * cols + ny] = 1;
+							stack.push_back(make_pair(nx, ny));
+						}
+					}
+				}
+			}
+
+			if (right - left >= 64)
+			{
+				keys.push_back("oversized");
+				continue;
+			}
+			CensusShape shape = { bottom - top + 1, right - left + 1, vector<uint64_t>(bottom - top + 1, 0) };
+			for (const auto& cell : objectCells)
+			{
+				shape.bits[cell.first - top] |= uint64_t(1) << (cell.second - left);
+			}
+			keys.push_back(objectKey(shape, rule));
+		}
+	}
+}
+
+// Fills packed cells with a random soup of numCells live cells. Each index gives a different soup, chosen the same way as scatterCells.
+void fillSoup(vector<uint64_t>& cells, int rows, int cols, int words, int numCells, uint64_t key)
+{
+	cells.assign(static_cast<size_t>(rows) * words, 0);
+	uint64_t liveCells = min(uint64_t(rows) * cols, uint64_t(max(0, numCells)));
+	IndexPermutation shuffle(uint64_t(rows) * cols, key);
+	for (int x = 0; x < rows; ++x)
+	{
+		for (int y = 0; y < cols; ++y)
+		{
+			if (shuffle.permute(uint64_t(x) * cols + y) < liveCells)
+			{
+				cells[static_cast<size_t>(x) * words + y / 64] |= uint64_t(1) << (y % 64);
+			}
+		}
+	}
+}
+
+// Counts of every object found by a soup search, with the settings the soups were made with. Soup i is always the same soup for the same seed,
+// so a search saved after n soups can carry on from soup n.
+class SoupCensus
+{
+
+	private:
+		int rows;
+		int cols;
+		int cells;
+		unsigned int seed;
+		RuleSpec rule;
+		uint64_t soups;
+		map<string, uint64_t> counts;
+	public:
+		SoupCensus() : rows(0), cols(0), cells(0), seed(0), soups(0) {}
+
+		SoupCensus(int rows, int cols, int cells, unsigned int seed, const RuleSpec& rule)
+			: rows(rows), cols(cols), cells(cells), seed(seed), rule(rule), soups(0) {}
+
+		// Get functions
+		int getRows() const { return rows; }
+		int getCols() const { return cols; }
+		int getCells() const { return cells; }
+		unsigned int getSeed() const { return seed; }
+		const RuleSpec& getRule() const { return rule; }
+		uint64_t getSoups() const { return soups; }
+		const map<string, uint64_t>& getCounts() const { return counts; }
+
+		// Returns the key that makes soup number index.
+		uint64_t soupKey(uint64_t index) const { return mixBits((uint64_t(seed) << 32) ^ index); }
+
+		// Set functions
+		void setSoups(uint64_t newSoups) { soups = newSoups; }
+		void add(const string& object, uint64_t count = 1) { counts[object] += count; }
+
+		// Returns the objects ordered from most to least common.
+		vector<pair<string, uint64_t>> sortedCounts() const
+		{
+			vector<pair<string, uint64_t>> sorted(counts.begin(), counts.end());
+			stable_sort(sorted.begin(), sorted.end(), [](const pair<string, uint64_t>& a, const pair<string, uint64_t>& b) { return a.second > b.second; });
+			return sorted;
+		}
+};
+
+// Runs one soup of a census to stabilisation and adds the key of every object left to keys. Soups that never settle add "unsettled".
+template <typename RuleT>
+void runCensusSoup(const SoupCensus& census, uint64_t index, RuleT rule, vector<string>& keys)
+{
+	int rows = census.getRows();
+	int cols = census.getCols();
+	int words = (cols + 63) / 64;
+	uint64_t lastMask = cols % 64 == 0 ? ~uint64_t(0) : (uint64_t(1) << (cols % 64)) - 1;
+	static thread_local vector<uint64_t> cells;
+	fillSoup(cells, rows, cols, words, census.getCells(), census.soupKey(index));
+	if (settleCells(cells, rows, words, lastMask, rule) == 0)
+	{
+		keys.push_back("unsettled");
+		return;
+	}
+	takeCensus(cells, rows, cols, words, rule, keys);
+}
+
+// Runs soups across every core until the census holds totalSoups. checkpoint is called after each batch, so if it saves the census
+// an interrupted search loses at most one batch. Stops and returns false if checkpoint does.
+bool runSoupCensus(SoupCensus& census, uint64_t totalSoups, const function<bool(const SoupCensus&)>& checkpoint, bool showProgress = true)
+{
+	bool saved = true;
+	dispatchRule(census.getRule(), [&](auto compiledRule)
+	{
+		mutex countsMutex;
+		while (census.getSoups() < totalSoups && saved)
+		{
+			uint64_t first = census.getSoups();
+			int batch = static_cast<int>(min<uint64_t>(CENSUS_BATCH, totalSoups - first));
+			getScheduler().parallelFor(batch, [&](int i)
+			{
+				vector<string> keys;
+				runCensusSoup(census, first + i, compiledRule, keys);
+				lock_guard<mutex> lock(countsMutex);
+				for (const string& key : keys)
+				{
+					census.add(key);
+				}
+			});
+			census.setSoups(first + batch);
+			saved = checkpoint(census);
+			if (showProgress)
+			{
+				cout << endl << "Ran " << census.getSoups() << " of " << totalSoups << " soups";
+			}
+		}
+	});
+	return saved;
+}
+
+// Displays the most common objects of a census with how often each was found.
+void displayCensus(const SoupCensus& census, size_t maxObjects)
+{
+	vector<pair<string, uint64_t>> sorted = census.sortedCounts();
+	uint64_t totalObjects = 0;
+	for (const auto& entry : sorted)
+	{
+		totalObjects += entry.second;
+	}
+	cout << endl << census.getSoups() << " soups of " << census.getCells() << " cells in a " << census.getRows() << "x" << census.getCols()
+		<< " grid with " << census.getRule().toString() << " left " << totalObjects << " objects:";
+	for (size_t i = 0; i < sorted.size() && i < maxObjects; ++i)
+	{
+		cout << endl << "|| " << objectName(sorted[i].first, census.getRule()) << ": " << sorted[i].second
+			<< " (" << 100.0 * sorted[i].second / max<uint64_t>(1, totalObjects) << "%)";
+	}
+}
+
+// PARAMETER SWEEP
+
+// One range of a sweep, from first to last in steps of step.
+struct SweepRange
+{
+	int first;
+	int last;
+	int step;
+};
+
+// One run of a sweep. seed numbers the soups of the same size and cell count from 0, so the same point is always the same soup.
+struct SweepPoint
+{
+	int rows;
+	int cols;
+	int cells;
+	int seed;
+
+	bool operator<(const SweepPoint& other) const
+	{
+		return tie(rows, cols, cells, seed) < tie(other.rows, other.cols, other.cells, other.seed);
+	}
+};
+
+// What one run of a sweep found. generations is how long the soup took to settle into its final cycle of period generations, or -1 if it never did.
+// population is the number of live cells when the cycle starts.
+struct SweepResult
+{
+	SweepPoint point;
+	int generations;
+	int period;
+	bool targetFound;
+	int population;
+};
+
+// Returns every point of a sweep, skipping those with more cells than the grid has spaces.
+vector<SweepPoint> sweepPoints(const SweepRange& rows, const SweepRange& cols, const SweepRange& cells, int seeds)
+{
+	vector<SweepPoint> points;
+	for (int x = rows.first; x <= rows.last; x += rows.step)
+	{
+		for (int y = cols.first; y <= cols.last; y += cols.step)
+		{
+			for (int numCells = cells.first; numCells <= cells.last && numCells <= x * y; numCells += cells.step)
+			{
+				for (int seed = 0; seed < seeds; ++seed)
+				{
+					points.push_back(SweepPoint{ x, y, numCells, seed });
+				}
+			}
+		}
+	}
+	return points;
+}
+
+// Returns whether any variant of the patterns is in packed cells, matching 64 positions of a variant at a time.
+bool packedContains(const vector<uint64_t>& cells, int rows, int cols, int words, const PatternSet& patterns)
+{
+	for (int x = 0; x < rows; ++x)
+	{
+		for (int word = 0; word < words; ++word)
+		{
+			for (const PatternMask& mask : patterns.getMasks())
+			{
+				if (x + mask.rows > rows)
+				{
+					continue;
+				}
+				uint64_t candidates = columnRangeMask(word * 64, 0, cols - mask.cols + 1);
+				if (candidates && matchMaskWord(mask, &cells[static_cast<size_t>(x) * words], words, word, candidates))
+				{
+					return true;
+				}
+			}
+		}
+	}
+	return false;
+}
+
+// Runs the soup of one sweep point until it settles. Brent's method finds the period, then a second pass from the soup with one copy a period
+// ahead finds the generation the cycle starts. Spaceships only live until they reach the edge, so with moving targets every generation is scanned;
+// other targets stay once the soup settles and only its final cycle is scanned.
+template <typename RuleT>
+SweepResult runSweepPoint(const SweepPoint& point, const PatternSet& target, bool targetMoves, RuleT rule)
+{
+	int words = (point.cols + 63) / 64;
+	uint64_t lastMask = point.cols % 64 == 0 ? ~uint64_t(0) : (uint64_t(1) << (point.cols % 64)) - 1;
+	static thread_local vector<uint64_t> start;
+	static thread_local vector<uint64_t> cells;
+	static thread_local vector<uint64_t> saved;
+	static thread_local vector<uint64_t> ahead;
+	static thread_local vector<uint64_t> next;
+	uint64_t key = mixBits(mixBits((uint64_t(point.rows) << 32) | uint32_t(point.cols)) ^ ((uint64_t(point.cells) << 32) | uint32_t(point.seed)));
+	fillSoup(start, point.rows, point.cols, words, point.cells, key);
+
+	SweepResult result = { point, -1, 0, false, 0 };
+	cells = start;
+	saved = start;
+	result.targetFound = targetMoves && packedContains(cells, point.rows, point.cols, words, target);
+	int power = 1;
+	int sinceSaved = 0;
+	for (int generation = 1; generation <= MAX_CENSUS_GENERATIONS && result.period == 0; ++generation)
+	{
+		stepPackedCells(cells, next, point.rows, words, lastMask, rule);
+		cells.swap(next);
+		++sinceSaved;
+		if (targetMoves && !result.targetFound)
+		{
+			result.targetFound = packedContains(cells, point.rows, point.cols, words, target);
+		}
+		if (cells == saved)
+		{
+			result.period = sinceSaved;
+		}
+		else if (sinceSaved == power)
+		{
+			saved = cells;
+			power *= 2;
+			sinceSaved = 0;
+		}
+	}
+	if (result.period == 0)
+	{
+		return result;
+	}
+
+	// The cycle starts at the first generation that matches the one a period later
+	cells = start;
+	ahead = start;
+	for (int generation = 0; generation < result.period; ++generation)
+	{
+		stepPackedCells(ahead, next, point.rows, words, lastMask, rule);
+		ahead.swap(next);
+	}
+	result.generations = 0;
+	while (cells != ahead)
+	{
+		stepPackedCells(cells, next, point.rows, words, lastMask, rule);
+		cells.swap(next);
+		stepPackedCells(ahead, next, point.rows, words, lastMask, rule);
+		ahead.swap(next);
+		result.generations++;
+	}
+
+	for (uint64_t word : cells)
+	{
+		result.population += countBits(word);
+	}
+	for (int generation = 0; generation < result.period && !targetMoves && !result.targetFound; ++generation)
+	{
+		result.targetFound = packedContains(cells, point.rows, point.cols, words, target);
+		stepPackedCells(cells, next, point.rows, words, lastMask, rule);
+		cells.swap(next);
+	}
+	return result;
+}
+
+// Runs every point across every core. record is called once for each result as soon as it is ready, never from two threads at once,
+// so a caller can stream results to a file and lose at most the runs still going if it is stopped.
+void runSweep(const vector<SweepPoint>& points, const PatternSet& target, bool targetMoves, const RuleSpec& rule, const function<void(const SweepResult&)>& record)
+{
+	mutex recordMutex;
+	dispatchRule(rule, [&](auto compiledRule)
+	{
+		getScheduler().parallelFor(static_cast<int>(points.size()), [&](int i)
+		{
+			SweepResult result = runSweepPoint(points[i], target, targetMoves, compiledRule);
+			lock_guard<mutex> lock(recordMutex);
+			record(result);
+		});
+	});
+}
+
+// SAVE FUNCTIONS
+
+// Saves the Grid onto the system storage. Creates a .txt file with user defined filename
+template <typename T>
+void saveSimulation(GridView<T> grid)
+{
+	// Saves the simulation to the drive.
+	string filename;
+	cout << endl << "Enter file name: ";
+	cin >> filename;
+	ofstream gridSaveFile(filename + ".txt");
+	if (gridSaveFile.is_open())
+	{
+		// save the grid from main grid into txt file
+		gridSaveFile << grid;
+	}
+	gridSaveFile.close();
+}
+
+// Saves the Grid as a binary snapshot. Creates a .snap file with user defined filename that the out-of-core engine can advance on disk.
+template <typename T>
+void saveSnapshot(GridView<T> grid, const RuleSpec& rule)
+{
+	string filename;
+	cout << endl << "Enter file name: ";
+	cin >> filename;
+
+	if (!writeSnapshotFile(filename + ".snap", grid, 0, rule))
+	{
+		cout << endl << "Error: Unable to create the file.";
+	}
+}
+
+// Saves the checksum of each generation of a run. Creates a _checksums.csv file next to the parameters with one generation and checksum per line
+void saveReplayLog(const string& filename, const ReplayLog& log)
+{
+	ofstream logSaveFile(filename + "_checksums.csv");
+	if (logSaveFile.is_open())
+	{
+		for (const auto& entry : log.getChecksums())
+		{
+			logSaveFile << entry.first << "," << hex << entry.second << dec << endl;
+		}
+	}
+	logSaveFile.close();
+}
+
+// Saves a soup census. Creates a _census.csv file holding the search settings and the number of soups run, then one object and count per line.
+// The file is written under a temporary name and then renamed, so an interruption never leaves half a census.
+bool saveCensus(const string& filename, const SoupCensus& census)
+{
+	string censusFilename = filename + "_census.csv";
+	string tempFilename = censusFilename + ".tmp";
+	ofstream censusSaveFile(tempFilename);
+	if (!censusSaveFile.is_open())
+	{
+		cout << endl << "Error: Unable to save the census.";
+		return false;
+	}
+	censusSaveFile << census.getRows() << "," << census.getCols() << "," << census.getCells() << "," << census.getSeed() << ","
+		<< census.getRule().toString() << "," << census.getSoups() << endl;
+	for (const auto& entry : census.sortedCounts())
+	{
+		censusSaveFile << entry.first << "," << entry.second << endl;
+	}
+	censusSaveFile.close();
+
+	remove(censusFilename.c_str());
+	if (censusSaveFile.fail() || rename(tempFilename.c_str(), censusFilename.c_str()) != 0)
+	{
+		cout << endl << "Error: Unable to save the census.";
+		return false;
+	}
+	return true;
+}
+
+// Writes one sweep result as a line of a _sweep.csv file and flushes it, so every finished run is on disk straight away.
+void appendSweepResult(ofstream& sweepSaveFile, const SweepResult& result)
+{
+	sweepSaveFile << result.point.rows << "," << result.point.cols << "," << result.point.cells << "," << result.point.seed << ","
+		<< result.generations << "," << result.period << "," << result.targetFound << "," << result.population << endl;
+}
+
+// Saves sweep results. Creates a _sweep.csv file holding the rule and target pattern, a line of column names, then one run per line.
+// The file is written under a temporary name and then renamed, so an interruption never leaves half of it.
+bool saveSweepResults(const string& filename, const RuleSpec& rule, int patternChoice, const vector<SweepResult>& results)
+{
+	string sweepFilename = filename + "_sweep.csv";
+	string tempFilename = sweepFilename + ".tmp";
+	ofstream sweepSaveFile(tempFilename);
+	if (!sweepSaveFile.is_open())
+	{
+		cout << endl << "Error: Unable to save the sweep.";
+		return false;
+	}
+	sweepSaveFile << rule.toString() << "," << patternChoice << endl;
+	sweepSaveFile << "rows,cols,cells,seed,generations,period,target,population" << endl;
+	for (const SweepResult& result : results)
+	{
+		appendSweepResult(sweepSaveFile, result);
+	}
+	sweepSaveFile.close();
+
+	remove(sweepFilename.c_str());
+	if (sweepSaveFile.fail() || rename(tempFilename.c_str(), sweepFilename.c_str()) != 0)
+	{
+		cout << endl << "Error: Unable to save the sweep.";
+		return false;
+	}
+	return true;
+}
+
+// Saves the paramaters used to generate a simulation. Creates a .CSV file with user defined filename
+// If a log is given the checksum of each generation is saved next to it so a replay can be checked.
+// The sampler that scattered the cells is saved last, so the seed gives the same grid after the sampler changes.
+template <typename T>
+void saveParameters(GridView<T> grid, unsigned int seed, int totalCycles, int totalCells, const ReplayLog* log = nullptr,
+	int scatterVersion = SCATTER_VERSION)
+{
+	// Saves the parameters to generate the case again
+	string filename;
+	int rows;
+	int cols;
+	cout << endl << "Enter file name: ";
+	cin >> filename;
+	
+	ofstream parametersSaveFile(filename + ".csv");
+	if (parametersSaveFile.is_open())
+	{
+		rows = grid.getRows();
+		parametersSaveFile << rows << ",";
+		cols = grid.getCols();
+		parametersSaveFile << cols << ",";
+		parametersSaveFile << seed << ",";
+		parametersSaveFile << totalCycles << ",";
+		parametersSaveFile << totalCells << ",";
+		parametersSaveFile << "v" << scatterVersion << ",";
+	}
+
+	parametersSaveFile.close();
+
+	if (log && !log->empty())
+	{
+		saveReplayLog(filename, *log);
+	}
+}
+
+// LOAD FUNCTIONS
+
+// Loads a .txt file from the system storage and updates the grid based on the position of the cells inside the text file.
+template <typename T>
+bool loadGridSimulation(Grid<T> &grid) 
+{
+
+	// Loads the simulation from the drive.
+	string loadedRow;
+	string filename;
+
+	cout << endl << "Enter file name to load: ";
+	cin >> filename;
+
+	ifstream gridLoadFile(filename + ".txt");
+
+	if (!gridLoadFile.is_open())
+		{
+			cout << endl << "Error: Unable to open the file.";
+			cin >> ClearAndIgnore();
+			return false;
+		}
+
+	vector<vector<bool>> loadedCells;
+	int cols = 0;
+
+	while (getline(gridLoadFile, loadedRow))
+	{
+			if (loadedRow.find("---") != string::npos)
+			{
+				continue;
+			}
+			vector<bool> newRow;
+
+			for (char cellChar : loadedRow)
+			{
+				if (cellChar == 'O') // If alive cell.
+				{
+					newRow.push_back(true);
+				}
+				else if (cellChar == ' ')
+				{
+					newRow.push_back(false);
+				}
+			}
+			cols = max(cols, static_cast<int>(newRow.size()));
+			loadedCells.push_back(newRow);
+	}
+	gridLoadFile.close();
+
+	if (loadedCells.empty() || cols == 0)
+	{
+		cout << endl << "Error: The file does not contain a grid.";
+		return false;
+	}
+
+	// Copies the loaded layout onto a new grid and replaces the old one.
+	Grid<T> loadedGrid(loadedCells.size(), cols);
+	for (size_t x = 0; x < loadedCells.size(); ++x)
+	{
+		for (size_t y = 0; y < loadedCells[x].size(); ++y)
+		{
+			loadedGrid.setAlive(x, y, loadedCells[x][y]);
+		}
+	}
+	grid.swap(loadedGrid);
+	return true;
+}
+
+// Loads a .snap file into the grid. The rule and generation saved in it are written to the pointers if they are given.
+template <typename T>
+bool loadSnapshot(Grid<T>& grid, RuleSpec* rulePointer = nullptr, uint64_t* generationPointer = nullptr)
+{
+	string filename;
+	cout << endl << "Enter file name to load: ";
+	cin >> filename;
+
+	MappedFile snapshotFile;
+	if (!snapshotFile.open(filename + ".snap") || snapshotFile.getBytes() < sizeof(SnapshotHeader))
+	{
+		cout << endl << "Error: Unable to open the file.";
+		cin >> ClearAndIgnore();
+		return false;
+	}
+	snapshotFile.close();
+	return readSnapshotFile(filename + ".snap", grid, rulePointer, generationPointer);
+}
+
+// Loads a .csv file from the system storage and stores the values into a CSVData class to pass into simulation
+CSVData LoadParamSimulation(string* filenamePointer = nullptr)
+{
+	string filename;
+	string line;
+	ifstream paramLoadFile;
+
+	do {
+
+		cout << endl << "Enter file name to load: ";
+		cin >> filename;
+
+		paramLoadFile.open(filename + ".csv");
+
+		if (!paramLoadFile.is_open())
+		{
+			cout << endl << "Error: Unable to open the file.";
+			cin >> ClearAndIgnore();
+
+		}
+	} while (!paramLoadFile.is_open());
+
+	if (filenamePointer)
+	{
+		*filenamePointer = filename;
+	}
+
+	if (getline(paramLoadFile, line))
+	{
+		stringstream ss(line);
+		string token;
+		int xSpaces;
+		int ySpaces;
+		int totalCells;
+		int totalCycles;
+		unsigned int seed;
+
+		getline(ss, token, ',');
+		xSpaces = stoi(token);
+
+		getline(ss, token, ',');
+		ySpaces = stoi(token);
+
+		getline(ss, token, ',');
+		seed = static_cast<unsigned int>(stoul(token));
+
+		getline(ss, token, ',');
+		totalCycles = stoi(token);
+
+		getline(ss, token, ',');
+		totalCells = stoi(token);
+
+		// Files saved before the sampler version was written were scattered with the legacy sampler
+		int scatterVersion = LEGACY_SCATTER;
+		if (getline(ss, token, ',') && token.size() > 1 && token[0] == 'v')
+		{
+			stringstream versionStream(token.substr(1));
+			if (!(versionStream >> scatterVersion) || (scatterVersion != LEGACY_SCATTER && scatterVersion != SCATTER_VERSION))
+			{
+				scatterVersion = LEGACY_SCATTER;
+			}
+		}
+
+		return CSVData(xSpaces, ySpaces, seed, totalCycles, totalCells, scatterVersion);
+
+	}
+
+
+
+
+}
+
+// Reads a number that fills a whole field of a saved line. Returns false if the field holds anything else.
+template <typename V>
+bool parseField(const string& field, V& value)
+{
+	stringstream ss(field);
+	return (ss >> value) && (ss >> ws).eof();
+}
+
+// Loads a soup census saved by saveCensus. Returns false if there is none or it is damaged.
+bool loadCensus(const string& filename, SoupCensus& census)
+{
+	ifstream censusLoadFile(filename + "_census.csv");
+	if (!censusLoadFile.is_open())
+	{
+		return false;
+	}
+
+	string line;
+	string token;
+	if (!getline(censusLoadFile, line))
+	{
+		cout << endl << "Error: Census file is damaged.";
+		return false;
+	}
+	stringstream ss(line);
+	vector<string> fields;
+	while (getline(ss, token, ','))
+	{
+		fields.push_back(token);
+	}
+	RuleSpec rule;
+	int rows;
+	int cols;
+	int cells;
+	unsigned int seed;
+	uint64_t soups;
+	if (fields.size() != 6 || !parseField(fields[0], rows) || !parseField(fields[1], cols) || !parseField(fields[2], cells) || !parseField(fields[3], seed)
+		|| !parseRule(fields[4], rule) || !parseField(fields[5], soups))
+	{
+		cout << endl << "Error: Census file is damaged.";
+		return false;
+	}
+	SoupCensus loaded(rows, cols, cells, seed, rule);
+	loaded.setSoups(soups);
+
+	while (getline(censusLoadFile, line))
+	{
+		size_t comma = line.rfind(',');
+		if (comma == string::npos)
+		{
+			continue;
+		}
+		uint64_t count;
+		if (!parseField(line.substr(comma + 1), count))
+		{
+			cout << endl << "Error: Census file is damaged.";
+			return false;
+		}
+		loaded.add(line.substr(0, comma), count);
+	}
+	census = loaded;
+	return true;
+}
+
+// Loads the results of a sweep saved by saveSweepResults and appendSweepResult. A last line cut short by an interruption is left out,
+// so its run is done again. Returns false if there is no sweep or it is damaged.
+bool loadSweepResults(const string& filename, RuleSpec& rule, int& patternChoice, vector<SweepResult>& results)
+{
+	ifstream sweepLoadFile(filename + "_sweep.csv");
+	if (!sweepLoadFile.is_open())
+	{
+		return false;
+	}
+
+	string line;
+	string columns;
+	size_t comma;
+	if (!getline(sweepLoadFile, line) || !getline(sweepLoadFile, columns) || (comma = line.rfind(',')) == string::npos || !parseRule(line.substr(0, comma), rule)
+		|| !parseField(line.substr(comma + 1), patternChoice))
+	{
+		cout << endl << "Error: Sweep file is damaged.";
+		return false;
+	}
+
+	results.clear();
+	while (getline(sweepLoadFile, line) && !sweepLoadFile.eof())
+	{
+		stringstream ss(line);
+		string token;
+		vector<int> fields;
+		while (getline(ss, token, ','))
+		{
+			int field;
+			if (!parseField(token, field))
+			{
+				cout << endl << "Error: Sweep file is damaged.";
+				return false;
+			}
+			fields.push_back(field);
+		}
+		if (fields.size() == 8)
+		{
+			results.push_back(SweepResult{ SweepPoint{ fields[0], fields[1], fields[2], fields[3] }, fields[4], fields[5], fields[6] != 0, fields[7] });
+		}
+	}
+	return true;
+}
+
+// Loads the checksums saved next to a .csv file. Returns false if the run was saved without them.
+bool loadReplayLog(const string& filename, ReplayLog& log)
+{
+	ifstream logLoadFile(filename + "_checksums.csv");
+	if (!logLoadFile.is_open())
+	{
+		return false;
+	}
+
+	log.clear();
+	string line;
+	while (getline(logLoadFile, line))
+	{
+		stringstream ss(line);
+		string token;
+		int generation;
+		uint64_t checksum;
+
+		if (!getline(ss, token, ','))
+		{
+			continue;
+		}
+		generation = stoi(token);
+		if (!(ss >> hex >> checksum))
+		{
+			cout << endl << "Error: Checksum file is damaged.";
+			return false;
+		}
+		log.record(generation, checksum);
+	}
+	return true;
+}
+
+// TEST FUNCTIONS
+
+template <typename T>
+// test to ensure isBlockOrBeehive functions as intended. Outputs to console if successful.
+void test_isBlockOrBeehive(Grid<T>& grid)
+{
+	// Test empty
+
+	bool foundNothing = isBlockOrBeehive(grid);
+	assert(foundNothing == false);
+
+
+	// Test Block
+	grid.setAlive(1, 1, true);
+	grid.setAlive(2, 1, true);
+	grid.setAlive(1, 2, true);
+	grid.setAlive(2, 2, true);
+
+	bool foundBlock = isBlockOrBeehive(grid);
+	assert(foundBlock == true);
+
+	grid.setAlive(1, 1, false);
+	grid.setAlive(2, 1, false);
+	grid.setAlive(1, 2, false);
+	grid.setAlive(2, 2, false);
+
+	// Test Beehive
+	grid.setAlive(2, 0, true);
+	grid.setAlive(1, 1, true);
+	grid.setAlive(3, 1, true);
+	grid.setAlive(1, 2, true);
+	grid.setAlive(3, 2, true);
+	grid.setAlive(2, 3, true);
+
+	bool foundBeehive = isBlockOrBeehive(grid);
+	assert(foundBeehive == true);
+
+	grid.setAlive(2, 0, false);
+	grid.setAlive(1, 1, false);
+	grid.setAlive(3, 1, false);
+	grid.setAlive(1, 2, false);
+	grid.setAlive(3, 2, false);
+	grid.setAlive(2, 3, false);
+
+	cout << endl << "All tests passed for isBlockOrBeehive()";
+
+}
+
+// test to ensure isBlinkerOrToad functions as intended. Outputs to console if successful (toads were rare >:| )
+template <typename T>
+void test_isBlinkerOrToad(Grid<T>& grid)
+{
+	// Test empty
+
+	bool foundNothing = isBlinkerOrToad(grid);
+	assert(foundNothing == false);
 
+	// Test Blinker
+	grid.setAlive(1, 1, true);
+	grid.setAlive(1, 2, true);
+	grid.setAlive(1, 3, true);
 
-			}
+	bool foundBlinker = isBlinkerOrToad(grid);
+	assert(foundBlinker == true);
 
-			if (patternFound)
+	grid.setAlive(1, 1, false);
+	grid.setAlive(1, 2, false);
+	grid.setAlive(1, 3, false);
+
+	// Test Toad
+
+	grid.setAlive(0, 1, true);
+	grid.setAlive(0, 2, true);
+	grid.setAlive(1, 3, true);
+	grid.setAlive(2, 0, true);
+	grid.setAlive(3, 1, true);
+	grid.setAlive(3, 2, true);
+
+	bool foundToad = isBlinkerOrToad(grid);
+	assert(foundToad == true);
+
+	grid.setAlive(0, 1, false);
+	grid.setAlive(0, 2, false);
+	grid.setAlive(1, 3, false);
+	grid.setAlive(2, 0, false);
+	grid.setAlive(3, 1, false);
+	grid.setAlive(3, 2, false);
+
+	cout << endl << "All tests passed for isBlinkerOrToad()";
+
+}
+
+// test to ensure isGliderOrLWSS functions as intended. Outputs to console if successful (LWSS impossiblely rare >>:( )
+template <typename T>
+void test_isGliderOrLWSS(Grid<T>& grid)
+{
+	// Test empty
+
+	bool foundNothing = isGliderOrLWSS(grid);
+	assert(foundNothing == false);
+
+
+	// Test Glider
+	grid.setAlive(2, 1, true);
+	grid.setAlive(3, 2, true);
+	grid.setAlive(1, 3, true);
+	grid.setAlive(2, 3, true);
+	grid.setAlive(3, 3, true);
+
+	bool foundGlider = isGliderOrLWSS(grid);
+	assert(foundGlider == true);
+
+	grid.setAlive(2, 1, false);
+	grid.setAlive(3, 2, false);
+	grid.setAlive(1, 3, false);
+	grid.setAlive(2, 3, false);
+	grid.setAlive(3, 3, false);
+
+	// Test LWSS
+
+	grid.setAlive(1, 0, true);
+	grid.setAlive(4, 0, true);
+	grid.setAlive(0, 1, true);
+	grid.setAlive(0, 2, true);
+	grid.setAlive(4, 2, true);
+	grid.setAlive(0, 3, true);
+	grid.setAlive(1, 3, true);
+	grid.setAlive(2, 3, true);
+	grid.setAlive(3, 3, true);
+
+	bool foundLWSS = isGliderOrLWSS(grid);
+	assert(foundLWSS == true);
+
+	grid.setAlive(1, 0, false);
+	grid.setAlive(4, 0, false);
+	grid.setAlive(0, 1, false);
+	grid.setAlive(0, 2, false);
+	grid.setAlive(4, 2, false);
+	grid.setAlive(0, 3, false);
+	grid.setAlive(1, 3, false);
+	grid.setAlive(2, 3, false);
+	grid.setAlive(3, 3, false);
+
+	// Test Rotated LWSS
+	grid.setAlive(0, 0, true);
+	grid.setAlive(1, 0, true);
+	grid.setAlive(2, 0, true);
+	grid.setAlive(0, 1, true);
+	grid.setAlive(3, 1, true);
+	grid.setAlive(0, 2, true);
+	grid.setAlive(0, 3, true);
+	grid.setAlive(1, 4, true);
+	grid.setAlive(3, 4, true);
+
+	bool foundRotatedLWSS = isGliderOrLWSS(grid);
+	assert(foundRotatedLWSS == true);
+
+	grid.setAlive(0, 0, false);
+	grid.setAlive(1, 0, false);
+	grid.setAlive(2, 0, false);
+	grid.setAlive(0, 1, false);
+	grid.setAlive(3, 1, false);
+	grid.setAlive(0, 2, false);
+	grid.setAlive(0, 3, false);
+	grid.setAlive(1, 4, false);
+	grid.setAlive(3, 4, false);
+
+	cout << endl << "All tests passed for isGliderOrLWSS()";
+}
+
+// test to ensure the rule engine matches B/S notation and the compiled kernels agree with the runtime rule. Outputs to console if successful.
+template <typename T>
+void test_rules(Grid<T>& grid)
+{
+	// Test parsing
+	RuleSpec rule;
+	assert(parseRule("B36/S23", rule) == true);
+	assert(isRule<HighLifeRule>(rule));
+	assert(rule.toString() == "B36/S23");
+	assert(parseRule("B2/S", rule) == true);
+	assert(isRule<SeedsRule>(rule));
+	assert(parseRule("B9/S23", rule) == false);
+	assert(parseRule("23/3", rule) == false);
+
+	// Test compiled rules give the same answers as their runtime equivalent
+	DynamicRule dynamicConway = { ConwayRule::birth, ConwayRule::survival };
+	for (int n = 0; n <= 8; ++n)
+	{
+		assert(ConwayRule().nextState(true, n) == dynamicConway.nextState(true, n));
+		assert(ConwayRule().nextState(false, n) == dynamicConway.nextState(false, n));
+	}
+
+	// Test Blinker turns vertical under B3/S23
+	grid.setAlive(2, 1, true);
+	grid.setAlive(2, 2, true);
+	grid.setAlive(2, 3, true);
+
+	UpdateCells(grid, RuleSpec());
+	assert(grid.isAlive(1, 2) && grid.isAlive(2, 2) && grid.isAlive(3, 2));
+	assert(!grid.isAlive(2, 1) && !grid.isAlive(2, 3));
+
+	// Test Seeds (B2/S): every live cell dies and the four diagonal cells with two neighbours are born
+	UpdateCells(grid, RuleSpec(SeedsRule::birth, SeedsRule::survival));
+	assert(!grid.isAlive(1, 2) && !grid.isAlive(2, 2) && !grid.isAlive(3, 2));
+	assert(grid.isAlive(1, 1) && grid.isAlive(1, 3) && grid.isAlive(3, 1) && grid.isAlive(3, 3));
+	assert(!grid.isAlive(2, 1) && !grid.isAlive(2, 3));
+
+	createCells(grid);
+
+	cout << endl << "All tests passed for rules";
+}
+
+// test to ensure custom cell types step through the same kernels and keep their own state. Outputs to console if successful.
+void test_cellPolicies()
+{
+	Grid<unsigned char, AgingCell<unsigned char>> agingGrid(5, 5);
+
+	// Test Block keeps surviving and its cells age each generation
+	agingGrid.setAlive(1, 1, true);
+	agingGrid.setAlive(1, 2, true);
+	agingGrid.setAlive(2, 1, true);
+	agingGrid.setAlive(2, 2, true);
+	assert(agingGrid.getIcon(1, 1) == 'o');
+
+	UpdateCells(agingGrid, RuleSpec());
+	UpdateCells(agingGrid, RuleSpec());
+	assert(agingGrid.getState(1, 1) == 3);
+	assert(agingGrid.getIcon(2, 2) == 'O');
+	assert(!agingGrid.isAlive(0, 0) && agingGrid.getIcon(0, 0) == ' ');
+	assert(checkForDeadCells(agingGrid) == false);
+
+	cout << endl << "All tests passed for cell policies";
+}
+
+// test to ensure the scheduler runs every tile exactly once and tiled stepping matches a single pass over the grid. Outputs to console if successful.
+void test_scheduler()
+{
+	// Test every tile runs once, including tiles that start more work
+	vector<atomic<int>> visits(5000);
+	getScheduler().parallelFor(visits.size(), [&](int tile)
+	{
+		visits[tile]++;
+		if (tile % 1000 == 0)
+		{
+			getScheduler().parallelFor(4, [&](int) { visits[tile + 1]++; });
+		}
+	});
+	for (size_t i = 0; i < visits.size(); ++i)
+	{
+		assert(visits[i] == ((i % 1000 == 1) ? 5 : 1));
+	}
+
+	// Test a grid that is smaller than the core count and one that spans many tiles
+	int sizes[2][2] = { { 3, 7 }, { 70, 1100 } };
+	for (auto& size : sizes)
+	{
+		Grid<bool> tiledGrid(size[0], size[1]);
+		unsigned int seed = 1234;
+		scatterCells(tiledGrid, size[0] * size[1] / 3, seed);
+
+		Grid<bool> expected(size[0], size[1]);
+		updateCellsSegment(tiledGrid, expected, 0, size[0], 0, size[1], ConwayRule());
+		UpdateCells(tiledGrid, RuleSpec());
+
+		for (int x = 0; x < size[0]; ++x)
+		{
+			for (int y = 0; y < size[1]; ++y)
 			{
-				menu_displaySaveMenu(grid, seed, totalCycles, totalCells);
-				break;
+				assert(tiledGrid.isAlive(x, y) == expected.isAlive(x, y));
 			}
-			
-			// stop experiment prematurely if grid contains only dead cells. Prevents waiting if cycles is set to a large number.
-			if (checkForDeadCells(grid))
+		}
+	}
+
+	cout << endl << "All tests passed for scheduler";
+}
+
+// test to ensure temporal blocking gives exactly the same grids as stepping one generation at a time. Outputs to console if successful.
+void test_temporalBlocking()
+{
+	int depths[3] = { 2, 5, 17 };
+	for (int depth : depths)
+	{
+		Grid<unsigned char, AgingCell<unsigned char>> stepped(90, 600);
+		unsigned int seed = 42 + depth;
+		scatterCells(stepped, 90 * 600 / 3, seed);
+		Grid<unsigned char, AgingCell<unsigned char>> blocked(90, 600);
+		for (int x = 0; x < 90; ++x)
+		{
+			for (int y = 0; y < 600; ++y)
 			{
-				cout << grid;
-				cout << endl << "All Cells for experiment #" << experimentCount << " have died.";
-				break;
+				blocked.setState(x, y, stepped.getState(x, y));
 			}
-			currentCycle++;
 		}
-		cleanupGrid(grid);
-		if (experimentCount == MAX_EXPERIMENT)
+
+		advanceGenerations(stepped, 20, RuleSpec(), 1);
+		advanceGenerations(blocked, 20, RuleSpec(), depth);
+
+		for (int x = 0; x < 90; ++x)
 		{
-			cout << endl << "Error: Hard Limit Reached. Start another experiment";
+			for (int y = 0; y < 600; ++y)
+			{
+				assert(stepped.getState(x, y) == blocked.getState(x, y));
+			}
 		}
 	}
+
+	cout << endl << "All tests passed for temporal blocking";
 }
 
-// Calculates the ERN for the simulation or pattern
-template <typename T>
-void calculateERN(Grid<T> grid, int totalCells, int* patternChoice)
+// test to ensure the Z-order tiled engine gives the same grids as the standard engine for several rules and grid shapes. Outputs to console if successful.
+void test_mortonEngine()
 {
-	int xSpaces = grid.size();
-	int ySpaces = grid[0].size();
-	// Create a dictionary of patterns with the phase that has the minium amount of available cells to appear.
-	int ern = xSpaces + ySpaces + totalCells;
+	int sizes[4][2] = { { 5, 5 }, { 1, 70 }, { 64, 64 }, { 130, 200 } };
+	RuleSpec rules[3] = { RuleSpec(), RuleSpec(HighLifeRule::birth, HighLifeRule::survival), RuleSpec(DayAndNightRule::birth, DayAndNightRule::survival) };
+	SimulationSettings settings;
+	settings.setEngine(EngineType::MortonTiled);
 
-	if (patternChoice != nullptr)
+	for (auto& size : sizes)
 	{
-		map<string, int> minGridForPattern = {
-			{"Block", 4},
-			{"Beehive", 12},
-			{"Blinker", 9},
-			{"Toad", 16},
-			{"Glider", 9},
-			{"LWSS", 20}
-		};
-
-		switch (*patternChoice)
-		{
-		case 1:
+		for (const RuleSpec& rule : rules)
 		{
-			int blockMinCells = minGridForPattern["Block"];
-			int beehiveMinCells = minGridForPattern["Beehive"];
-			int gridSize = xSpaces * ySpaces;
-
-			if (gridSize < blockMinCells && gridSize < beehiveMinCells) {
-				cout << endl << "A block or a beehive cannot appear in a " << xSpaces << "x" << ySpaces << "grid. ERN Unavailable.";
-				break;
-			}
-			else if (gridSize >= blockMinCells && gridSize < beehiveMinCells) {
-				cout << endl << "A beehive cannot appear in a " << xSpaces << "x" << ySpaces << " grid.";
-				cout << endl << "ERN for Block is: " << ern;
-				break;
-			}
-			else {
-				cout << endl << "The ERN for a block or a beehive in a " << xSpaces << "x" << ySpaces << " grid is: " << ern;
-				break;
+			Grid<bool> expected(size[0], size[1]);
+			unsigned int seed = 7;
+			scatterCells(expected, size[0] * size[1] / 2, seed);
+			Grid<bool> tiled(size[0], size[1]);
+			for (int x = 0; x < size[0]; ++x)
+			{
+				for (int y = 0; y < size[1]; ++y)
+				{
+					tiled.setAlive(x, y, expected.isAlive(x, y));
+				}
 			}
-			break;
-		}
 
-		case 2:
-		{
-			int blinkerMinCells = minGridForPattern["Blinker"];
-			int toadMinCells = minGridForPattern["Toad"];
-			int gridSize = xSpaces * ySpaces;
+			settings.setRule(rule);
+			unique_ptr<StepEngine<bool, NormalCell<bool>>> engine = createEngine(tiled, settings);
+			engine->load(tiled);
+			engine->step(12);
+			engine->store(tiled);
+			advanceGenerations(expected, 12, rule, 1);
 
-			if (gridSize < blinkerMinCells && gridSize < toadMinCells)
+			for (int x = 0; x < size[0]; ++x)
 			{
-				cout << endl << "A blinker or a toad cannot appear in a " << xSpaces << "x" << ySpaces << " grid. ERN Unavailable.";
-				break;
+				for (int y = 0; y < size[1]; ++y)
+				{
+					assert(tiled.isAlive(x, y) == expected.isAlive(x, y));
+				}
 			}
-			else if (gridSize >= blinkerMinCells && gridSize < toadMinCells)
+			assert(engine->allDead() == checkForDeadCells(expected));
+		}
+	}
+
+	cout << endl << "All tests passed for Z-order tiled engine";
+}
+
+// test to ensure patterns are found in any tile of a large grid and that the scan stops with no false matches. Outputs to console if successful.
+void test_parallelPatternScan()
+{
+	Grid<bool> largeGrid(100, 1200);
+	assert(isBlockOrBeehive(largeGrid) == false);
+
+	// Test Block in the last tile
+	largeGrid.setAlive(90, 1100, true);
+	largeGrid.setAlive(90, 1101, true);
+	largeGrid.setAlive(91, 1100, true);
+	largeGrid.setAlive(91, 1101, true);
+	assert(isBlockOrBeehive(largeGrid) == true);
+	assert(isBlinkerOrToad(largeGrid) == false);
+
+	// Test Blinker across a tile border
+	largeGrid.setAlive(15, 600, true);
+	largeGrid.setAlive(16, 600, true);
+	largeGrid.setAlive(17, 600, true);
+	assert(isBlinkerOrToad(largeGrid) == true);
+	assert(isGliderOrLWSS(largeGrid) == false);
+
+	cout << endl << "All tests passed for parallel pattern scan";
+}
+
+// test to ensure the incremental detector agrees with a full scan every generation for both engines. Outputs to console if successful.
+void test_incrementalDetection()
+{
+	const PatternSet* patternSets[3] = { &getStillLifePatterns(), &getOscillatorPatterns(), &getSpaceshipPatterns() };
+	EngineType engines[2] = { EngineType::Standard, EngineType::MortonTiled };
+	SimulationSettings settings;
+
+	for (EngineType engineType : engines)
+	{
+		for (const PatternSet* patterns : patternSets)
+		{
+			Grid<bool> grid(40, 1100);
+			unsigned int seed = 11;
+			scatterCells(grid, 40 * 1100 / 4, seed);
+			ChangeMap changes(grid.getRows(), grid.getCols());
+			IncrementalDetector detector(*patterns);
+
+			settings.setEngine(engineType);
+			unique_ptr<StepEngine<bool, NormalCell<bool>>> engine = createEngine(grid, settings);
+			engine->trackChanges(&changes);
+			engine->load(grid);
+			for (int generation = 0; generation < 25; ++generation)
 			{
-				cout << endl << "A toad cannot appear in a " << xSpaces << "x" << ySpaces << " grid.";
-				cout << endl << "ERN for blinker is: " << ern;
-				break;
+				engine->step(1);
+				engine->store(grid);
+				assert(detector.update(grid, changes) == findPattern(grid, *patterns));
 			}
-			else
+		}
+	}
+
+	// Test a block removed by hand is only noticed once its tile is marked
+	Grid<bool> grid(40, 1100);
+	ChangeMap changes(grid.getRows(), grid.getCols());
+	IncrementalDetector detector(getStillLifePatterns());
+	grid.setAlive(15, 511, true);
+	grid.setAlive(15, 512, true);
+	grid.setAlive(16, 511, true);
+	grid.setAlive(16, 512, true);
+	assert(detector.update(grid, changes) == true);
+	grid.setAlive(16, 512, false);
+	assert(detector.update(grid, changes) == true);
+	changes.markCells(16, 17, 512, 513);
+	assert(detector.update(grid, changes) == false);
+
+	cout << endl << "All tests passed for incremental pattern detection";
+}
+
+// test to ensure the activity map written by each engine marks exactly the live cells and their neighbours, and that scans using it agree with a full scan. Outputs to console if successful.
+void test_activityMap()
+{
+	int sizes[3][2] = { { 5, 70 }, { 40, 600 }, { 130, 200 } };
+	SimulationSettings settings;
+
+	for (auto& size : sizes)
+	{
+		for (int engineType = 0; engineType < 3; ++engineType)
+		{
+			Grid<bool> grid(size[0], size[1]);
+			unsigned int seed = 5;
+			scatterCells(grid, size[0] * size[1] / 5, seed);
+			ActivityMap activity;
+
+			settings.setEngine(engineType == 2 ? EngineType::MortonTiled : EngineType::Standard);
+			settings.setBlockDepth(engineType == 1 ? 4 : 1);
+			unique_ptr<StepEngine<bool, NormalCell<bool>>> engine = createEngine(grid, settings);
+			engine->trackActivity(&activity);
+			engine->load(grid);
+			engine->step(6);
+			engine->store(grid);
+
+			assert(usableActivity(grid, &activity) == &activity);
+			for (int x = 0; x < size[0]; ++x)
 			{
-				cout << endl << "The ERN for a blinker or a toad in a " << xSpaces << "x" << ySpaces << " grid is: " << ern;
-				break;
+				for (int y = 0; y < size[1]; ++y)
+				{
+					bool active = (activity.getActiveRow(x)[y / 64] >> (y % 64)) & 1u;
+					assert(active == (grid.isAlive(x, y) || countLiveNeighbours(grid, x, y) > 0));
+				}
 			}
-			break;
+			assert(findPattern(grid, getStillLifePatterns(), &activity) == findPattern(grid, getStillLifePatterns()));
+			assert(findPattern(grid, getOscillatorPatterns(), &activity) == findPattern(grid, getOscillatorPatterns()));
 		}
-		case 3:
+	}
+
+	// Test a map for another grid size or one changed since the step is not used
+	Grid<bool> grid(10, 10);
+	ActivityMap activity;
+	assert(usableActivity(grid, &activity) == nullptr);
+	UpdateCells(grid, RuleSpec(), nullptr, &activity);
+	assert(usableActivity(grid, &activity) == &activity);
+	activity.invalidate();
+	assert(usableActivity(grid, &activity) == nullptr);
+
+	cout << endl << "All tests passed for activity map";
+}
+
+// test to ensure the bitboard matcher finds the same positions as checking each position cell by cell. Outputs to console if successful.
+void test_bitboardMatcher()
+{
+	int sizes[4][2] = { { 3, 3 }, { 9, 130 }, { 33, 600 }, { 70, 64 } };
+	const PatternSet* patternSets[3] = { &getStillLifePatterns(), &getOscillatorPatterns(), &getSpaceshipPatterns() };
+
+	for (auto& size : sizes)
+	{
+		for (int density = 2; density <= 6; density += 2)
 		{
-			int gliderMinCells = minGridForPattern["Glider"];
-			int lwssMinCells = minGridForPattern["LWSS"];
-			int gridSize = xSpaces * ySpaces;
+			Grid<bool> grid(size[0], size[1]);
+			unsigned int seed = density;
+			scatterCells(grid, size[0] * size[1] / density, seed);
+			UpdateCells(grid);
 
-			if (gridSize < gliderMinCells && gridSize < lwssMinCells)
+			for (const PatternSet* patterns : patternSets)
 			{
-				cout << endl << "A glider or a LWSS cannot appear in a " << xSpaces << "x" << ySpaces << " grid. ERN Unavailable";
-				break;
-			}
-			else if (gridSize >= gliderMinCells && gridSize < lwssMinCells)
-			{
-				cout << endl << "A LWSS cannot appear in a " << xSpaces << "x" << ySpaces << " grid.";
-				cout << "The ERN for a glider is: " << ern;
-				break;
+				bool expected = false;
+				for (int x = 0; x < size[0] && !expected; ++x)
+				{
+					for (int y = 0; y < size[1] && !expected; ++y)
+					{
+						expected = matchesPattern(grid, *patterns, x, y);
+					}
+				}
+				assert(findPattern(grid, *patterns) == expected);
 			}
-			else
+		}
+	}
+
+	// Test a glider touching the bottom right corner across a word border
+	Grid<bool> grid(20, 130);
+	grid.setAlive(17, 128, true);
+	grid.setAlive(18, 129, true);
+	grid.setAlive(19, 127, true);
+	grid.setAlive(19, 128, true);
+	grid.setAlive(19, 129, true);
+	assert(isGliderOrLWSS(grid) == true);
+	grid.setAlive(19, 127, false);
+	assert(isGliderOrLWSS(grid) == false);
+
+	cout << endl << "All tests passed for bitboard matcher";
+}
+
+// test to ensure scatterCells gives exactly the requested number of cells at any density and the same grid for the same seed. Outputs to console if successful.
+void test_scatterCells()
+{
+	int sizes[3][2] = { { 1, 1 }, { 7, 23 }, { 100, 300 } };
+
+	for (auto& size : sizes)
+	{
+		int area = size[0] * size[1];
+		int counts[5] = { 0, 1, area / 2, area - 1, area + 5 };
+		for (int scatterVersion : { LEGACY_SCATTER, SCATTER_VERSION })
+		{
+			for (int numCells : counts)
 			{
-				cout << endl << "The ERN for a glider or a LWSS in a " << xSpaces << "x" << ySpaces << " grid is: " << ern;
-				break;
+				Grid<bool> first(size[0], size[1]);
+				Grid<bool> second(size[0], size[1]);
+				unsigned int seed = 42;
+				scatterCells(first, numCells, seed, scatterVersion);
+				scatterCells(second, numCells, seed, scatterVersion);
+
+				int live = 0;
+				for (int x = 0; x < size[0]; ++x)
+				{
+					for (int y = 0; y < size[1]; ++y)
+					{
+						live += first.isAlive(x, y);
+						assert(first.isAlive(x, y) == second.isAlive(x, y));
+					}
+				}
+				assert(live == min(max(numCells, 0), area));
 			}
-			break;
 		}
+	}
 
-		default:
-			cout << endl << "Unknown pattern. ERN Unavailable";
+	// Test a different seed gives a different grid
+	Grid<bool> first(50, 50);
+	Grid<bool> second(50, 50);
+	unsigned int firstSeed = 1;
+	unsigned int secondSeed = 2;
+	scatterCells(first, 1250, firstSeed);
+	scatterCells(second, 1250, secondSeed);
+	bool differs = false;
+	for (int x = 0; x < 50 && !differs; ++x)
+	{
+		for (int y = 0; y < 50 && !differs; ++y)
+		{
+			differs = first.isAlive(x, y) != second.isAlive(x, y);
 		}
 	}
+	assert(differs);
 
-	cout << endl << "The ERN for a " << xSpaces << "x" << ySpaces << " grid with " << totalCells << " live cells is: " << ern;
+	cout << endl << "All tests passed for scatterCells";
 }
 
-// Calculates and displays the lowest possible ERN for all paterns by checking all possible grid sizes
-void displayLowestPossibleERN()
+// test to ensure every engine gives the same checksum at every generation of a replay and that jumping to a generation gives the same grid. Outputs to console if successful.
+void test_deterministicReplay()
 {
-	vector<vector<bool>> block = {
-		{true, true},
-		{true, true},
-	};
+	SimulationSettings settings[3];
+	settings[1].setBlockDepth(7);
+	settings[2].setEngine(EngineType::MortonTiled);
+	ReplayLog logs[3];
 
-	vector<vector<bool>> beehive = {
-		{false, true, true, false},
-		{true, false, false, true},
-		{false, true, true, false}
-	};
+	for (int i = 0; i < 3; ++i)
+	{
+		Grid<bool> grid(45, 140);
+		unsigned int seed = 2024;
+		scatterCells(grid, 45 * 140 / 3, seed);
+		logs[i].record(0, gridChecksum(grid));
+
+		unique_ptr<StepEngine<bool, NormalCell<bool>>> engine = createEngine(grid, settings[i]);
+		engine->load(grid);
+		for (int generation = 1; generation <= 60; ++generation)
+		{
+			engine->step(1);
+			engine->store(grid);
+			logs[i].record(generation, gridChecksum(grid));
+		}
+	}
 
-	vector<vector<bool>> blinker =
+	int compared;
+	assert(logs[0].firstMismatch(logs[1], compared) == -1 && compared == 61);
+	assert(logs[0].firstMismatch(logs[2], compared) == -1 && compared == 61);
+
+	// Test jumping to a generation with each engine
+	for (int i = 0; i < 3; ++i)
 	{
-		{true},
-		{true},
-		{true}
-	};
+		Grid<bool> grid(45, 140);
+		unsigned int seed = 2024;
+		scatterCells(grid, 45 * 140 / 3, seed);
+		fastForward(grid, 37, settings[i]);
+		uint64_t checksum;
+		assert(logs[0].getChecksum(37, checksum) && gridChecksum(grid) == checksum);
+
+		// Test a single cell changes the checksum
+		grid.setAlive(44, 139, !grid.isAlive(44, 139));
+		assert(gridChecksum(grid) != checksum);
+	}
 
-	vector<vector<bool>> toad =
+	cout << endl << "All tests passed for deterministic replay";
+}
+
+// test to ensure the distributed engine gives the same grids as the standard engine for any number of workers and both transports, with its workers
+// kept across steps and restarted when a grid is loaded again. Outputs to console if successful.
+void test_distributedEngine()
+{
+	int sizes[4][2] = { { 1, 1 }, { 3, 70 }, { 50, 130 }, { 9, 64 } };
+	int workerCounts[3] = { 1, 3, 8 };
+	TransportType transports[2] = { TransportType::SharedMemory, TransportType::UnixSocket };
+	RuleSpec rules[2] = { RuleSpec(), RuleSpec((1 << 0) | (1 << 3), (1 << 2) | (1 << 3)) };
+	SimulationSettings settings;
+	settings.setEngine(EngineType::Distributed);
+
+	for (auto& size : sizes)
 	{
-		{false, true, true, true},
-		{true, true, true, false}
-	};
+		for (int workers : workerCounts)
+		{
+			for (TransportType transport : transports)
+			{
+				for (const RuleSpec& rule : rules)
+				{
+					Grid<bool> expected(size[0], size[1]);
+					unsigned int seed = 99;
+					scatterCells(expected, size[0] * size[1] / 3, seed);
+					Grid<bool> distributed(size[0], size[1]);
+					seed = 99;
+					scatterCells(distributed, size[0] * size[1] / 3, seed);
+
+					settings.setRule(rule);
+					settings.setWorkers(workers);
+					settings.setTransport(transport);
+					unique_ptr<StepEngine<bool, NormalCell<bool>>> engine = createEngine(distributed, settings);
+					engine->load(distributed);
+					engine->step(9);
+					engine->step(4);
+					for (int i = 0; i < 3; ++i)
+					{
+						engine->step(1);
+					}
+					engine->store(distributed);
+
+					// Loading again starts new workers from the stored grid
+					engine->load(distributed);
+					engine->step(2);
+					engine->store(distributed);
+					advanceGenerations(expected, 18, rule, 1);
+
+					assert(gridChecksum(distributed) == gridChecksum(expected));
+					assert(engine->allDead() == checkForDeadCells(expected));
+				}
+			}
+		}
+	}
+
+#ifndef _WIN32
+	// Test a worker that dies makes the step fail instead of leaving the other workers waiting on its rows
+	for (TransportType transport : transports)
+	{
+		SharedBuffer cells(static_cast<size_t>(30) * 2 * sizeof(uint64_t));
+		SlabWorkers slabWorkers;
+		bool started = false;
+		dispatchRule(RuleSpec(), [&](auto compiledRule) { started = slabWorkers.start(cells, 30, 2, ~uint64_t(0), 3, transport, compiledRule); });
+		assert(started && slabWorkers.step(2));
+		kill(slabWorkers.getChildren()[1], SIGKILL);
+		assert(!slabWorkers.step(3));
+		assert(!slabWorkers.isRunning());
+	}
+#endif
 
-	vector<vector<bool>> glider =
+	cout << endl << "All tests passed for distributed engine";
+}
+
+// test to ensure the out-of-core engine gives the same grids as the standard engine for runs shorter and longer than one wavefront pass, and that snapshots created on disk match scatterCells. Outputs to console if successful.
+void test_outOfCoreEngine()
+{
+	int sizes[4][2] = { { 1, 1 }, { 3, 70 }, { 150, 130 }, { 9, 64 } };
+	int stepCounts[3] = { 1, 5, WAVEFRONT_DEPTH * 2 + 3 };
+	RuleSpec rules[2] = { RuleSpec(), RuleSpec((1 << 0) | (1 << 3), (1 << 2) | (1 << 3)) };
+	string backingFile = "test_outofcore.snap";
+	SimulationSettings settings;
+	settings.setEngine(EngineType::OutOfCore);
+	settings.setBackingFile(backingFile);
+
+	for (auto& size : sizes)
 	{
-		{false, true, false},
-		{false, false, true},
-		{true, true, true}
-	};
+		for (int steps : stepCounts)
+		{
+			for (const RuleSpec& rule : rules)
+			{
+				Grid<bool> expected(size[0], size[1]);
+				unsigned int seed = 7;
+				scatterCells(expected, size[0] * size[1] / 3, seed);
+				Grid<bool> outOfCore(size[0], size[1]);
+				seed = 7;
+				scatterCells(outOfCore, size[0] * size[1] / 3, seed);
+
+				settings.setRule(rule);
+				ChangeMap changes(size[0], size[1]);
+				changes.clear();
+				ActivityMap activity;
+				unique_ptr<StepEngine<bool, NormalCell<bool>>> engine = createEngine(outOfCore, settings);
+				engine->trackChanges(&changes);
+				engine->trackActivity(&activity);
+				engine->load(outOfCore);
+				engine->step(steps);
+				engine->store(outOfCore);
+				Grid<bool> before = expected.clone();
+				advanceGenerations(expected, steps, rule, 1);
+
+				assert(gridChecksum(outOfCore) == gridChecksum(expected));
+				assert(engine->allDead() == checkForDeadCells(expected));
+				for (int x = 0; x < size[0]; ++x)
+				{
+					for (int y = 0; y < size[1]; ++y)
+					{
+						assert(activity.isReady() && ((activity.getLiveRow(x)[y / 64] >> (y % 64)) & 1u) == expected.isAlive(x, y));
+						if (before.isAlive(x, y) != expected.isAlive(x, y))
+						{
+							assert(changes.isChanged(x / TILE_ROWS, y / TILE_COLS));
+						}
+					}
+				}
+			}
+		}
+	}
 
-	vector<vector<bool>> lwss =
+	// A snapshot created on disk starts with the same cells scatterCells gives, and advancing it matches the grid
+	Grid<bool> expected(40, 100);
+	unsigned int seed = 21;
+	scatterCells(expected, 1000, seed);
+	assert(createSnapshotFile(backingFile, 40, 100, 1000, 21, RuleSpec()));
+	MappedFile snapshotFile;
+	assert(snapshotFile.open(backingFile));
+	const SnapshotHeader& header = *reinterpret_cast<const SnapshotHeader*>(snapshotFile.getData());
+	assert(checkSnapshotHeader(header, snapshotFile.getBytes()));
+	advanceMappedSnapshot(snapshotFile, 20);
+	advanceGenerations(expected, 20, RuleSpec(), 1);
+	assert(header.generation == 20);
+	const uint64_t* cells = reinterpret_cast<const uint64_t*>(snapshotFile.getData() + sizeof(SnapshotHeader));
+	for (int x = 0; x < 40; ++x)
 	{
-		{false, true, false, false, true},
-		{true, false, false, false, false},
-		{true, false, false, false, true},
-		{true, true, true, true, false}
-	};
+		for (int y = 0; y < 100; ++y)
+		{
+			assert(((cells[x * 2 + y / 64] >> (y % 64)) & 1u) == expected.isAlive(x, y));
+		}
+	}
+	snapshotFile.close();
+	remove(backingFile.c_str());
 
-	int maxGridSize = 10;
-	vector<vector<vector<bool>>> patterns = { block, beehive, blinker, toad, glider, lwss };
-	vector<string> patternNames = { "Block", "Beehive", "Blinker", "Toad", "Glider", "LWSS" };
+	cout << endl << "All tests passed for out-of-core engine";
+}
 
-	for (int p = 0; p < patterns.size(); ++p) {
-		const auto& pattern = patterns[p];
-		int lowestErn = INT_MAX; // initialise to large number to check if ern is lower
-		int bestWidth = 0;
-		int bestHeight = 0;
-		int totalAliveCells = 0;
+// test to ensure the sparse tile engine gives the same grids as the standard engine and only keeps tiles that have live cells. Outputs to console if successful.
+void test_sparseTileEngine()
+{
+	int sizes[4][2] = { { 5, 5 }, { 1, 70 }, { 64, 64 }, { 130, 200 } };
+	RuleSpec rules[3] = { RuleSpec(), RuleSpec(HighLifeRule::birth, HighLifeRule::survival), RuleSpec((1 << 0) | (1 << 3), (1 << 2) | (1 << 3)) };
+	SimulationSettings settings;
+	settings.setEngine(EngineType::SparseTiles);
 
-		// Count only alive cells from pattern
-		for (const auto& row : pattern)
+	for (auto& size : sizes)
+	{
+		for (const RuleSpec& rule : rules)
 		{
-			for (bool cell : row)
+			Grid<bool> expected(size[0], size[1]);
+			unsigned int seed = 13;
+			scatterCells(expected, size[0] * size[1] / 4, seed);
+			Grid<bool> sparse(size[0], size[1]);
+			seed = 13;
+			scatterCells(sparse, size[0] * size[1] / 4, seed);
+
+			settings.setRule(rule);
+			ActivityMap activity;
+			unique_ptr<StepEngine<bool, NormalCell<bool>>> engine = createEngine(sparse, settings);
+			engine->trackActivity(&activity);
+			engine->load(sparse);
+			engine->step(17);
+			engine->store(sparse);
+			advanceGenerations(expected, 17, rule, 1);
+
+			assert(gridChecksum(sparse) == gridChecksum(expected));
+			assert(engine->allDead() == checkForDeadCells(expected));
+			for (int x = 0; x < size[0]; ++x)
 			{
-				if (cell)
+				for (int y = 0; y < size[1]; ++y)
 				{
-					totalAliveCells++;
+					assert(((activity.getLiveRow(x)[y / 64] >> (y % 64)) & 1u) == expected.isAlive(x, y));
 				}
 			}
 		}
+	}
 
-		for (int rows = 1; rows < maxGridSize + 1; ++rows)
+	// A glider crossing a large empty grid only ever holds the few tiles around it, and reuses the ones it leaves behind.
+	// The activity map written as it goes holds just the glider, with its active cells rebuilt only around the tiles that changed.
+	SparseTileGrid grid(4096, 4096);
+	ActivityMap activity;
+	int glider[5][2] = { { 0, 1 }, { 1, 2 }, { 2, 0 }, { 2, 1 }, { 2, 2 } };
+	for (auto& cell : glider)
+	{
+		grid.setAlive(cell[0] + 60, cell[1] + 60, true);
+	}
+	int mostTiles = 0;
+	for (int generation = 0; generation < 1000; ++generation)
+	{
+		grid.step(ConwayRule(), nullptr, &activity);
+		mostTiles = max(mostTiles, grid.getOccupiedTiles());
+		if (generation % 50 == 49)
 		{
-			for (int cols = 1; cols < maxGridSize + 1; ++cols)
+			activity.refresh();
+			int offset = 60 + (generation + 1) / 4;
+			for (int x = offset - 2; x < offset + 5; ++x)
 			{
-				// Check if the pattern fits in the grid
-				int pHeight = pattern.size();
-				int pWidth = pattern[0].size();
-				if (pHeight < rows + 1 && pWidth < cols + 1)
+				for (int y = offset - 2; y < offset + 5; ++y)
 				{
-					//calculate ern if better set variables as new best grid size and ern
-					int ern = rows + cols + totalAliveCells;
-					if (ern < lowestErn) {
-						lowestErn = ern;
-						bestWidth = rows;
-						bestHeight = cols;
+					bool alive = grid.isAlive(x, y);
+					bool nearLive = false;
+					for (int dx = -1; dx <= 1; ++dx)
+					{
+						for (int dy = -1; dy <= 1; ++dy)
+						{
+							nearLive = nearLive || grid.isAlive(x + dx, y + dy);
+						}
 					}
+					assert(((activity.getLiveRow(x)[y / 64] >> (y % 64)) & 1u) == alive);
+					assert(((activity.getActiveRow(x)[y / 64] >> (y % 64)) & 1u) == nearLive);
 				}
 			}
 		}
-		cout << endl << "The lowest possible ERN for a " << patternNames[p] << " in a " << bestWidth << "x" << bestHeight << " grid is: " << lowestErn;
 	}
-
-}
-
-// SAVE FUNCTIONS
-
-// Saves the Grid onto the system storage. Creates a .txt file with user defined filename
-template <typename T>
-void saveSimulation(Grid<T> &grid)
-{
-	// Saves the simulation to the drive.
-	string filename;
-	cout << endl << "Enter file name: ";
-	cin >> filename;
-	ofstream gridSaveFile(filename + ".txt");
-	if (gridSaveFile.is_open())
+	assert(mostTiles <= 4);
+	assert(grid.getPooledTiles() <= 8);
+	for (auto& cell : glider)
 	{
-		// save the grid from main grid into txt file
-		gridSaveFile << grid;
+		// After 1000 generations the glider has moved 250 cells down and right and is back in its starting phase
+		assert(grid.isAlive(cell[0] + 310, cell[1] + 310));
 	}
-	gridSaveFile.close();
-}
 
-// Saves the paramaters used to generate a simulation. Creates a .CSV file with user defined filename
-template <typename T>
-void saveParameters(Grid<T>& grid, unsigned int seed, int totalCells, int totalCycles)
-{
-	// Saves the parameters to generate the case again
-	string filename;
-	int rows;
-	int cols;
-	cout << endl << "Enter file name: ";
-	cin >> filename;
-	
-	ofstream parametersSaveFile(filename + ".csv");
-	if (parametersSaveFile.is_open())
+	// Nothing is left behind in the map where the glider has been
+	activity.refresh();
+	int liveCells = 0;
+	int activeCells = 0;
+	for (int x = 0; x < 4096; ++x)
 	{
-		rows = grid.size();
-		parametersSaveFile << rows << ",";
-		cols = grid[0].size();
-		parametersSaveFile << cols << ",";
-		parametersSaveFile << seed << ",";
-		parametersSaveFile << totalCells << ",";
-		parametersSaveFile << totalCycles << ",";
+		for (int word = 0; word < 64; ++word)
+		{
+			liveCells += countBits(activity.getLiveRow(x)[word]);
+			activeCells += countBits(activity.getActiveRow(x)[word]);
+		}
 	}
+	assert(liveCells == 5);
+	assert(activeCells == 22);
 
-	parametersSaveFile.close();
+	cout << endl << "All tests passed for sparse tile engine";
 }
 
-// LOAD FUNCTIONS
-
-// Loads a .txt file from the system storage and updates the grid based on the position of the cells inside the text file.
-template <typename T>
-bool loadGridSimulation(Grid<T> &grid) 
+// test to ensure stepping and reloading grids reuses the same buffers instead of allocating new ones. Outputs to console if successful.
+void test_reusableBuffers()
 {
+	// Stepping swaps the grid with one back buffer, so its cells only ever live in two places
+	Grid<bool> grid(70, 300);
+	unsigned int seed = 3;
+	scatterCells(grid, 70 * 300 / 3, seed);
+	UpdateCells(grid);
+	const unsigned char* first = grid.getRow(0);
+	UpdateCells(grid);
+	const unsigned char* second = grid.getRow(0);
+	assert(first != second);
+	for (int generation = 0; generation < 6; ++generation)
+	{
+		advanceGenerations(grid, 1 + generation % 3, RuleSpec(), 4);
+		assert(grid.getRow(0) == first || grid.getRow(0) == second);
+	}
 
-	// Loads the simulation from the drive.
-	string loadedRow;
-	string filename;
-
-	cout << endl << "Enter file name to load: ";
-	cin >> filename;
-
-	ifstream gridLoadFile(filename + ".txt");
-
-	if (!gridLoadFile.is_open())
+	// Resetting to a smaller or equal size keeps the memory and clears every cell
+	const unsigned char* before = grid.getRow(0);
+	grid.reset(20, 50);
+	assert(grid.getRow(0) == before && checkForDeadCells(grid));
+	grid.reset(70, 300);
+	assert(grid.getRow(0) == before && checkForDeadCells(grid));
+
+	// Reloading an engine with a grid of the same size reuses its tiles, workers or backing file and gives the same run again
+	EngineType engines[4] = { EngineType::MortonTiled, EngineType::SparseTiles, EngineType::Distributed, EngineType::OutOfCore };
+	SimulationSettings settings;
+	settings.setBackingFile("test_reusable.snap");
+	for (EngineType engineType : engines)
+	{
+		settings.setEngine(engineType);
+		unique_ptr<StepEngine<bool, NormalCell<bool>>> engine = createEngine(grid, settings);
+		uint64_t checksums[2];
+		for (int run = 0; run < 2; ++run)
 		{
-			cout << endl << "Error: Unable to open the file.";
-			cin >> ClearAndIgnore();
-			return false;
+			createCells(grid);
+			seed = 3;
+			scatterCells(grid, 70 * 300 / 3, seed);
+			engine->load(grid);
+			engine->step(10);
+			engine->store(grid);
+			checksums[run] = gridChecksum(grid);
 		}
+		assert(checksums[0] == checksums[1]);
+	}
+	remove("test_reusable.snap");
 
-	// Clears the grid allowing for the loaded layout to be copied onto it.
-
-	cleanupGrid(grid);
-	grid.clear();
+	cout << endl << "All tests passed for reusable buffers";
+}
 
+// test to ensure moving a grid hands over its cells, clone copies them and a view sees the grid it was taken from. Outputs to console if successful.
+void test_gridOwnership()
+{
+	Grid<bool> grid(30, 40);
+	unsigned int seed = 17;
+	scatterCells(grid, 300, seed);
+	uint64_t checksum = gridChecksum(grid);
+	const unsigned char* cells = grid.getRow(0);
+
+	// Moving keeps the same cells and leaves the old grid empty
+	Grid<bool> moved(move(grid));
+	assert(moved.getRow(0) == cells && gridChecksum(moved) == checksum);
+	assert(grid.empty() && grid.getRows() == 0 && grid.getCols() == 0);
+	grid = move(moved);
+	assert(grid.getRow(0) == cells && moved.empty());
+
+	// A clone is a separate copy
+	Grid<bool> copy = grid.clone();
+	assert(copy.getRow(0) != grid.getRow(0) && gridChecksum(copy) == checksum);
+	copy.setAlive(0, 0, !copy.isAlive(0, 0));
+	assert(gridChecksum(grid) == checksum);
+
+	// A view reads the grid's own cells
+	GridView<bool> view = grid.view();
+	assert(view.getRows() == 30 && view.getCols() == 40 && view.getRow(0) == cells);
+	grid.setAlive(5, 5, !view.isAlive(5, 5));
+	assert(view.isAlive(5, 5) == grid.isAlive(5, 5));
+
+	cout << endl << "All tests passed for grid ownership";
+}
 
-	while (getline(gridLoadFile, loadedRow))
+// test to ensure the soup search steps boards like the grid, walks every combination once and finds soups that really produce each pattern. Outputs to console if successful.
+void test_soupSearch()
+{
+	// Boards step exactly like grids of the same size
+	RuleSpec rules[2] = { RuleSpec(), RuleSpec(HighLifeRule::birth, HighLifeRule::survival) };
+	for (const RuleSpec& rule : rules)
 	{
-			if (loadedRow.find("---") != string::npos)
-			{
-				continue;
-			}
-			vector<CellBase<T>*> newRow;
-
-			for (char cellChar : loadedRow)
+		for (int rows = 1; rows <= SOUP_BOARD_SIDE; ++rows)
+		{
+			for (int cols = 1; cols <= SOUP_BOARD_SIDE; cols += 3)
 			{
-				if (cellChar == 'O') // If alive cell.
+				Grid<bool> grid(rows, cols);
+				unsigned int seed = rows * 10 + cols;
+				scatterCells(grid, rows * cols / 2, seed);
+				uint64_t board = 0;
+				for (int x = 0; x < rows; ++x)
 				{
-					newRow.push_back(new NormalCell<T>(true));
+					for (int y = 0; y < cols; ++y)
+					{
+						board |= uint64_t(grid.isAlive(x, y)) << (SOUP_BOARD_SIDE * x + y);
+					}
 				}
-				else if (cellChar == ' ')
+				for (int generation = 0; generation < 5; ++generation)
 				{
-					newRow.push_back(new NormalCell<T>(false));
+					dispatchRule(rule, [&](auto compiledRule) { board = stepBoard(board, boardMask(rows, cols), compiledRule); });
+					UpdateCells(grid, rule);
+					assert(gridChecksum(soupToGrid(board, rows, cols)) == gridChecksum(grid));
 				}
 			}
-			grid.push_back(newRow);
+		}
 	}
-	gridLoadFile.close();
-	return true;
-}
-
-// Loads a .csv file from the system storage and stores the values into a CSVData class to pass into simulation
-CSVData LoadParamSimulation()
-{
-	string filename;
-	string line;
-	ifstream paramLoadFile;
-
-	do {
-
-		cout << endl << "Enter file name to load: ";
-		cin >> filename;
-
-		paramLoadFile.open(filename + ".csv");
 
-		if (!paramLoadFile.is_open())
+	// Flips and the transpose move each cell where they should
+	uint64_t board = 0x0000000021140B23ULL;
+	for (int x = 0; x < 5; ++x)
+	{
+		for (int y = 0; y < 6; ++y)
 		{
-			cout << endl << "Error: Unable to open the file.";
-			cin >> ClearAndIgnore();
-
+			bool alive = (board >> (SOUP_BOARD_SIDE * x + y)) & 1u;
+			assert(((flipBoardRows(board, 5) >> (SOUP_BOARD_SIDE * (4 - x) + y)) & 1u) == alive);
+			assert(((flipBoardCols(board, 6) >> (SOUP_BOARD_SIDE * x + (5 - y))) & 1u) == alive);
+			assert(((transposeBoard(board) >> (SOUP_BOARD_SIDE * y + x)) & 1u) == alive);
 		}
-	} while (!paramLoadFile.is_open());
+	}
 
-	if (getline(paramLoadFile, line))
+	// Gosper's hack from any rank gives the same combinations as unranking each one
+	uint64_t combination = unrankCombination(0, 12, 5);
+	for (uint64_t rank = 0; rank < binomial(12, 5); ++rank, combination = nextCombination(combination))
 	{
-		stringstream ss(line);
-		string token;
-		int xSpaces;
-		int ySpaces;
-		int totalCells;
-		int totalCycles;
-		unsigned int seed;
-
-		getline(ss, token, ',');
-		xSpaces = stoi(token);
-
-		getline(ss, token, ',');
-		ySpaces = stoi(token);
-
-		getline(ss, token, ',');
-		seed = static_cast<unsigned int>(stoul(token));
-
-		getline(ss, token, ',');
-		totalCycles = stoi(token);
-
-		getline(ss, token, ',');
-		totalCells = stoi(token);
-
-		return CSVData(xSpaces, ySpaces, seed, totalCycles, totalCells);
-
+		assert(combination == unrankCombination(rank, 12, 5));
+		assert(combination < (uint64_t(1) << 12));
 	}
 
+	// Three cells in a 2x2 grid fill in to a block, and every soup found produces its pattern when run on a grid
+	vector<vector<vector<bool>>> patterns = {
+		{ { true, true }, { true, true } },
+		{ { true, true, true } },
+		{ { false, true, true, true }, { true, true, true, false } }
+	};
+	vector<SoupRecord> records = findLowestERNSoups(patterns, 4, RuleSpec());
+	assert(records[0].found && records[0].getERN() == 7 && records[0].rows == 2 && records[0].cols == 2);
+	for (size_t p = 0; p < patterns.size(); ++p)
+	{
+		assert(records[p].found);
+		PatternSet target({ patterns[p] });
+		Grid<bool> grid = soupToGrid(records[p].soup, records[p].rows, records[p].cols);
+		bool produced = false;
+		for (int generation = 0; generation < 64 && !produced; ++generation)
+		{
+			UpdateCells(grid);
+			produced = findPattern(grid, target);
+		}
+		assert(produced);
+	}
 
-
-
+	cout << endl << "All tests passed for soup search";
 }
 
-// TEST FUNCTIONS
-
-template <typename T>
-// test to ensure isBlockOrBeehive functions as intended. Outputs to console if successful.
-void test_isBlockOrBeehive(Grid<T>& grid)
+// test to ensure the spaceship tracker reports the period and movement of gliders and LWSSs and ignores oscillators and debris. Outputs to console if successful.
+void test_spaceshipTracker()
 {
-	// Test empty
-
-	bool foundNothing = isBlockOrBeehive(grid);
-	assert(foundNothing == false);
-
-
-	// Test Block
-	grid[1][1]->setAlive(true);
-	grid[2][1]->setAlive(true);
-	grid[1][2]->setAlive(true);
-	grid[2][2]->setAlive(true);
-
-	bool foundBlock = isBlockOrBeehive(grid);
-	assert(foundBlock == true);
-
-	grid[1][1]->setAlive(false);
-	grid[2][1]->setAlive(false);
-	grid[1][2]->setAlive(false);
-	grid[2][2]->setAlive(false);
-
-	// Test Beehive
-	grid[2][0]->setAlive(true);
-	grid[1][1]->setAlive(true);
-	grid[3][1]->setAlive(true);
-	grid[1][2]->setAlive(true);
-	grid[3][2]->setAlive(true);
-	grid[2][3]->setAlive(true);
-
-	bool foundBeehive = isBlockOrBeehive(grid);
-	assert(foundBeehive == true);
-
-	grid[2][0]->setAlive(false);
-	grid[1][1]->setAlive(false);
-	grid[3][1]->setAlive(false);
-	grid[1][2]->setAlive(false);
-	grid[3][2]->setAlive(false);
-	grid[2][3]->setAlive(false);
-
-	cout << endl << "All tests passed for isBlockOrBeehive()";
-
+	Grid<bool> grid(60, 200);
+	int glider[5][2] = { { 5, 6 }, { 6, 7 }, { 7, 5 }, { 7, 6 }, { 7, 7 } };
+	int lwss[9][2] = { { 30, 101 }, { 30, 104 }, { 31, 100 }, { 32, 100 }, { 32, 104 }, { 33, 100 }, { 33, 101 }, { 33, 102 }, { 33, 103 } };
+	int blinker[3][2] = { { 50, 20 }, { 50, 21 }, { 50, 22 } };
+	for (auto& cell : glider) { grid.setAlive(cell[0], cell[1], true); }
+	for (auto& cell : lwss) { grid.setAlive(cell[0], cell[1], true); }
+	for (auto& cell : blinker) { grid.setAlive(cell[0], cell[1], true); }
+
+	ChangeMap changes(grid.getRows(), grid.getCols());
+	SpaceshipTracker tracker;
+	SimulationSettings settings;
+	unique_ptr<StepEngine<bool, NormalCell<bool>>> engine = createEngine(grid, settings);
+	engine->trackChanges(&changes);
+	engine->load(grid);
+	set<tuple<int, int, int>> movements;
+	assert(tracker.update(grid, changes) == false);
+	for (int generation = 0; generation < 12; ++generation)
+	{
+		engine->step(1);
+		engine->store(grid);
+		tracker.update(grid, changes);
+		for (const MovingObject& ship : tracker.getFound())
+		{
+			movements.insert(make_tuple(ship.period, ship.dx, ship.dy));
+		}
+	}
+	assert((movements == set<tuple<int, int, int>>{ make_tuple(4, 1, 1), make_tuple(4, 0, -2) }));
+
+	// A block taken away and put back one cell over looks the same but is not a spaceship
+	Grid<bool> debris(20, 20);
+	ChangeMap debrisChanges(debris.getRows(), debris.getCols());
+	SpaceshipTracker debrisTracker;
+	debris.setAlive(5, 5, true);
+	debris.setAlive(5, 6, true);
+	debris.setAlive(6, 5, true);
+	debris.setAlive(6, 6, true);
+	assert(debrisTracker.update(debris, debrisChanges) == false);
+	debris.setAlive(5, 5, false);
+	debris.setAlive(6, 5, false);
+	debris.setAlive(5, 7, true);
+	debris.setAlive(6, 7, true);
+	debrisChanges.markAll();
+	assert(debrisTracker.update(debris, debrisChanges) == false);
+
+	cout << endl << "All tests passed for spaceship tracker";
 }
 
-// test to ensure isBlinkerOrToad functions as intended. Outputs to console if successful (toads were rare >:| )
-template <typename T>
-void test_isBlinkerOrToad(Grid<T>& grid)
+// test to ensure sweep runs find the generation each soup settles at, and that saved results survive a last line cut short. Outputs to console if successful.
+void test_parameterSweep()
 {
-	// Test empty
+	// Points with more cells than spaces are left out
+	vector<SweepPoint> points = sweepPoints(SweepRange{ 3, 12, 3 }, SweepRange{ 4, 4, 1 }, SweepRange{ 10, 30, 10 }, 2);
+	assert(points.size() == 18 && points.front().rows == 3 && points.front().cells == 10);
 
-	bool foundNothing = isBlinkerOrToad(grid);
-	assert(foundNothing == false);
+	// Checks each result against the soup stepped on an ordinary grid
+	vector<SweepResult> results;
+	for (int seed = 0; seed < 6; ++seed)
+	{
+		SweepPoint point = { 12, 70, 250, seed };
+		SweepResult result = runSweepPoint(point, getStillLifePatterns(), false, ConwayRule());
+		assert(result.period > 0 && result.generations >= 0);
+		results.push_back(result);
+
+		uint64_t key = mixBits(mixBits((uint64_t(point.rows) << 32) | uint32_t(point.cols)) ^ ((uint64_t(point.cells) << 32) | uint32_t(point.seed)));
+		vector<uint64_t> cells;
+		fillSoup(cells, point.rows, point.cols, 2, point.cells, key);
+		Grid<bool> grid(point.rows, point.cols);
+		for (int x = 0; x < point.rows; ++x)
+		{
+			for (int y = 0; y < point.cols; ++y)
+			{
+				grid.setAlive(x, y, ((cells[static_cast<size_t>(x) * 2 + y / 64] >> (y % 64)) & 1u) != 0);
+			}
+		}
+		vector<uint64_t> checksums;
+		for (int generation = 0; generation <= result.generations + result.period; ++generation)
+		{
+			checksums.push_back(gridChecksum(grid));
+			if (generation == result.generations)
+			{
+				int population = 0;
+				for (int x = 0; x < point.rows; ++x)
+				{
+					for (int y = 0; y < point.cols; ++y)
+					{
+						population += grid.isAlive(x, y) ? 1 : 0;
+					}
+				}
+				assert(result.population == population);
+				assert(result.period > 1 || result.targetFound == findPattern(grid, getStillLifePatterns()));
+			}
+			UpdateCells(grid);
+		}
+		assert(checksums[result.generations] == checksums[result.generations + result.period]);
+		assert(result.generations == 0 || checksums[result.generations - 1] != checksums[result.generations - 1 + result.period]);
+	}
 
-	// Test Blinker
-	grid[1][1]->setAlive(true);
-	grid[1][2]->setAlive(true);
-	grid[1][3]->setAlive(true);
+	// A line cut short at the end of the file is left out
+	assert(saveSweepResults("test_sweep", RuleSpec(), 1, results));
+	ofstream partial("test_sweep_sweep.csv", ios::app);
+	partial << "12,70,250,6,3";
+	partial.close();
+	RuleSpec rule;
+	int patternChoice = 0;
+	vector<SweepResult> loaded;
+	assert(loadSweepResults("test_sweep", rule, patternChoice, loaded) && patternChoice == 1 && rule.toString() == "B3/S23");
+	assert(loaded.size() == results.size() && loaded.back().generations == results.back().generations && loaded.back().population == results.back().population);
+
+	// A field that is not a number is reported as damaged instead of being read
+	assert(saveSweepResults("test_sweep", RuleSpec(), 1, results));
+	partial.open("test_sweep_sweep.csv", ios::app);
+	partial << "12,70,250,6,3,x,0,2" << endl;
+	partial.close();
+	assert(!loadSweepResults("test_sweep", rule, patternChoice, loaded));
+	remove("test_sweep_sweep.csv");
+
+	cout << endl << "All tests passed for parameter sweep";
+}
 
-	bool foundBlinker = isBlinkerOrToad(grid);
-	assert(foundBlinker == true);
+// test to ensure a cached run gives back the same grid, summary and logged checksums, and that runs differing in any setting are cached apart. Outputs to console if successful.
+void test_resultCache()
+{
+	SimulationSettings settings;
+	ResultCache cache(".");
+	Grid<bool> grid(30, 70);
+	unsigned int seed = 5;
+	scatterCells(grid, 600, seed);
+	fastForward(grid, 40, settings);
+	string description = ResultCache::describe(30, 70, 5, 600, 40, settings);
+
+	CachedResult result;
+	Grid<bool> loaded;
+	assert(cache.lookup(description, result) == false && cache.loadGrid(description, loaded) == false);
+	assert(cache.store(description, grid, settings.getRule(), summarizeRun(grid, 600, 40)));
+	assert(cache.lookup(description, result) && result.checksum == gridChecksum(grid) && result.hasSnapshot);
+	assert(result.rows == 30 && result.cols == 70 && result.totalCells == 600 && result.endGeneration == 40 && result.settledAt == -1);
+	assert(cache.loadGrid(description, loaded) && loaded.getRows() == 30 && gridChecksum(loaded) == gridChecksum(grid));
+
+	// A replay is cached with the checksums it logged and the generation it settled at
+	Grid<bool> replayed(30, 70);
+	seed = 5;
+	scatterCells(replayed, 600, seed);
+	ReplayLog replay;
+	replay.record(0, gridChecksum(replayed));
+	for (int generation = 1; generation <= 40; ++generation)
+	{
+		UpdateCells(replayed);
+		replay.record(generation, gridChecksum(replayed));
+	}
+	replay.record(41, gridChecksum(replayed));
+	replay.record(42, gridChecksum(replayed));
+	string replayDescription = ResultCache::describeReplay(30, 70, 5, 600, 42, settings);
+	assert(replayDescription != ResultCache::describe(30, 70, 5, 600, 42, settings));
+	assert(cache.store(replayDescription, replayed, settings.getRule(), summarizeRun(replayed, 600, 42, &replay), &replay));
+	ReplayLog cachedReplay;
+	assert(cache.lookup(replayDescription, result, &cachedReplay) && cachedReplay.getChecksums() == replay.getChecksums());
+	assert(result.endGeneration == 42 && result.settledAt <= 40 && result.settledAt >= 0);
+	int compared;
+	assert(replay.firstMismatch(cachedReplay, compared) == -1 && compared == 43);
+	remove((cache.getEntryPath(replayDescription) + ".snap").c_str());
+	remove((cache.getEntryPath(replayDescription) + ".csv").c_str());
+
+	// Any change to the run gives another description, and a disabled cache never finds anything
+	SimulationSettings otherRule;
+	RuleSpec highLife;
+	parseRule("B36/S23", highLife);
+	otherRule.setRule(highLife);
+	SimulationSettings otherEngine;
+	otherEngine.setEngine(EngineType::MortonTiled);
+	assert(ResultCache::describe(30, 70, 5, 600, 41, settings) != description);
+	assert(cache.lookup(ResultCache::describe(30, 70, 5, 600, 40, otherRule), result) == false);
+	assert(cache.lookup(ResultCache::describe(30, 70, 5, 600, 40, otherEngine), result) == false);
+	assert(ResultCache("").lookup(description, result) == false && ResultCache("").store(description, grid, settings.getRule(), summarizeRun(grid, 600, 40)) == false);
+
+	// A snapshot that no longer matches its summary is not used
+	Grid<bool> changed = grid.clone();
+	changed.setAlive(0, 0, !changed.isAlive(0, 0));
+	assert(writeSnapshotFile(cache.getEntryPath(description) + ".snap", changed.view(), 0, settings.getRule()));
+	assert(cache.loadGrid(description, loaded) == false && gridChecksum(loaded) == gridChecksum(grid));
+	remove((cache.getEntryPath(description) + ".snap").c_str());
+	remove((cache.getEntryPath(description) + ".csv").c_str());
+
+	cout << endl << "All tests passed for result cache";
+}
 
-	grid[1][1]->setAlive(false);
-	grid[1][2]->setAlive(false);
-	grid[1][3]->setAlive(false);
+// test to ensure a rewound generation has exactly the cells it had when recorded, and that the history keeps to its budget. Outputs to console if successful.
+void test_generationHistory()
+{
+	// Byte runs survive a round trip, including lone zero bytes and words with only the top bit set
+	vector<uint64_t> words = { 0, 0, 5, uint64_t(1) << 63, 0, 0x0100000000000700ULL, 0x00ff00ff00ff00ffULL, 0, 0 };
+	vector<uint8_t> encoded;
+	encodeByteRuns(words.data(), words.size(), encoded);
+	vector<uint64_t> decoded(words.size(), 0);
+	xorByteRuns(encoded.data(), decoded.data(), decoded.size());
+	assert(decoded == words);
+
+	Grid<bool> grid(150, 300);
+	unsigned int seed = 21;
+	scatterCells(grid, 150 * 300 / 3, seed);
+	GenerationHistory history(size_t(1) << 30);
+	vector<uint64_t> checksums;
+	for (int generation = 0; generation <= 200; ++generation)
+	{
+		checksums.push_back(gridChecksum(grid));
+		history.record(generation, grid);
+		UpdateCells(grid);
+	}
+	assert(history.getOldest() == 0 && history.getNewest() == 200 && history.getKeyframes() == 4);
+	assert(history.getBytes() < size_t(201) * 150 * 5 * sizeof(uint64_t) * 3 / 4);
 
-	// Test Toad
+	Grid<bool> rewound;
+	for (int generation : { 0, 1, 63, 64, 65, 127, 150, 200, 199 })
+	{
+		assert(history.rewind(generation, rewound) && gridChecksum(rewound) == checksums[generation]);
+	}
+	assert(history.rewind(201, rewound) == false && history.rewind(-1, rewound) == false && gridChecksum(rewound) == checksums[199]);
+
+	// With only every fourth generation recorded, as with temporal blocking, the one before is found and stepped on to any generation in between
+	GenerationHistory blocked(size_t(1) << 30);
+	Grid<bool> blockedGrid(150, 300);
+	seed = 21;
+	scatterCells(blockedGrid, 150 * 300 / 3, seed);
+	for (int generation = 0; generation <= 200; generation += 4)
+	{
+		blocked.record(generation, blockedGrid);
+		advanceGenerations(blockedGrid, 4, RuleSpec(), 4);
+	}
+	for (int generation : { 0, 3, 4, 5, 127, 198, 200 })
+	{
+		int recorded = blocked.rewindBefore(generation, rewound);
+		assert(recorded == generation - generation % 4);
+		advanceGenerations(rewound, generation - recorded, RuleSpec(), 1);
+		assert(gridChecksum(rewound) == checksums[generation]);
+	}
+	assert(blocked.rewind(5, rewound) == false && blocked.rewindBefore(-1, rewound) == -1);
+
+	// A lone glider changes a few cells a generation, so its deltas are a few bytes each
+	Grid<bool> glider(150, 300);
+	GenerationHistory gliderHistory(size_t(1) << 30);
+	glider.setAlive(0, 1, true);
+	glider.setAlive(1, 2, true);
+	glider.setAlive(2, 0, true);
+	glider.setAlive(2, 1, true);
+	glider.setAlive(2, 2, true);
+	for (int generation = 0; generation <= 200; ++generation)
+	{
+		gliderHistory.record(generation, glider);
+		UpdateCells(glider);
+	}
+	assert(gliderHistory.getBytes() < size_t(201) * 150 * 5 * sizeof(uint64_t) / 100);
 
-	grid[0][1]->setAlive(true);
-	grid[0][2]->setAlive(true);
-	grid[1][3]->setAlive(true);
-	grid[2][0]->setAlive(true);
-	grid[3][1]->setAlive(true);
-	grid[3][2]->setAlive(true);
+	// A small budget drops the oldest whole frames first but always keeps the newest
+	GenerationHistory small(history.getBytes() / 3);
+	Grid<bool> replay(150, 300);
+	scatterCells(replay, 150 * 300 / 3, seed);
+	for (int generation = 0; generation <= 200; ++generation)
+	{
+		small.record(generation, replay);
+		UpdateCells(replay);
+	}
+	assert(small.getOldest() > 0 && small.getOldest() % HISTORY_KEYFRAME_INTERVAL == 0 && small.getNewest() == 200 && small.getBytes() <= history.getBytes() / 3);
+	assert(small.rewind(small.getOldest() - 1, rewound) == false);
+	assert(small.rewind(small.getOldest() + 5, rewound) && gridChecksum(rewound) == checksums[small.getOldest() + 5]);
 
-	bool foundToad = isBlinkerOrToad(grid);
-	assert(foundToad == true);
+	cout << endl << "All tests passed for generation history";
+}
 
-	grid[0][1]->setAlive(false);
-	grid[0][2]->setAlive(false);
-	grid[1][3]->setAlive(false);
-	grid[2][0]->setAlive(false);
-	grid[3][1]->setAlive(false);
-	grid[3][2]->setAlive(false);
+// test to ensure the screen left by the changed cells renderer always shows the viewport of the current generation, and that it writes
+// far less than full frames. Outputs to console if successful.
+void test_terminalRenderer()
+{
+	// Plays the renderer's output onto a screen, following the clear, cursor move and clear line sequences it writes
+	vector<string> screen;
+	size_t played = 0;
+	auto play = [&](const string& output)
+	{
+		int row = 0;
+		int col = 0;
+		for (size_t i = played; i < output.size(); ++i)
+		{
+			if (output[i] == '\x1b')
+			{
+				size_t end = output.find_first_of("HJK", i);
+				string arguments = output.substr(i + 2, end - i - 2);
+				if (output[end] == 'J')
+				{
+					screen.assign(60, string(200, ' '));
+				}
+				else if (output[end] == 'K')
+				{
+					screen[row].replace(col, string::npos, string(200 - col, ' '));
+				}
+				else
+				{
+					row = stoi(arguments.substr(0, arguments.find(';'))) - 1;
+					col = stoi(arguments.substr(arguments.find(';') + 1)) - 1;
+				}
+				i = end;
+				continue;
+			}
+			screen[row][col++] = output[i];
+		}
+		played = output.size();
+	};
+	auto expectedRow = [](const Grid<bool>& grid, int x, int left, int cols)
+	{
+		string row;
+		for (int y = left; y < left + cols; ++y)
+		{
+			row += string(".") + grid.getIcon(x, y);
+		}
+		return row + ".";
+	};
 
-	cout << endl << "All tests passed for isBlinkerOrToad()";
+	Grid<bool> grid(100, 300);
+	unsigned int seed = 8;
+	scatterCells(grid, 100 * 300 / 4, seed);
+	stringstream output;
+	TerminalRenderer renderer(output, 40, 250, 20, 60);
+	for (int generation = 0; generation < 30; ++generation)
+	{
+		if (generation == 20)
+		{
+			renderer.scrollTo(10, 5);
+		}
+		renderer.draw(grid.view(), generation);
+		play(output.str());
+		int top = renderer.getViewTop();
+		int left = renderer.getViewLeft();
+		assert(generation < 20 ? top == 40 && left == 240 : top == 10 && left == 5);
+		for (int x = 0; x < 20; ++x)
+		{
+			assert(screen[x].substr(0, 121) == expectedRow(grid, top + x, left, 60));
+		}
+		assert(screen[20].find("Generation " + to_string(generation) + ",") == 0);
+		UpdateCells(grid);
+	}
+	assert(renderer.getBytesWritten() < size_t(30) * 20 * 122 * 6 / 10);
+
+	// Once drawn, a glider costs a few cursor moves and cells a frame
+	Grid<bool> glider(100, 300);
+	glider.setAlive(40, 251, true);
+	glider.setAlive(41, 252, true);
+	glider.setAlive(42, 250, true);
+	glider.setAlive(42, 251, true);
+	glider.setAlive(42, 252, true);
+	stringstream gliderOutput;
+	TerminalRenderer gliderRenderer(gliderOutput, 30, 240, 20, 60);
+	gliderRenderer.draw(glider.view(), 0);
+	size_t firstFrame = gliderRenderer.getBytesWritten();
+	for (int generation = 1; generation <= 10; ++generation)
+	{
+		UpdateCells(glider);
+		gliderRenderer.draw(glider.view(), generation);
+	}
+	assert(gliderRenderer.getBytesWritten() - firstFrame < 10 * 150);
 
+	cout << endl << "All tests passed for terminal renderer";
 }
 
-// test to ensure isGliderOrLWSS functions as intended. Outputs to console if successful (LWSS impossiblely rare >>:( )
-template <typename T>
-void test_isGliderOrLWSS(Grid<T>& grid)
+// test to ensure the density overview counts every live cell of each block exactly once for sizes that do not divide evenly. Outputs to console if successful.
+void test_densityOverview()
 {
-	// Test empty
-
-	bool foundNothing = isGliderOrLWSS(grid);
-	assert(foundNothing == false);
-
-
-	// Test Glider
-	grid[2][1]->setAlive(true);
-	grid[3][2]->setAlive(true);
-	grid[1][3]->setAlive(true);
-	grid[2][3]->setAlive(true);
-	grid[3][3]->setAlive(true);
-
-	bool foundGlider = isGliderOrLWSS(grid);
-	assert(foundGlider == true);
+	int rows = 101;
+	int cols = 333;
+	int words = (cols + 63) / 64;
+	Grid<bool> grid(rows, cols);
+	unsigned int seed = 4;
+	scatterCells(grid, rows * cols / 5, seed);
+	vector<uint64_t> packed(static_cast<size_t>(rows) * words, 0);
+	for (int x = 0; x < rows; ++x)
+	{
+		for (int y = 0; y < cols; ++y)
+		{
+			packed[static_cast<size_t>(x) * words + y / 64] |= uint64_t(grid.isAlive(x, y)) << (y % 64);
+		}
+	}
 
-	grid[2][1]->setAlive(false);
-	grid[3][2]->setAlive(false);
-	grid[1][3]->setAlive(false);
-	grid[2][3]->setAlive(false);
-	grid[3][3]->setAlive(false);
+	for (auto size : { make_pair(7, 13), make_pair(1, 1), make_pair(101, 333), make_pair(20, 70) })
+	{
+		vector<uint32_t> counts;
+		densityCounts(packed.data(), words, rows, cols, size.first, size.second, counts);
+		uint64_t total = 0;
+		for (int blockRow = 0; blockRow < size.first; ++blockRow)
+		{
+			for (int blockCol = 0; blockCol < size.second; ++blockCol)
+			{
+				uint32_t expected = 0;
+				for (int x = blockRow * rows / size.first; x < (blockRow + 1) * rows / size.first; ++x)
+				{
+					for (int y = blockCol * cols / size.second; y < (blockCol + 1) * cols / size.second; ++y)
+					{
+						expected += grid.isAlive(x, y) ? 1 : 0;
+					}
+				}
+				assert(counts[static_cast<size_t>(blockRow) * size.second + blockCol] == expected);
+				total += expected;
+			}
+		}
+		assert(total == uint64_t(rows * cols / 5));
+	}
+	assert(densityShade(0, 100) == ' ' && densityShade(1, 100) == '.' && densityShade(100, 100) == '@');
 
-	// Test LWSS
+	// The overview fills the renderer's viewport and names the generation
+	stringstream output;
+	TerminalRenderer renderer(output, 0, 0, 10, 30);
+	drawDensityOverview(renderer, packed.data(), words, rows, cols, 12);
+	assert(output.str().find("Generation 12, overview of 101 x 333 in blocks of about 11 x 12") != string::npos);
 
-	grid[1][0]->setAlive(true);
-	grid[4][0]->setAlive(true);
-	grid[0][1]->setAlive(true);
-	grid[0][2]->setAlive(true);
-	grid[4][2]->setAlive(true);
-	grid[0][3]->setAlive(true);
-	grid[1][3]->setAlive(true);
-	grid[2][3]->setAlive(true);
-	grid[3][3]->setAlive(true);
+	cout << endl << "All tests passed for density overview";
+}
 
-	bool foundLWSS = isGliderOrLWSS(grid);
-	assert(foundLWSS == true);
+// test to ensure exported images hold the cropped cells at the chosen scale in each format and that the exporter writes every frame
+// the stride asks for. Outputs to console if successful.
+void test_frameExporter()
+{
+	int rows = 5;
+	int cols = 130;
+	int words = (cols + 63) / 64;
+	vector<uint64_t> cells(static_cast<size_t>(rows) * words, 0);
+	auto setCell = [&](int x, int y) { cells[static_cast<size_t>(x) * words + y / 64] |= uint64_t(1) << (y % 64); };
+	auto isSet = [&](int x, int y) { return ((cells[static_cast<size_t>(x) * words + y / 64] >> (y % 64)) & 1u) != 0; };
+	setCell(0, 0);
+	setCell(1, 63);
+	setCell(2, 64);
+	setCell(3, 129);
+	setCell(3, 70);
+
+	// PGM has a byte a pixel with live cells black
+	int scale = 2;
+	vector<uint8_t> image;
+	encodeImage(ImageFormat::PGM, cells.data(), rows, cols, words, scale, image);
+	string header = "P5\n260 10\n255\n";
+	assert(string(image.begin(), image.begin() + header.size()) == header);
+	assert(image.size() == header.size() + 260 * 10);
+	for (int pixelRow = 0; pixelRow < rows * scale; ++pixelRow)
+	{
+		for (int pixel = 0; pixel < cols * scale; ++pixel)
+		{
+			assert(image[header.size() + static_cast<size_t>(pixelRow) * 260 + pixel] == (isSet(pixelRow / scale, pixel / scale) ? 0 : 255));
+		}
+	}
 
-	grid[1][0]->setAlive(false);
-	grid[4][0]->setAlive(false);
-	grid[0][1]->setAlive(false);
-	grid[0][2]->setAlive(false);
-	grid[4][2]->setAlive(false);
-	grid[0][3]->setAlive(false);
-	grid[1][3]->setAlive(false);
-	grid[2][3]->setAlive(false);
-	grid[3][3]->setAlive(false);
+	// PBM has a bit a pixel with live cells set
+	encodeImage(ImageFormat::PBM, cells.data(), rows, cols, words, scale, image);
+	header = "P4\n260 10\n";
+	int rowBytes = (cols * scale + 7) / 8;
+	assert(image.size() == header.size() + static_cast<size_t>(rowBytes) * rows * scale);
+	for (int pixelRow = 0; pixelRow < rows * scale; ++pixelRow)
+	{
+		for (int pixel = 0; pixel < cols * scale; ++pixel)
+		{
+			bool bit = (image[header.size() + static_cast<size_t>(pixelRow) * rowBytes + pixel / 8] >> (7 - pixel % 8)) & 1u;
+			assert(bit == isSet(pixelRow / scale, pixel / scale));
+		}
+	}
 
-	// Test Rotated LWSS
-	grid[0][0]->setAlive(true);
-	grid[1][0]->setAlive(true);
-	grid[2][0]->setAlive(true);
-	grid[0][1]->setAlive(true);
-	grid[3][1]->setAlive(true);
-	grid[0][2]->setAlive(true);
-	grid[0][3]->setAlive(true);
-	grid[1][4]->setAlive(true);
-	grid[3][4]->setAlive(true);
+	// The PNG chunks have valid CRCs and the stored zlib stream holds the scanlines with live cells as 0
+	assert(crc32(reinterpret_cast<const uint8_t*>("IEND"), 4) == 0xAE426082u);
+	encodeImage(ImageFormat::PNG, cells.data(), rows, cols, words, scale, image);
+	auto readBigEndian = [&](size_t at) { return (uint32_t(image[at]) << 24) | (uint32_t(image[at + 1]) << 16) | (uint32_t(image[at + 2]) << 8) | image[at + 3]; };
+	assert(image[0] == 0x89 && image[1] == 'P' && image[2] == 'N' && image[3] == 'G');
+	vector<uint8_t> zlib;
+	vector<string> chunkTypes;
+	for (size_t at = 8; at < image.size();)
+	{
+		uint32_t length = readBigEndian(at);
+		chunkTypes.push_back(string(image.begin() + at + 4, image.begin() + at + 8));
+		assert(crc32(&image[at + 4], length + 4) == readBigEndian(at + 8 + length));
+		if (chunkTypes.back() == "IHDR")
+		{
+			assert(readBigEndian(at + 8) == 260 && readBigEndian(at + 12) == 10 && image[at + 16] == 1 && image[at + 17] == 0);
+		}
+		if (chunkTypes.back() == "IDAT")
+		{
+			zlib.insert(zlib.end(), image.begin() + at + 8, image.begin() + at + 8 + length);
+		}
+		at += 12 + length;
+	}
+	assert((chunkTypes == vector<string>{ "IHDR", "IDAT", "IEND" }));
+	vector<uint8_t> scanlines;
+	size_t at = 2;
+	bool last = false;
+	while (!last)
+	{
+		last = zlib[at] & 1u;
+		size_t blockBytes = zlib[at + 1] | (size_t(zlib[at + 2]) << 8);
+		assert(((blockBytes ^ (zlib[at + 3] | (size_t(zlib[at + 4]) << 8))) & 0xffff) == 0xffff);
+		scanlines.insert(scanlines.end(), zlib.begin() + at + 5, zlib.begin() + at + 5 + blockBytes);
+		at += 5 + blockBytes;
+	}
+	assert(at + 4 == zlib.size());
+	assert(scanlines.size() == static_cast<size_t>(rowBytes + 1) * rows * scale);
+	for (int pixelRow = 0; pixelRow < rows * scale; ++pixelRow)
+	{
+		assert(scanlines[static_cast<size_t>(pixelRow) * (rowBytes + 1)] == 0);
+		for (int pixel = 0; pixel < cols * scale; ++pixel)
+		{
+			bool bit = (scanlines[static_cast<size_t>(pixelRow) * (rowBytes + 1) + 1 + pixel / 8] >> (7 - pixel % 8)) & 1u;
+			assert(bit != isSet(pixelRow / scale, pixel / scale));
+		}
+	}
 
-	bool foundRotatedLWSS = isGliderOrLWSS(grid);
-	assert(foundRotatedLWSS == true);
+	// A crop across a word boundary is written for every other generation, and every frame is either written or counted as dropped
+	ExportSettings exportSettings;
+	exportSettings.prefix = "test_frame_export";
+	exportSettings.format = ImageFormat::PBM;
+	exportSettings.stride = 2;
+	exportSettings.cropTop = 1;
+	exportSettings.cropLeft = 60;
+	exportSettings.cropRows = 3;
+	exportSettings.cropCols = 12;
+	int frames = 0;
+	size_t written;
+	{
+		FrameExporter exporter(exportSettings);
+		for (int generation = 0; generation < 40; ++generation)
+		{
+			if (exporter.wants(generation))
+			{
+				exporter.push(cells.data(), words, rows, cols, generation);
+				frames++;
+			}
+		}
+		exporter.finish();
+		written = exporter.getWritten();
+		assert(written + exporter.getDropped() == size_t(frames));
+		assert(written >= 1);
+	}
+	assert(frames == 20);
+
+	// The crop holds (1, 63), (2, 64) and (3, 70) as its cells (0, 3), (1, 4) and (2, 10)
+	vector<uint64_t> expected(3, 0);
+	expected[0] = uint64_t(1) << 3;
+	expected[1] = uint64_t(1) << 4;
+	expected[2] = uint64_t(1) << 10;
+	vector<uint8_t> expectedImage;
+	encodeImage(ImageFormat::PBM, expected.data(), 3, 12, 1, 1, expectedImage);
+	size_t found = 0;
+	for (int generation = 0; generation < 40; ++generation)
+	{
+		stringstream filename;
+		filename << "test_frame_export_" << setw(6) << setfill('0') << generation << ".pbm";
+		ifstream imageFile(filename.str(), ios::binary);
+		if (imageFile)
+		{
+			assert(generation % 2 == 0);
+			vector<uint8_t> contents((istreambuf_iterator<char>(imageFile)), istreambuf_iterator<char>());
+			assert(contents == expectedImage);
+			imageFile.close();
+			remove(filename.str().c_str());
+			found++;
+		}
+	}
+	assert(found == written);
 
-	grid[0][0]->setAlive(false);
-	grid[1][0]->setAlive(false);
-	grid[2][0]->setAlive(false);
-	grid[0][1]->setAlive(false);
-	grid[3][1]->setAlive(false);
-	grid[0][2]->setAlive(false);
-	grid[0][3]->setAlive(false);
-	grid[1][4]->setAlive(false);
-	grid[3][4]->setAlive(false);
+	cout << endl << "All tests passed for frame exporter";
+}
 
-	cout << endl << "All tests passed for isGliderOrLWSS()";
+// test to ensure the census names objects in any orientation and phase, and that a census carried on from a save matches one run in one go. Outputs to console if successful.
+void test_soupCensus()
+{
+	// A block, a blinker, a toad in its other phase and a rotated boat, far enough apart to be separate objects
+	int rows = 20;
+	int cols = 70;
+	int words = (cols + 63) / 64;
+	vector<uint64_t> cells(static_cast<size_t>(rows) * words, 0);
+	auto setCell = [&](int x, int y) { cells[static_cast<size_t>(x) * words + y / 64] |= uint64_t(1) << (y % 64); };
+	int block[4][2] = { { 1, 1 }, { 1, 2 }, { 2, 1 }, { 2, 2 } };
+	int blinker[3][2] = { { 1, 10 }, { 2, 10 }, { 3, 10 } };
+	int toad[6][2] = { { 10, 3 }, { 11, 1 }, { 11, 4 }, { 12, 1 }, { 12, 4 }, { 13, 2 } };
+	int boat[5][2] = { { 10, 63 }, { 11, 62 }, { 11, 64 }, { 12, 63 }, { 12, 64 } };
+	for (auto& cell : block) { setCell(cell[0], cell[1]); }
+	for (auto& cell : blinker) { setCell(cell[0], cell[1]); }
+	for (auto& cell : toad) { setCell(cell[0], cell[1]); }
+	for (auto& cell : boat) { setCell(cell[0], cell[1]); }
+
+	vector<string> keys;
+	takeCensus(cells, rows, cols, words, ConwayRule(), keys);
+	vector<string> names;
+	for (const string& key : keys)
+	{
+		names.push_back(objectName(key, RuleSpec()));
+	}
+	sort(names.begin(), names.end());
+	assert((names == vector<string>{ "Blinker", "Block", "Boat", "Toad" }));
+
+	// Cells two apart share a dead neighbour, so they are one object
+	keys.clear();
+	fill(cells.begin(), cells.end(), 0);
+	for (auto& cell : block) { setCell(cell[0], cell[1]); setCell(cell[0], cell[1] + 3); }
+	takeCensus(cells, rows, cols, words, ConwayRule(), keys);
+	assert(keys.size() == 1 && objectName(keys[0], RuleSpec()) != "Block");
+
+	// A census stopped part way and carried on from its save gives the same counts as one run straight through
+	SoupCensus straight(16, 16, 100, 77, RuleSpec());
+	SoupCensus resumed(16, 16, 100, 77, RuleSpec());
+	int checkpoints = 0;
+	assert(runSoupCensus(straight, 3 * CENSUS_BATCH / 2, [](const SoupCensus&) { return true; }, false));
+	assert(runSoupCensus(resumed, CENSUS_BATCH / 2, [&](const SoupCensus& progress) { ++checkpoints; return saveCensus("test_census", progress); }, false));
+	SoupCensus loaded;
+	assert(loadCensus("test_census", loaded) && loaded.getSoups() == CENSUS_BATCH / 2 && loaded.getSeed() == 77);
+	assert(runSoupCensus(loaded, 3 * CENSUS_BATCH / 2, [](const SoupCensus&) { return true; }, false));
+	assert(checkpoints == 1 && loaded.getCounts() == straight.getCounts() && loaded.getSoups() == straight.getSoups());
+	assert(straight.getCounts().count(objectKey(CensusShape{ 2, 2, { 3, 3 } }, ConwayRule())) == 1);
+
+	// Test a census with a field that is not a number is reported as damaged instead of being read
+	ofstream damagedFile("test_census_census.csv");
+	damagedFile << "16,16,100,77,B3/S23,12x" << endl;
+	damagedFile.close();
+	assert(!loadCensus("test_census", loaded));
+	damagedFile.open("test_census_census.csv");
+	damagedFile << "16,16,100,77,B3/S23,12" << endl << "block,many" << endl;
+	damagedFile.close();
+	assert(!loadCensus("test_census", loaded));
+	remove("test_census_census.csv");
+
+	cout << endl << "All tests passed for soup census";
 }
 
 // INPUT FUNCTIONS
@@ -1452,6 +9020,35 @@ int cycleInput()
 	return totalCycles;
 }
 
+// function to get a range for a sweep - created to help other functions. Returns false if the range is not valid.
+bool rangeInput(const string& name, SweepRange& range)
+{
+	cout << endl << "Enter the smallest " << name << ": ";
+	cin >> range.first;
+	if (!isValidInput(range.first))
+	{
+		return false;
+	}
+	cout << endl << "Enter the largest " << name << ": ";
+	cin >> range.last;
+	if (!isValidInput(range.last))
+	{
+		return false;
+	}
+	cout << endl << "Enter the step between each " << name << ": ";
+	cin >> range.step;
+	if (!isValidInput(range.step))
+	{
+		return false;
+	}
+	if (range.last < range.first)
+	{
+		cout << endl << "Error: The largest " << name << " is smaller than the smallest.";
+		return false;
+	}
+	return true;
+}
+
 // function to get number of cells - created to help other functions
 int cellInput()
 {
@@ -1470,108 +9067,409 @@ int cellInput()
 	return numCells;
 }
 
+// function to get the generation to jump to
+int generationInput()
+{
+	bool allowedInput = false;
+	int generation;
+	while (!allowedInput)
+	{
+		cout << endl << "Enter the generation to jump to: ";
+		cin >> generation;
+
+		if (isValidInput(generation))
+		{
+			allowedInput = true;
+		}
+	}
+	return generation;
+}
+
 // MENU FUNCTIONS
 
-// displays the options for loading
-int menu_displayLoadMenu()
+// displays the options for loading
+int menu_displayLoadMenu()
+{
+	bool choosing = true;
+	int choice;
+
+	while (choosing)
+	{
+		cout << endl << "|| 1. (.txt) Continue previous grid";
+		cout << endl << "|| 2. (.csv) Repeat previous simulation";
+		cout << endl << "|| 3. (.csv) Jump to a generation of a previous simulation";
+		cout << endl << "|| 4. (.snap) Advance a snapshot on disk";
+		cout << endl << "|| 5. (.snap) Continue a snapshot in memory";
+		cout << endl << "|| Select the file type you would like to load: ";
+		cin >> choice;
+
+		switch (choice)
+		{
+		case 1:
+			choosing = false;
+			return choice;
+		case 2:
+			choosing = false;
+			return choice;
+		case 3:
+			choosing = false;
+			return choice;
+		case 4:
+			choosing = false;
+			return choice;
+		case 5:
+			choosing = false;
+			return choice;
+		default:
+			cout << "Error: Invalid Option. Please try again.";
+		}
+	}
+}
+
+// lets the user look back at earlier generations of a finished run. The grid is put back to the newest generation afterwards,
+// so saving still saves the end of the run. Generations inside a pass of temporal blocking were never drawn or recorded,
+// so they are stepped on from the drawn generation before them with the run's rule.
+template <typename T>
+void menu_rewindSimulation(Grid<T>& grid, const GenerationHistory& history, const RuleSpec& rule)
+{
+	while (!history.empty())
+	{
+		int choice;
+		cout << endl << "|| 1. Rewind to an earlier generation (kept: " << history.getOldest() << " to " << history.getNewest() << ")";
+		cout << endl << "|| 2. Continue";
+		cout << endl << "|| Select an option: ";
+		cin >> choice;
+
+		if (choice == 1)
+		{
+			int generation;
+			cout << endl << "Enter the generation to show: ";
+			cin >> generation;
+			if (cin.fail() || generation > history.getNewest())
+			{
+				cout << endl << "Error: The run did not reach that generation. Please try again.";
+				cin >> ClearAndIgnore();
+			}
+			else if (generation < history.getOldest())
+			{
+				cout << endl << "Error: That generation was dropped to keep within the rewind history budget. Please try again.";
+				cin >> ClearAndIgnore();
+			}
+			else
+			{
+				int recorded = history.rewindBefore(generation, grid);
+				if (recorded < generation)
+				{
+					advanceGenerations(grid, generation - recorded, rule, 1);
+				}
+				cout << grid;
+				cout << endl << "Showing generation " << generation << ".";
+			}
+		}
+		else if (choice == 2)
+		{
+			history.rewind(history.getNewest(), grid);
+			return;
+		}
+		else
+		{
+			cout << endl << "Error: Invalid Option. Please try again.";
+			cin >> ClearAndIgnore();
+		}
+	}
+}
+
+// runs the algorithm for creating a new simulation
+template <typename T>
+void menu_createNewSimulation(Grid<T> &grid, const SimulationSettings& settings)
+{
+	grid = generateGrid<bool>(nullptr, nullptr);
+	random_device rd; // Generate new seed
+	unsigned int seed = rd();
+	int totalCells = cellInput();
+	int totalCycles = cycleInput();
+
+	ReplayLog log;
+	GenerationHistory history(static_cast<size_t>(settings.getHistoryBudget()) << 20);
+
+	createCells(grid);
+	scatterCells(grid, totalCells, seed);
+	runSimulation(grid, totalCycles, settings, nullptr, nullptr, &log, &history);
+	menu_rewindSimulation(grid, history, settings.getRule());
+	calculateERN(grid.view(), totalCells, nullptr);
+	menu_displaySaveMenu(grid.view(), seed, totalCycles, totalCells, &log, settings.getRule());
+}
+
+// runs the algorithm for loading a grid from storage
+template <typename T>
+void menu_loadGridFromStorage(Grid<T>& grid, const SimulationSettings& settings)
+{
+	if (loadGridSimulation(grid))
+	{
+		int totalCycles = cycleInput();
+		GenerationHistory history(static_cast<size_t>(settings.getHistoryBudget()) << 20);
+		runSimulation(grid, totalCycles, settings, nullptr, nullptr, nullptr, &history);
+		cout << grid;
+		menu_rewindSimulation(grid, history, settings.getRule());
+		menu_displaySaveMenuNoParams(grid.view(), settings.getRule());
+	}
+}
+
+// runs the algorithm for loading params from storage
+template <typename T>
+void menu_loadCSVFromStorage(Grid<T>& grid, const SimulationSettings& settings)
+{
+	string filename;
+	CSVData loadedParams = LoadParamSimulation(&filename);
+
+	int xSpaces = loadedParams.getXSpaces();
+	int ySpaces = loadedParams.getYSpaces();
+	unsigned int seed = loadedParams.getSeed();
+	int totalCells = loadedParams.getTotalCells();
+	int totalCycles = loadedParams.getTotalCycles();
+	int scatterVersion = loadedParams.getScatterVersion();
+	ReplayLog replay;
+	GenerationHistory history(static_cast<size_t>(settings.getHistoryBudget()) << 20);
+
+	grid = generateGrid<bool>(&xSpaces, &ySpaces);
+
+	// A run that was replayed before is read from the result cache, with the checksums it logged, instead of being stepped again
+	ResultCache cache(settings.getCacheDirectory());
+	string description = ResultCache::describeReplay(xSpaces, ySpaces, seed, totalCells, totalCycles, settings, scatterVersion);
+	CachedResult result;
+	if (cache.lookup(description, result, &replay) && cache.loadGrid(description, grid))
+	{
+		cout << grid;
+		cout << endl << "Loaded the replay from the result cache.";
+	}
+	else
+	{
+		replay.clear();
+		createCells(grid);
+		scatterCells(grid, totalCells, seed, scatterVersion);
+		runSimulation(grid, totalCycles, settings, nullptr, nullptr, &replay, &history);
+		result = summarizeRun(grid, totalCells, replay.empty() ? totalCycles : replay.getChecksums().rbegin()->first, &replay);
+		cache.store(description, grid, settings.getRule(), result, &replay);
+		menu_rewindSimulation(grid, history, settings.getRule());
+	}
+	displayRunSummary(result);
+
+	// Check the replay against the checksums saved with the run
+	ReplayLog saved;
+	if (loadReplayLog(filename, saved))
+	{
+		displayReplayCheck(saved, replay);
+	}
+
+	calculateERN(grid.view(), result.totalCells, nullptr);
+	menu_displaySaveMenu(grid.view(), seed, totalCycles, totalCells, &replay, settings.getRule(), scatterVersion);
+}
+
+// jumps a simulation loaded from a .csv file to a chosen generation without drawing the frames in between
+template <typename T>
+void menu_fastForwardCSVFromStorage(Grid<T>& grid, const SimulationSettings& settings)
+{
+	string filename;
+	CSVData loadedParams = LoadParamSimulation(&filename);
+
+	int xSpaces = loadedParams.getXSpaces();
+	int ySpaces = loadedParams.getYSpaces();
+	unsigned int seed = loadedParams.getSeed();
+	int totalCells = loadedParams.getTotalCells();
+	int scatterVersion = loadedParams.getScatterVersion();
+	int generation = generationInput();
+
+	grid = generateGrid<bool>(&xSpaces, &ySpaces);
+
+	// A run that was jumped to before is read from the result cache instead of being stepped again
+	ResultCache cache(settings.getCacheDirectory());
+	string description = ResultCache::describe(xSpaces, ySpaces, seed, totalCells, generation, settings, scatterVersion);
+	if (cache.loadGrid(description, grid))
+	{
+		cout << endl << "Loaded generation " << generation << " from the result cache.";
+	}
+	else
+	{
+		createCells(grid);
+		scatterCells(grid, totalCells, seed, scatterVersion);
+		fastForward(grid, generation, settings);
+		cache.store(description, grid, settings.getRule(), summarizeRun(grid, totalCells, generation));
+	}
+	cout << grid;
+
+	uint64_t checksum = gridChecksum(grid);
+	cout << endl << "Checksum at generation " << generation << ": " << hex << checksum << dec;
+
+	ReplayLog saved;
+	uint64_t savedChecksum;
+	if (loadReplayLog(filename, saved) && saved.getChecksum(generation, savedChecksum))
+	{
+		if (savedChecksum == checksum)
+		{
+			cout << endl << "Matches the saved run.";
+		}
+		else
+		{
+			cout << endl << "Error: Does not match the saved run (" << hex << savedChecksum << dec << ").";
+		}
+	}
+	menu_displaySaveMenuNoParams(grid.view(), settings.getRule());
+}
+
+// advances a .snap file in place without loading it into memory, so it can be larger than the memory of the machine.
+// Offers to create a random one on disk if the file does not exist.
+void menu_advanceSnapshotOnDisk(const SimulationSettings& settings)
 {
-	bool choosing = true;
-	int choice;
+	string filename;
+	cout << endl << "Enter file name to advance: ";
+	cin >> filename;
 
-	while (choosing)
+	MappedFile snapshotFile;
+	if (!snapshotFile.open(filename + ".snap"))
 	{
-		cout << endl << "|| 1. (.txt) Continue previous grid";
-		cout << endl << "|| 2. (.csv) Repeat previous simulation";
-		cout << endl << "|| Select the file type you would like to load: ";
+		int choice;
+		cout << endl << "No snapshot called " << filename << ".snap was found.";
+		cout << endl << "|| 1. Create a random snapshot on disk";
+		cout << endl << "|| 2. Back";
+		cout << endl << "|| Select an option: ";
 		cin >> choice;
+		if (choice != 1)
+		{
+			cin >> ClearAndIgnore();
+			return;
+		}
 
-		switch (choice)
+		int rows;
+		int cols;
+		cout << endl << "Enter number of spaces on the X Axis: ";
+		cin >> rows;
+		if (!isValidInput(rows))
 		{
-		case 1:
-			choosing = false;
-			return choice;
-		case 2:
-			choosing = false;
-			return choice;
-		default:
-			cout << "Error: Invalid Option. Please try again.";
+			return;
+		}
+		cout << endl << "Enter number of spaces on the Y Axis: ";
+		cin >> cols;
+		if (!isValidInput(cols))
+		{
+			return;
+		}
+		int totalCells = cellInput();
+		random_device rd;
+		if (!createSnapshotFile(filename + ".snap", rows, cols, totalCells, rd(), settings.getRule()) || !snapshotFile.open(filename + ".snap"))
+		{
+			return;
 		}
 	}
-}
+	if (!checkSnapshotHeader(*reinterpret_cast<const SnapshotHeader*>(snapshotFile.getData()), snapshotFile.getBytes()))
+	{
+		return;
+	}
 
-// runs the algorithm for creating a new simulation
-template <typename T>
-void menu_createNewSimulation(Grid<T> &grid)
-{
-	grid = generateGrid<bool>(nullptr, nullptr);
-	random_device rd; // Generate new seed
-	unsigned int seed = rd();
-	int totalCells = cellInput();
 	int totalCycles = cycleInput();
+	unique_ptr<TerminalRenderer> renderer;
+	unique_ptr<FrameExporter> exporter;
+	if (settings.getDisplay() == DisplayType::DensityOverview)
+	{
+		renderer = unique_ptr<TerminalRenderer>(new TerminalRenderer(cout));
+	}
+	if (!settings.getExport().prefix.empty())
+	{
+		exporter = unique_ptr<FrameExporter>(new FrameExporter(settings.getExport()));
+	}
+	if (renderer || exporter)
+	{
+		// Draws the overview and exports frames straight from the mapped rows after every wavefront pass
+		auto showFrame = [&]()
+		{
+			const SnapshotHeader& header = *reinterpret_cast<const SnapshotHeader*>(snapshotFile.getData());
+			const uint64_t* cells = reinterpret_cast<const uint64_t*>(snapshotFile.getData() + sizeof(SnapshotHeader));
+			size_t words = static_cast<size_t>((header.cols + 63) / 64);
+			if (renderer)
+			{
+				drawDensityOverview(*renderer, cells, words, static_cast<int64_t>(header.rows), static_cast<int>(header.cols), static_cast<int64_t>(header.generation));
+			}
+			if (exporter && exporter->wants(static_cast<int64_t>(header.generation)))
+			{
+				exporter->push(cells, words, static_cast<int64_t>(header.rows), static_cast<int>(header.cols), static_cast<int64_t>(header.generation));
+			}
+		};
+		for (int done = 0; done < totalCycles; done += WAVEFRONT_DEPTH)
+		{
+			showFrame();
+			advanceMappedSnapshot(snapshotFile, min(WAVEFRONT_DEPTH, totalCycles - done));
+		}
+		showFrame();
+		if (renderer)
+		{
+			renderer->finish();
+		}
+		if (exporter)
+		{
+			exporter->finish();
+			cout << endl << exporter->getWritten() << " frames exported, " << exporter->getDropped() << " dropped.";
+		}
+	}
+	else
+	{
+		advanceMappedSnapshot(snapshotFile, totalCycles);
+	}
 
-	createCells(grid);
-	scatterCells(grid, totalCells, seed);
-	runSimulation(grid, totalCycles);
-	calculateERN(grid, totalCells, nullptr);
-	menu_displaySaveMenu(grid, seed, totalCycles, totalCells);
+	const SnapshotHeader& header = *reinterpret_cast<const SnapshotHeader*>(snapshotFile.getData());
+	cout << endl << filename << ".snap (" << header.rows << " x " << header.cols << ", " << RuleSpec(header.birth, header.survival).toString()
+		<< ") is now at generation " << header.generation << ".";
 }
 
-// runs the algorithm for loading a grid from storage
+// runs the algorithm for loading a snapshot into memory and continuing it
 template <typename T>
-void menu_loadGridFromStorage(Grid<T>& grid)
+void menu_loadSnapshotFromStorage(Grid<T>& grid, const SimulationSettings& settings)
 {
-	if (loadGridSimulation(grid))
+	RuleSpec rule;
+	uint64_t generation;
+	if (loadSnapshot(grid, &rule, &generation))
 	{
+		cout << endl << "Loaded generation " << generation << " (" << rule.toString() << ").";
+		SimulationSettings snapshotSettings = settings;
+		snapshotSettings.setRule(rule);
 		int totalCycles = cycleInput();
-		runSimulation(grid, totalCycles);
+		GenerationHistory history(static_cast<size_t>(settings.getHistoryBudget()) << 20);
+		runSimulation(grid, totalCycles, snapshotSettings, nullptr, nullptr, nullptr, &history);
 		cout << grid;
-		menu_displaySaveMenuNoParams(grid);
+		menu_rewindSimulation(grid, history, rule);
+		menu_displaySaveMenuNoParams(grid.view(), rule);
 	}
 }
 
-// runs the algorithm for loading params from storage
-template <typename T>
-void menu_loadCSVFromStorage(Grid<T>& grid)
-{
-	CSVData loadedParams = LoadParamSimulation();
-
-	int xSpaces = loadedParams.getXSpaces();
-	int ySpaces = loadedParams.getYSpaces();
-	unsigned int seed = loadedParams.getSeed();
-	int totalCells = loadedParams.getTotalCells();
-	int totalCycles = loadedParams.getTotalCycles();
-
-	grid = generateGrid<bool>(&xSpaces, &ySpaces);
-
-	createCells(grid);
-	scatterCells(grid, totalCells, seed);
-	runSimulation(grid, totalCycles);
-	calculateERN(grid, totalCells, nullptr);
-	menu_displaySaveMenu(grid, seed, totalCells, totalCycles);
-}
-
 // chooses which load method to use 
 template <typename T>
-void menu_loadFromStorage(Grid<T>& grid)
+void menu_loadFromStorage(Grid<T>& grid, const SimulationSettings& settings)
 {
 	int choice = menu_displayLoadMenu();
 	switch (choice)
 	{
 		case 1:
-			menu_loadGridFromStorage(grid);
+			menu_loadGridFromStorage(grid, settings);
 			break;
 		case 2:
-			menu_loadCSVFromStorage(grid);
+			menu_loadCSVFromStorage(grid, settings);
+			break;
+		case 3:
+			menu_fastForwardCSVFromStorage(grid, settings);
+			break;
+		case 4:
+			menu_advanceSnapshotOnDisk(settings);
+			break;
+		case 5:
+			menu_loadSnapshotFromStorage(grid, settings);
 			break;
 	}
 }
 
 // runs the algorithm for creating an experiment
 template <typename T>
-void menu_runExperiment(Grid<T>& grid)
+void menu_runExperiment(Grid<T>& grid, const SimulationSettings& settings)
 {
 	grid = generateGrid<bool>(nullptr, nullptr);
-	runExperiment(grid);
+	runExperiment(grid, settings);
 }
 
 // runs the pattern tests
@@ -1585,17 +9483,414 @@ void menu_runPatternTests(Grid<T>& grid)
 	test_isBlockOrBeehive(grid);
 	test_isBlinkerOrToad(grid);
 	test_isGliderOrLWSS(grid);
+	test_rules(grid);
+	test_cellPolicies();
+	test_scheduler();
+	test_temporalBlocking();
+	test_mortonEngine();
+	test_parallelPatternScan();
+	test_incrementalDetection();
+	test_activityMap();
+	test_bitboardMatcher();
+	test_scatterCells();
+	test_deterministicReplay();
+	test_distributedEngine();
+	test_outOfCoreEngine();
+	test_sparseTileEngine();
+	test_reusableBuffers();
+	test_gridOwnership();
+	test_soupSearch();
+	test_soupCensus();
+	test_spaceshipTracker();
+	test_parameterSweep();
+	test_resultCache();
+	test_generationHistory();
+	test_terminalRenderer();
+	test_densityOverview();
+	test_frameExporter();
+}
+
+// asks how many worker processes the distributed engine uses and how they pass rows to each other
+void menu_displayDistributedMenu(SimulationSettings& settings)
+{
+	int workers;
+	int transportChoice;
+	cout << endl << "Enter the number of worker processes: ";
+	cin >> workers;
+	if (!isValidInput(workers))
+	{
+		return;
+	}
+
+	cout << endl << "|| 1. Shared memory";
+	cout << endl << "|| 2. Unix domain sockets";
+	cout << endl << "|| Select how workers exchange boundary rows: ";
+	cin >> transportChoice;
+	if (transportChoice != 1 && transportChoice != 2)
+	{
+		cout << endl << "Error: Invalid Option. Please try again.";
+		cin >> ClearAndIgnore();
+		return;
+	}
+
+	settings.setEngine(EngineType::Distributed);
+	settings.setWorkers(workers);
+	settings.setTransport(transportChoice == 2 ? TransportType::UnixSocket : TransportType::SharedMemory);
+}
+
+// asks which frames of each run to export as images and where to write them
+void menu_displayExportMenu(SimulationSettings& settings)
+{
+	ExportSettings exportSettings;
+	int formatChoice;
+	cout << endl << "Enter the file name prefix for exported frames, or - to turn exporting off: ";
+	cin >> exportSettings.prefix;
+	if (exportSettings.prefix == "-")
+	{
+		settings.setExport(ExportSettings());
+		return;
+	}
+
+	cout << endl << "|| 1. PBM, one bit per pixel";
+	cout << endl << "|| 2. PGM, one byte per pixel";
+	cout << endl << "|| 3. PNG";
+	cout << endl << "|| Select an image format: ";
+	cin >> formatChoice;
+	if (formatChoice < 1 || formatChoice > 3)
+	{
+		cout << endl << "Error: Invalid Option. Please try again.";
+		cin >> ClearAndIgnore();
+		return;
+	}
+	exportSettings.format = formatChoice == 1 ? ImageFormat::PBM : formatChoice == 2 ? ImageFormat::PGM : ImageFormat::PNG;
+
+	cout << endl << "Enter the pixels per cell: ";
+	cin >> exportSettings.scale;
+	if (!isValidInput(exportSettings.scale))
+	{
+		return;
+	}
+	cout << endl << "Enter the generations between exported frames: ";
+	cin >> exportSettings.stride;
+	if (!isValidInput(exportSettings.stride))
+	{
+		return;
+	}
+	cout << endl << "Enter the top row, left column, rows and columns to crop to (0 rows or columns for the rest of the grid): ";
+	cin >> exportSettings.cropTop >> exportSettings.cropLeft >> exportSettings.cropRows >> exportSettings.cropCols;
+	if (cin.fail() || exportSettings.cropTop < 0 || exportSettings.cropLeft < 0 || exportSettings.cropRows < 0 || exportSettings.cropCols < 0)
+	{
+		cout << endl << "Error: Invalid Input. Please try again.";
+		cin >> ClearAndIgnore();
+		return;
+	}
+	settings.setExport(exportSettings);
+}
+
+// displays the settings menu and lets the user change the rule
+void menu_displaySettingsMenu(SimulationSettings& settings)
+{
+	bool choosing = true;
+	int choice;
+
+	while (choosing)
+	{
+		cout << endl << "|| 1. Change rule (current: " << settings.getRule().toString() << ")";
+		cout << endl << "|| 2. Change generations per pass (current: " << settings.getBlockDepth() << ")";
+		cout << endl << "|| 3. Change engine (current: " << engineName(settings.getEngine()) << ")";
+		cout << endl << "|| 4. Change result cache folder (current: " << (settings.getCacheDirectory().empty() ? "off" : settings.getCacheDirectory()) << ")";
+		cout << endl << "|| 5. Change rewind history budget (current: " << settings.getHistoryBudget() << " MiB)";
+		cout << endl << "|| 6. Change display (current: " << (settings.getDisplay() == DisplayType::FullFrames ? string("Full frames")
+			: settings.getDisplay() == DisplayType::DensityOverview ? string("Density overview")
+			: "Changed cells only from row " + to_string(settings.getViewTop()) + ", column " + to_string(settings.getViewLeft())) << ")";
+		cout << endl << "|| 7. Change frame export (current: " << (settings.getExport().prefix.empty() ? string("off") : settings.getExport().prefix) << ")";
+		cout << endl << "|| 8. Back";
+		cout << endl << "|| Select an option: ";
+		cin >> choice;
+
+		switch (choice)
+		{
+		case 1:
+		{
+			string ruleText;
+			RuleSpec rule;
+			cout << endl << "Enter a rule in B/S notation (e.g. B3/S23, B36/S23, B3678/S34678, B2/S): ";
+			cin >> ruleText;
+			if (parseRule(ruleText, rule))
+			{
+				settings.setRule(rule);
+				cout << endl << "Rule set to " << rule.toString();
+			}
+			else
+			{
+				cout << endl << "Error: Invalid rule. Please try again.";
+				cin >> ClearAndIgnore();
+			}
+			break;
+		}
+		case 2:
+		{
+			int depth;
+			cout << endl << "Enter generations to advance per pass, 1 to draw every generation (max " << MAX_BLOCK_DEPTH << "): ";
+			cin >> depth;
+			if (isValidInput(depth) && depth <= MAX_BLOCK_DEPTH)
+			{
+				settings.setBlockDepth(depth);
+			}
+			else
+			{
+				cout << endl << "Error: Invalid Input. Please try again.";
+				cin >> ClearAndIgnore();
+			}
+			break;
+		}
+		case 3:
+		{
+			int engineChoice;
+			cout << endl << "|| 1. " << engineName(EngineType::Standard);
+			cout << endl << "|| 2. " << engineName(EngineType::MortonTiled);
+			cout << endl << "|| 3. " << engineName(EngineType::Distributed);
+			cout << endl << "|| 4. " << engineName(EngineType::OutOfCore);
+			cout << endl << "|| 5. " << engineName(EngineType::SparseTiles);
+			cout << endl << "|| Select an engine: ";
+			cin >> engineChoice;
+			if (engineChoice == 1)
+			{
+				settings.setEngine(EngineType::Standard);
+			}
+			else if (engineChoice == 2)
+			{
+				settings.setEngine(EngineType::MortonTiled);
+			}
+			else if (engineChoice == 3)
+			{
+				menu_displayDistributedMenu(settings);
+			}
+			else if (engineChoice == 4)
+			{
+				string backingFile;
+				cout << endl << "Enter the backing file to keep the cells in (current: " << settings.getBackingFile() << "): ";
+				cin >> backingFile;
+				settings.setEngine(EngineType::OutOfCore);
+				settings.setBackingFile(backingFile);
+			}
+			else if (engineChoice == 5)
+			{
+				settings.setEngine(EngineType::SparseTiles);
+			}
+			else
+			{
+				cout << endl << "Error: Invalid Option. Please try again.";
+				cin >> ClearAndIgnore();
+			}
+			break;
+		}
+		case 4:
+		{
+			string directory;
+			cout << endl << "Enter the folder to cache finished runs in, or - to turn the cache off: ";
+			cin >> directory;
+			settings.setCacheDirectory(directory == "-" ? "" : directory);
+			break;
+		}
+		case 5:
+		{
+			int budget;
+			cout << endl << "Enter the memory a run's rewind history may use in MiB: ";
+			cin >> budget;
+			if (isValidInput(budget))
+			{
+				settings.setHistoryBudget(budget);
+			}
+			break;
+		}
+		case 6:
+		{
+			int displayChoice;
+			cout << endl << "|| 1. Full frames, every cell of every generation";
+			cout << endl << "|| 2. Changed cells only, drawn in place on an ANSI terminal";
+			cout << endl << "|| 3. Density overview of the whole grid, for grids far larger than the terminal";
+			cout << endl << "|| Select a display: ";
+			cin >> displayChoice;
+			if (displayChoice == 1)
+			{
+				settings.setDisplay(DisplayType::FullFrames);
+			}
+			else if (displayChoice == 2)
+			{
+				int top;
+				int left;
+				cout << endl << "Enter the first row to show: ";
+				cin >> top;
+				cout << endl << "Enter the first column to show: ";
+				cin >> left;
+				if (cin.fail() || top < 0 || left < 0)
+				{
+					cout << endl << "Error: Invalid Input. Please try again.";
+					cin >> ClearAndIgnore();
+					break;
+				}
+				settings.setDisplay(DisplayType::ChangedCells);
+				settings.setView(top, left);
+			}
+			else if (displayChoice == 3)
+			{
+				settings.setDisplay(DisplayType::DensityOverview);
+			}
+			else
+			{
+				cout << endl << "Error: Invalid Option. Please try again.";
+				cin >> ClearAndIgnore();
+			}
+			break;
+		}
+		case 7:
+			menu_displayExportMenu(settings);
+			break;
+		case 8:
+			choosing = false;
+			break;
+		default:
+			cout << endl << "Error: Invalid Option. Please try again.";
+			cin >> ClearAndIgnore();
+			break;
+		}
+	}
+}
+
+// runs a soup search that keeps an object census on disk. A census that already exists under the name is carried on from where it stopped.
+void menu_runSoupCensus(const SimulationSettings& settings)
+{
+	string filename;
+	SoupCensus census;
+	cout << endl << "Enter file name for the census: ";
+	cin >> filename;
+
+	if (loadCensus(filename, census))
+	{
+		cout << endl << "Carrying on from soup " << census.getSoups() << " of " << filename << "_census.csv";
+	}
+	else
+	{
+		int rows;
+		int cols;
+		cout << endl << "Enter number of spaces on the X Axis: ";
+		cin >> rows;
+		if (!isValidInput(rows))
+		{
+			return;
+		}
+		cout << endl << "Enter number of spaces on the Y Axis: ";
+		cin >> cols;
+		if (!isValidInput(cols))
+		{
+			return;
+		}
+		int totalCells = cellInput();
+		random_device rd;
+		census = SoupCensus(rows, cols, totalCells, rd(), settings.getRule());
+	}
+
+	int totalSoups;
+	cout << endl << "Enter the total number of soups the census should hold: ";
+	cin >> totalSoups;
+	if (!isValidInput(totalSoups))
+	{
+		return;
+	}
+	runSoupCensus(census, static_cast<uint64_t>(totalSoups), [&](const SoupCensus& progress) { return saveCensus(filename, progress); });
+	displayCensus(census, 20);
+}
+
+// runs every soup of a sweep over grid sizes, cell counts and seeds, writing each result as it finishes. Runs already in the file are skipped,
+// so an interrupted sweep carries on where it stopped and a wider sweep only runs the new points.
+void menu_runParameterSweep(const SimulationSettings& settings)
+{
+	string filename;
+	RuleSpec rule = settings.getRule();
+	int patternChoice;
+	vector<SweepResult> results;
+	cout << endl << "Enter file name for the sweep: ";
+	cin >> filename;
+
+	if (loadSweepResults(filename, rule, patternChoice, results))
+	{
+		cout << endl << "Carrying on from " << results.size() << " finished runs of " << filename << "_sweep.csv with " << rule.toString();
+	}
+	else
+	{
+		patternChoice = menu_displayPatternMenu();
+	}
+
+	SweepRange rows;
+	SweepRange cols;
+	SweepRange cells;
+	int seeds;
+	if (!rangeInput("X Axis", rows) || !rangeInput("Y Axis", cols) || !rangeInput("number of alive cells", cells))
+	{
+		return;
+	}
+	cout << endl << "Enter the number of seeds for each point: ";
+	cin >> seeds;
+	if (!isValidInput(seeds))
+	{
+		return;
+	}
+
+	set<SweepPoint> finished;
+	for (const SweepResult& result : results)
+	{
+		finished.insert(result.point);
+	}
+	vector<SweepPoint> allPoints = sweepPoints(rows, cols, cells, seeds);
+	vector<SweepPoint> points;
+	for (const SweepPoint& point : allPoints)
+	{
+		if (finished.count(point) == 0)
+		{
+			points.push_back(point);
+		}
+	}
+
+	// Rewrites the finished runs first so a line cut short by an interruption is not left in the middle of the file.
+	if (!saveSweepResults(filename, rule, patternChoice, results))
+	{
+		return;
+	}
+	ofstream sweepSaveFile(filename + "_sweep.csv", ios::app);
+	size_t ran = 0;
+	const PatternSet& target = patternChoice == 1 ? getStillLifePatterns() : patternChoice == 2 ? getOscillatorPatterns() : getSpaceshipPatterns();
+	runSweep(points, target, patternChoice == 3, rule, [&](const SweepResult& result)
+	{
+		appendSweepResult(sweepSaveFile, result);
+		if (++ran % 10000 == 0)
+		{
+			cout << endl << "Ran " << ran << " of " << points.size() << " runs";
+		}
+	});
+	cout << endl << "Ran " << ran << " runs, skipped " << allPoints.size() - points.size() << " already finished. Results are in " << filename << "_sweep.csv";
 }
 
-// runs the lowest possible ern function
-void menu_findLowestPossibleERN()
+// runs the lowest possible ern function on grids up to a size chosen by the user
+void menu_findLowestPossibleERN(const SimulationSettings& settings)
 {
-	displayLowestPossibleERN();
+	int maxSide;
+	cout << endl << "Enter the largest grid side to search. Up to 6 takes about a second, but 7 runs up to 2^49 soups if a pattern is not found sooner (max "
+		<< MAX_SOUP_SIDE << "): ";
+	cin >> maxSide;
+	if (!isValidInput(maxSide) || maxSide > MAX_SOUP_SIDE)
+	{
+		cout << endl << "Error: Invalid Input. Please try again.";
+		cin >> ClearAndIgnore();
+		return;
+	}
+	displayLowestPossibleERN(maxSide, settings.getRule());
 }
 
 // displays the save menu options
 template <typename T>
-void menu_displaySaveMenu(Grid<T> &grid, unsigned int seed, int totalCells, int totalCycles)
+void menu_displaySaveMenu(GridView<T> grid, unsigned int seed, int totalCycles, int totalCells, const ReplayLog* log = nullptr, const RuleSpec& rule = RuleSpec(),
+	int scatterVersion = SCATTER_VERSION)
 {
 	bool saving = true;
 	int choice;
@@ -1606,7 +9901,8 @@ void menu_displaySaveMenu(Grid<T> &grid, unsigned int seed, int totalCells, int
 		cout << endl << "Would you like to save the final grid or save the parameters?";
 		cout << endl << "|| 1. Save Final Grid";
 		cout << endl << "|| 2. Save Parameters";
-		cout << endl << "|| 3. Don't Save";
+		cout << endl << "|| 3. Save Binary Snapshot";
+		cout << endl << "|| 4. Don't Save";
 		cout << endl << "Select an option: ";
 		cin >> choice;
 		switch (choice)
@@ -1616,10 +9912,14 @@ void menu_displaySaveMenu(Grid<T> &grid, unsigned int seed, int totalCells, int
 				saving = false;
 				break;
 			case 2:
-				saveParameters(grid, seed, totalCells, totalCycles);
+				saveParameters(grid, seed, totalCycles, totalCells, log, scatterVersion);
 				saving = false;
 				break;
 			case 3:
+				saveSnapshot(grid, rule);
+				saving = false;
+				break;
+			case 4:
 				saving = false;
 				break;
 			default:
@@ -1632,7 +9932,7 @@ void menu_displaySaveMenu(Grid<T> &grid, unsigned int seed, int totalCells, int
 
 // displays the save menu but can only be used on grids that have no params such as saved .txt 
 template <typename T>
-void menu_displaySaveMenuNoParams(Grid<T> grid)
+void menu_displaySaveMenuNoParams(GridView<T> grid, const RuleSpec& rule = RuleSpec())
 {
 	bool saving = true;
 	int choice;
@@ -1642,7 +9942,8 @@ void menu_displaySaveMenuNoParams(Grid<T> grid)
 	{
 		cout << endl << "Would you like to save the final grid?";
 		cout << endl << "|| 1. Save Final Grid";
-		cout << endl << "|| 2. Don't Save";
+		cout << endl << "|| 2. Save Binary Snapshot";
+		cout << endl << "|| 3. Don't Save";
 		cout << endl << "Select an option: ";
 		cin >> choice;
 		switch (choice)
@@ -1652,6 +9953,10 @@ void menu_displaySaveMenuNoParams(Grid<T> grid)
 			saving = false;
 			break;
 		case 2:
+			saveSnapshot(grid, rule);
+			saving = false;
+			break;
+		case 3:
 			saving = false;
 			break;
 		default:
@@ -1672,7 +9977,10 @@ int menu_displayOptionMenu()
 	cout << endl << "|| 3. Run experiment to find pattern";
 	cout << endl << "|| 4. Test Functions";
 	cout << endl << "|| 5. Calculate lowest possible efficiency resource number (ERN)";
-	cout << endl << "|| 6. Exit";
+	cout << endl << "|| 6. Simulation settings";
+	cout << endl << "|| 7. Run soup search with object census";
+	cout << endl << "|| 8. Run parameter sweep";
+	cout << endl << "|| 9. Exit";
 	cout << endl << "|| Select an option: ";
 
 	cin >> choice;
@@ -1688,6 +9996,7 @@ void menu_displayWelcomeMenu(Grid<T> &grid)
 	int choice;
 	bool running = true;
 	unsigned int seed = 0;
+	SimulationSettings settings;
 
 	cout << "|| Welcome to Ryan's version of John Conway's: Game of Life! ||";
 
@@ -1699,21 +10008,30 @@ void menu_displayWelcomeMenu(Grid<T> &grid)
 		switch (choice)
 		{
 			case 1:
-				menu_createNewSimulation(grid);
+				menu_createNewSimulation(grid, settings);
 				break;
 			case 2:
-				menu_loadFromStorage(grid);
+				menu_loadFromStorage(grid, settings);
 				break;
 			case 3:
-				menu_runExperiment(grid);
+				menu_runExperiment(grid, settings);
 				break;
 			case 4:
 				menu_runPatternTests(grid);
 				break;
 			case 5:
-				menu_findLowestPossibleERN();
+				menu_findLowestPossibleERN(settings);
 				break;
 			case 6:
+				menu_displaySettingsMenu(settings);
+				break;
+			case 7:
+				menu_runSoupCensus(settings);
+				break;
+			case 8:
+				menu_runParameterSweep(settings);
+				break;
+			case 9:
 				running = false; // Quit the loop;
 				break;
 			default:
@@ -1732,7 +10050,5 @@ int main()
 
 	menu_displayWelcomeMenu(grid);
 
-	cleanupGrid(grid); // Always clean up before exiting.
-
 	return 0;
 }
\ No newline at end of file